@@ -3,7 +3,7 @@ import arcade.gui
 import time
 import queue
 import threading
-from server_handler import connect_to_server, start_receive_thread, start_heartbeat_thread
+from server_handler import connect_to_server, start_receive_thread, start_heartbeat_thread, login_message
 from board import Board
 from stone import Stone
 
@@ -191,7 +191,7 @@ class GameView(arcade.View):
             new_socket = connect_to_server(self.server_ip, self.server_port)
             if new_socket is not None:
                 try:
-                    msg = f"REV CREATE {self.my_username}\n"
+                    msg = login_message(self.my_username)
                     new_socket.sendall(msg.encode('utf-8'))
                     
                     self.client_socket = new_socket
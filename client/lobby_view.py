@@ -2,7 +2,7 @@ import arcade
 import arcade.gui
 import queue
 import threading
-from server_handler import connect_to_server, start_receive_thread, start_heartbeat_thread
+from server_handler import connect_to_server, start_receive_thread, start_heartbeat_thread, login_message
 from lobby_list_view import LobbyListView
 
 GAME_PREFIX = "REV"
@@ -144,7 +144,7 @@ class LobbyView(arcade.View):
 
         try:
             print(f"[Main Thread] Sending CREATE for {self.username}...")
-            message = f"{GAME_PREFIX} CREATE {self.username}\n"
+            message = login_message(self.username)
             self.client_socket.sendall(message.encode('utf-8'))
         except Exception as e:
             print(f"Error sending login: {e}")
@@ -6,6 +6,16 @@ PORT = 10001
 HEARTBEAT_INTERVAL = 2.0  # Send heartbeat every 2 seconds
 TIMEOUT_LIMIT = 15.0       # Disconnect if no response for 15 seconds
 
+# Token of the last login (REV SESSION), needed to resume a paused game
+session_token = None
+
+
+def login_message(username):
+    """ REV CREATE line, with the session token of the last login if there is one """
+    if session_token:
+        return f"REV CREATE {username} {session_token}\n"
+    return f"REV CREATE {username}\n"
+
 
 class GameSocket:
     """
@@ -44,6 +54,7 @@ def start_receive_thread(client_socket, server_queue):
     Handles receiving data. Uses a buffer to fix split packets.
     Updates the 'last_response' timestamp on every valid message.
     """
+    global session_token
     buffer = ""
     bad_message_count = 0
     MAX_BAD_MESSAGES = 5
@@ -77,6 +88,11 @@ def start_receive_thread(client_socket, server_queue):
                         if "HEARTPOP" in message:
                             continue
 
+                        params = message.split()
+                        if len(params) == 3 and params[1] == "SESSION":
+                            session_token = params[2]
+                            continue
+
                         server_queue.put(message)
 
     except (ConnectionResetError, BrokenPipeError, ConnectionAbortedError):
@@ -0,0 +1,90 @@
+#pragma once
+#include "../include/messageParser.h"
+#include "../include/lineBuffer.h"
+#include <string>
+#include <string_view>
+
+/**
+ * Compact binary protocol, opted into with "REV CREATE <name> BIN".
+ *
+ * The CREATE line itself is text. Every later message, in both directions,
+ * is a frame: [u16 length][u8 opcode][payload], the length counting the
+ * opcode and the payload. Numbers are little-endian, lobby ids are u32.
+ * Boards travel as bitboards of (size * size + 7) / 8 bytes, bit i being
+ * square i (row-major, like the STATE digits).
+ *
+ * The handler dispatches both protocols the same way (ClientCommand), the
+ * server side writes text messages and sendMessage encodes them for binary
+ * clients (encodeBinaryMessage). The boards sent after every move are
+ * built as frames straight from the game state (encodeStateFrame,
+ * encodeDeltaFrame), without a text form.
+ */
+
+// Word after the user name in CREATE that switches to binary frames
+#define BINARY_PROTOCOL_FLAG "BIN"
+// Word after the user name in CREATE that asks for DELTA instead of STATE after moves
+#define DELTA_UPDATES_FLAG "DELTA"
+
+// Client -> server
+#define OP_HEARTBEAT   0x01
+#define OP_JOIN        0x03   // u32 lobby [u8 board size]
+#define OP_BOT         0x04   // [u32 lobby]
+#define OP_EXIT        0x05   // u32 lobby
+#define OP_MOVE        0x06   // u8 x, u8 y, u32 lobby
+#define OP_REMATCH     0x07   // u32 lobby
+#define OP_RESYNC      0x08   // u32 lobby
+#define OP_QUEUE       0x09   // [u8 board size [u16 rating]]
+#define OP_WATCH       0x0A   // u32 lobby
+
+// Server -> client
+#define OP_HEARTPOP    0x81
+#define OP_LOBBY       0x82   // u32 lobby count
+#define OP_CONNECT     0x83   // u8 result (1, 2 = seat, 3 = full)
+#define OP_START       0x84   // u8 status, u32 lobby, u8 board size, u8 length + player 1, u8 length + player 2
+#define OP_STATE       0x85   // bitboards player 1, player 2, legal moves, u8 score 1, u8 score 2, u8 status, u32 version
+#define OP_PASS        0x86
+#define OP_END         0x87   // u8 winner (3 = draw)
+#define OP_DISCONNECT  0x88   // u8 seat
+#define OP_RECONNECT   0x89
+#define OP_PREDICT     0x8A   // u8 winner, i8 margin
+#define OP_DELTA       0x8B   // u32 version, u8 square, u8 count + flipped squares, u8 count + legal moves, u8 score 1, u8 score 2, u8 status
+#define OP_TEXT        0xFF   // Any other message: its text line without '\n'
+
+/**
+ * @brief Decodes a client frame (without its length prefix).
+ * * Arguments of a wrong size are reported as non-numeric, like a
+ * malformed text argument.
+ * @return false for an empty frame or an unknown opcode.
+ */
+bool decodeBinaryFrame(std::string_view frame, ClientCommand& command);
+
+/**
+ * @brief Encodes one text message of the server ("REV ...\n") as a frame.
+ * * Messages without an opcode of their own go out as OP_TEXT.
+ */
+std::string encodeBinaryMessage(const std::string& message);
+
+/**
+ * @brief OP_STATE frame of a board, the same as encoding its STATE line.
+ * * Bit i of the bitboards is square i of the board.
+ * @param cells Squares of the board (size * size).
+ */
+std::string encodeStateFrame(unsigned __int128 player1, unsigned __int128 player2, unsigned __int128 hints, int cells,
+                             int score1, int score2, int status, unsigned long version);
+
+/**
+ * @brief OP_DELTA frame of the last move, the same as encoding its DELTA line.
+ * @param square The square played, -1 before the first move.
+ */
+std::string encodeDeltaFrame(unsigned long version, int square, unsigned __int128 flipped, unsigned __int128 hints,
+                             int score1, int score2, int status);
+
+/**
+ * @brief Marks a socket as speaking the binary protocol (or text again).
+ */
+void setBinaryClient(int clientSocket, bool binary);
+
+/**
+ * @brief True if messages to this socket have to be encoded as frames.
+ */
+bool isBinaryClient(int clientSocket);
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+// Board sizes offered on JOIN, the computer, the book and SIMD are 8x8 only
+#define BOARD_SIZE_SMALL 6
+#define BOARD_SIZE_STANDARD 8
+#define BOARD_SIZE_LARGE 10
+
+/**
+ * @brief Compile-time description of an N x N board.
+ * * Square (x, y) maps to bit y * N + x. Boards up to 8x8 fit in a
+ * uint64_t, larger ones use unsigned __int128. Every mask is a constexpr,
+ * so the kernels below are specialized and constant folded per size.
+ */
+template <int N>
+struct BoardGeometry {
+      static_assert(N >= 4 && N <= 10 && N % 2 == 0, "Board size must be even, 4 to 10");
+
+      typedef typename std::conditional<(N * N <= 64), uint64_t, unsigned __int128>::type Bits;
+
+      static constexpr int SIZE = N;
+      static constexpr int CELLS = N * N;
+
+      static constexpr Bits ALL = (CELLS == 8 * (int)sizeof(Bits)) ? ~(Bits)0 : (((Bits)1 << CELLS) - 1);
+
+      static constexpr Bits columnMask(int column) {
+            Bits mask = 0;
+            for (int y = 0; y < N; y++) mask |= (Bits)1 << (y * N + column);
+            return mask;
+      }
+
+      // Opponent stones that may be "walked over" horizontally/diagonally,
+      // the first and last columns are cut so a shift never wraps a row.
+      static constexpr Bits INNER_COLUMNS = ALL & ~columnMask(0) & ~columnMask(N - 1);
+
+      // Shift distances for the 4 axes: horizontal, vertical, both diagonals
+      static constexpr int AXIS_SHIFTS[4] = {1, N, N - 1, N + 1};
+
+      static constexpr Bits axisOpponentMask(int shift, Bits opp) {
+            return (shift == N) ? opp : (opp & INNER_COLUMNS);
+      }
+};
+
+inline int bitCount(uint64_t bits) {
+      return __builtin_popcountll(bits);
+}
+
+inline int bitCount(unsigned __int128 bits) {
+      return __builtin_popcountll((uint64_t)bits) + __builtin_popcountll((uint64_t)(bits >> 64));
+}
+
+// Index of the lowest set bit, bits must not be 0
+inline int lowestSquare(uint64_t bits) {
+      return __builtin_ctzll(bits);
+}
+
+inline int lowestSquare(unsigned __int128 bits) {
+      uint64_t low = (uint64_t)bits;
+      return low ? __builtin_ctzll(low) : 64 + __builtin_ctzll((uint64_t)(bits >> 64));
+}
+
+/**
+ * @brief Every square where `own` can legally play (shift/mask fills).
+ */
+template <int N>
+inline typename BoardGeometry<N>::Bits computeMoveMask(typename BoardGeometry<N>::Bits own, typename BoardGeometry<N>::Bits opp) {
+      typedef BoardGeometry<N> G;
+      typedef typename G::Bits Bits;
+
+      Bits empty = ~(own | opp) & G::ALL;
+      Bits moves = 0;
+
+      for (int i = 0; i < 4; i++) {
+            int shift = G::AXIS_SHIFTS[i];
+            Bits mask = G::axisOpponentMask(shift, opp);
+
+            // Fill over opponent stones starting next to our own stones.
+            // N - 2 is the longest possible line of opponent stones.
+            Bits left = mask & (own << shift);
+            Bits right = mask & (own >> shift);
+            for (int step = 0; step < N - 3; step++) {
+                  left |= mask & (left << shift);
+                  right |= mask & (right >> shift);
+            }
+
+            moves |= (left << shift) | (right >> shift);
+      }
+
+      return moves & empty;
+}
+
+/**
+ * @brief The stones flipped when `own` plays on `square`, 0 if illegal.
+ */
+template <int N>
+inline typename BoardGeometry<N>::Bits computeFlipMask(int square, typename BoardGeometry<N>::Bits own, typename BoardGeometry<N>::Bits opp) {
+      typedef BoardGeometry<N> G;
+      typedef typename G::Bits Bits;
+
+      Bits placed = (Bits)1 << square;
+      if ((own | opp) & placed) return 0;
+
+      Bits flips = 0;
+
+      for (int i = 0; i < 4; i++) {
+            int shift = G::AXIS_SHIFTS[i];
+            Bits mask = G::axisOpponentMask(shift, opp);
+
+            // Walk the ray while it covers opponent stones, keep it only
+            // when it is closed by one of our own stones (sandwich).
+            Bits line = 0;
+            Bits cursor = placed << shift;
+            while (cursor & mask) {
+                  line |= cursor;
+                  cursor <<= shift;
+            }
+            if (cursor & own) flips |= line;
+
+            line = 0;
+            cursor = placed >> shift;
+            while (cursor & mask) {
+                  line |= cursor;
+                  cursor >>= shift;
+            }
+            if (cursor & own) flips |= line;
+      }
+
+      return flips;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/**
+ * @brief Starts the work-stealing pool that plays the computer seats.
+ * * All searches share one lock-free transposition table. A bot move runs
+ * as one pool task and, when pool threads are idle, spawns Lazy SMP helper
+ * tasks searching the same position. Searches run without holding
+ * the lobby lock, the board is copied before and the move is applied
+ * through handleMoving afterwards. Score predictions get a thread of
+ * their own (requestScorePrediction).
+ * @param workerCount Pool size, the global cap on search threads (at least 1).
+ */
+void startBotService(int workerCount);
+
+/**
+ * @brief Queues a move request for the computer seat of a lobby.
+ * * Returns immediately. Starts once the caller's MessageBatch is written,
+ * so the move never overtakes the messages before it. The worker
+ * re-checks that it is still the computer's turn and drops the request
+ * if the game moved on meanwhile.
+ * @param lobbyId The ID of the lobby where the computer has to move.
+ */
+void requestBotMove(int lobbyId);
+
+/**
+ * @brief Queues an exact solve of a lobby's position for its players.
+ * * Predictions run one at a time on a thread of their own, so they never
+ * hold up bot moves. A lobby has at most one pending request, a newer one
+ * replaces it and aborts a solve of an older position of the lobby. The
+ * solve is skipped if the game moved on before it started, and "REV
+ * PREDICT" is only sent if it did not move on while solving. Queued once
+ * the caller's MessageBatch is written, after the move it refers to.
+ * @param lobbyId The ID of the lobby whose outcome is predicted.
+ * @param version State version of the position to solve (Lobby::getStateVersion).
+ */
+void requestScorePrediction(int lobbyId, unsigned long version);
@@ -0,0 +1,33 @@
+#pragma once
+#include "../include/engine.h"
+#include <atomic>
+#include <cstdint>
+
+struct EndgameResult {
+      bool solved;        // false when the time budget or stop flag hit first
+      int square;         // Best move (y * 8 + x), -1 when the side to move must pass
+      int score;          // Final disc difference (side to move minus opponent)
+      uint64_t nodes;
+      double seconds;
+};
+
+/**
+ * @brief Counts stones of `color` that can never be flipped again.
+ * * Conservative estimate: a stone is stable when on each of the 4 axes the
+ * line is full, it touches the border or a stable stone of its own color.
+ */
+uint64_t getStableDiscs(uint64_t color, uint64_t occupied);
+
+/**
+ * @brief Solves a position exactly (perfect play to the end of the game).
+ * * Moves are ordered by quadrant parity (and fastest-first while more
+ * than 5 squares are empty), the last 4 empties are solved from a square
+ * list without move generation, and stable opponent stones bound the
+ * best reachable score (stability cutoff). Passes follow resolveNextPlayer.
+ * @param board Position to solve, hints are not required.
+ * @param player Side to move (1 or 2).
+ * @param timeBudgetMs Gives up (solved = false) after this many ms.
+ * @param stop Optional abort flag.
+ * @param tt Table for the exact scores, must not be shared with the midgame search.
+ */
+EndgameResult solveEndgame(const Board& board, int player, int timeBudgetMs, std::atomic<bool> *stop, TranspositionTable& tt);
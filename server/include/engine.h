@@ -0,0 +1,89 @@
+#pragma once
+#include "../include/gameLogic.h"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// Terminal positions score beyond any evaluation
+#define SCORE_WIN 10000
+#define SCORE_INFINITY 32000
+
+#define TT_FLAG_EXACT 0
+#define TT_FLAG_LOWER 1
+#define TT_FLAG_UPPER 2
+
+struct TTEntry {
+      uint64_t key;
+      int16_t score;
+      int8_t depth;
+      uint8_t flag;
+      int8_t bestMove;
+};
+
+/**
+ * @brief Fixed-size, direct mapped transposition table, shared lock-free.
+ * * Size is a power of two chosen at construction and never changes, a
+ * colliding store replaces the old entry unless it is deeper and valid.
+ * * Any number of search threads may probe and store concurrently. Each
+ * slot keeps the packed data and key ^ data in two relaxed atomics; a slot
+ * torn by two racing writers no longer matches its key and reads as a miss.
+ */
+class TranspositionTable {
+public:
+      explicit TranspositionTable(int sizeLog2);
+
+      void clear();
+      bool probe(uint64_t key, TTEntry& entry) const;
+      void store(uint64_t key, int depth, int score, int flag, int bestMove);
+
+private:
+      struct Slot {
+            std::atomic<uint64_t> check;   // key ^ data
+            std::atomic<uint64_t> data;
+      };
+
+      std::unique_ptr<Slot[]> slots;
+      size_t mask;
+};
+
+struct SearchLimits {
+      int timeBudgetMs;          // Wall clock budget for the whole move
+      int maxDepth;              // Upper bound for iterative deepening
+      int startDepth;            // First iteration (Lazy SMP helpers start deeper)
+      std::atomic<bool> *stop;   // Shared abort flag, may be nullptr
+      int firstMove;             // Searched first if legal (cached best move), -1 for none
+};
+
+struct SearchResult {
+      int square;         // Best move (y * 8 + x), -1 when there is no legal move
+      int score;          // From the point of view of the side to move
+      int depth;          // Last fully completed iteration
+      uint64_t nodes;
+      double seconds;
+};
+
+/**
+ * @brief Static evaluation from the point of view of `own`.
+ * * Square weights plus mobility, bounded well below SCORE_WIN.
+ */
+int evaluatePosition(uint64_t own, uint64_t opp);
+
+/**
+ * @brief Hash of a position (own to move), used as transposition table key.
+ */
+uint64_t hashPosition(uint64_t own, uint64_t opp);
+
+/**
+ * @brief Picks a move with iterative-deepening negamax alpha-beta.
+ * * Moves are ordered by the transposition table move, then by opponent
+ * mobility and square weight. The search stops when the time budget runs
+ * out (or limits.stop is raised) and returns the best move of the last
+ * completed iteration.
+ * * Lazy SMP: several calls may search the same position at once with one
+ * shared table, helpers start at a different depth so they fill the
+ * table ahead of the main search.
+ * @param board Position to search, hints are not required.
+ * @param player Side to move (1 or 2).
+ */
+SearchResult searchBestMove(const Board& board, int player, const SearchLimits& limits, TranspositionTable& tt);
@@ -1,13 +1,133 @@
 #pragma once
+#include "../include/boardGeometry.h"
+#include <cstdint>
+#include <string>
 
-int getScoreForPlayer(int userID, int board[][8]);
+#define CELL_EMPTY 0
+#define CELL_PLAYER_ONE 1
+#define CELL_PLAYER_TWO 2
+#define CELL_HINT 3
 
-int getWinnerResults(int board[][8]);
+// Row-major 8x8 start positions, same digits as the STATE message
+#define STANDARD_START_STATE "0000000000000000000000000001200000021000000000000000000000000000"
+#define CUSTOM_START_STATE "3123000022212033221122133111112011222122111112112111111111111123"
 
-bool getAvaiableMoves(int board[][8], int currentPlayer);
+class PositionCache;
 
-bool processMove(int x, int y, int board[][8], int player, bool apply);
+/**
+ * @brief Bitboard representation of an N x N Reversi position.
+ * * Square (x, y) maps to bit y * N + x. discs[0] holds the stones of
+ * Player 1, discs[1] the stones of Player 2. hints caches the legal moves
+ * of the side to move (what used to be the "3" markers on the int board).
+ * * scores and empties are kept up to date by processMove from the flip
+ * set of each move, so reading them never rescans the board.
+ * * hash is the Zobrist hash of the discs, updated the same way (placed
+ * stone plus flips). getPositionKey adds the side to move.
+ * * The rule functions below are templates instantiated for 6, 8 and 10;
+ * 8x8 uses the runtime-dispatched SIMD kernels and the position cache.
+ */
+template <int N>
+struct BasicBoard {
+      typedef typename BoardGeometry<N>::Bits Bits;
 
-bool validateMove(int x, int y, int board[][8], int currentPlayer);
+      Bits discs[2];
+      Bits hints;
+      uint64_t hash;
+      int scores[2];
+      int empties;
+};
 
+// The standard board, used by the engine, the book and the cache
+typedef BasicBoard<8> Board;
 
+template <int N>
+int getScoreForPlayer(int userID, const BasicBoard<N>& board);
+
+template <int N>
+int getWinnerResults(const BasicBoard<N>& board);
+
+/**
+ * @brief Sets board.hints to the legal moves of `currentPlayer`.
+ * @param cache Optional shared cache (8x8 only), the masks are looked up there first.
+ * @return false if the player has no legal move.
+ */
+template <int N>
+bool getAvaiableMoves(BasicBoard<N>& board, int currentPlayer, PositionCache *cache = nullptr);
+
+/**
+ * @brief Validates (and with apply = true plays) a move for `player`.
+ * * Applying updates the discs, scores and empties, hints are left for
+ * getAvaiableMoves/resolveNextPlayer.
+ * @param flipped Optional output, receives the flipped stones.
+ */
+template <int N>
+bool processMove(int x, int y, BasicBoard<N>& board, int player, bool apply, typename BoardGeometry<N>::Bits *flipped = nullptr);
+
+template <int N>
+bool validateMove(int x, int y, const BasicBoard<N>& board, int currentPlayer);
+
+/**
+ * @brief Decides who plays after `player` has moved.
+ * * Computes the hints for the opponent; when the opponent has no move
+ * the turn passes back and the hints are computed for `player` instead.
+ * A full board ends the game without generating any moves.
+ * @param cache Optional shared cache for the legal move masks (8x8 only).
+ * @return The next player (1 or 2), or 0 when neither side can move.
+ */
+template <int N>
+int resolveNextPlayer(BasicBoard<N>& board, int player, PositionCache *cache = nullptr);
+
+/**
+ * @brief Zobrist hash of a position computed from scratch.
+ * * Same value as the incremental Board::hash.
+ */
+uint64_t computeZobristHash(uint64_t discs1, uint64_t discs2);
+
+/**
+ * @brief Key of a position with `player` (1 or 2) to move.
+ */
+uint64_t getPositionKey(const Board& board, int player);
+
+/**
+ * @brief Computes every square where `own` can legally play.
+ * * All 8 directions are resolved with shift/mask fills, no per-cell walking.
+ * Dispatches to the kernel picked by initMoveKernels (see simdMoves.h).
+ * @return Bitmask of legal moves.
+ */
+uint64_t getMoveMask(uint64_t own, uint64_t opp);
+
+/**
+ * @brief Computes the stones flipped when `own` plays on `square`.
+ * @param square Bit index (y * 8 + x) of the placed stone.
+ * @return Bitmask of flipped stones, 0 if the move is illegal.
+ */
+uint64_t getFlipMask(int square, uint64_t own, uint64_t opp);
+
+// Portable kernels, reference for the SIMD self-check
+uint64_t getMoveMaskScalar(uint64_t own, uint64_t opp);
+
+uint64_t getFlipMaskScalar(int square, uint64_t own, uint64_t opp);
+
+/**
+ * @brief Returns the cell value (CELL_EMPTY, CELL_PLAYER_ONE, CELL_PLAYER_TWO, CELL_HINT).
+ */
+template <int N>
+int getCell(const BasicBoard<N>& board, int x, int y);
+
+/**
+ * @brief Places a stone (or clears the cell with CELL_EMPTY).
+ */
+template <int N>
+void setCell(BasicBoard<N>& board, int x, int y, int value);
+
+/**
+ * @brief Loads an N * N character row-major state string ("0123" digits).
+ * * Hint digits are treated as empty cells, hints are not recomputed.
+ */
+template <int N>
+void loadBoard(BasicBoard<N>& board, const std::string& state);
+
+/**
+ * @brief The 4 center stones start position of a size x size board.
+ */
+std::string getStandardStartState(int size);
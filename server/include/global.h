@@ -2,14 +2,42 @@
 #include <vector>
 #include <mutex>
 #include "../include/lobby.h"
+#include "../include/positionCache.h"
+#include "../include/lobbyPool.h"
 
 #define PORT 10001
-#define LOBBY_COUNT 5
 #define PREFIX_GAME "REV"
 #define PAUSE_STATUS 3
 #define ENDED_STATUS 0
 
-extern std::vector<Lobby> lobbies;
+// Clients silent for longer than this are disconnected (HEARTBEAT keeps them alive)
+#define CLIENT_TIMEOUT_SEC 8
+
+// Network I/O model (--io=threads|epoll|uring)
+enum IoMode {
+    IO_THREADS,  // One blocking thread per client
+    IO_EPOLL,    // One edge-triggered epoll reactor for every client
+    IO_URING     // One io_uring reactor, falls back to epoll when unavailable
+};
+
+// Runtime settings, defaults can be overridden on the command line (main.cpp)
+struct ServerConfig {
+    int botMoveTimeMs;   // Search budget of the computer opponent per move
+    int botThreads;      // Global cap on search threads (bot moves + their helpers)
+    int smpHelpers;      // Extra Lazy SMP threads per bot move, taken only when idle
+    int endgameEmpties;  // Positions with at most this many empties are solved exactly
+    std::string bookPath;     // Opening book used by the computer ("" = none)
+    std::string gamesPath;    // Finished games are appended here ("" = not recorded)
+    int cacheEntries;    // Size of the shared position cache
+    IoMode ioMode;       // How client sockets are served
+    int reactorCount;    // Epoll reactor shards, each with its own listener, core and lobbies
+    int reconnectGraceSec;    // A paused game is forfeited if the player is not back by then (0 = wait forever)
+};
+
+extern ServerConfig serverConfig;
+
+// Legal moves, bot evaluations and solved results shared by all lobbies
+extern PositionCache *positionCache;
+
 extern std::vector<int> clientSockets;
-extern std::mutex clients_mutex;
-extern std::mutex lobbies_mutex;
\ No newline at end of file
+extern std::mutex clients_mutex;
\ No newline at end of file
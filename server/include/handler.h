@@ -1,36 +1,99 @@
 #pragma once
 #include "../include/player.h"
 #include "../include/lobby.h"
+#include "../include/lobbyPool.h"
 #include <cstring>
+#include <string_view>
 #include <vector>
 
-/**
- * @brief Parse message to an array of strings, made for
- * argument counting
- * @return Array of params
- */
-std::vector<std::string> splitMessage(const std::string &s);
-
 /**
  * @brief Parses and routes an incoming raw message.
  * * Decodes the message string (e.g., "REV MOVE 3 4 0") and calls
  * the appropriate specific handler (handleMoving, handleLobbyJoin, etc.).
  * * @param clientSocket The socket of the client sending the message.
- * @param message The raw C-string message received from the TCP buffer.
+ * @param message One received line without its '\n', a view into the receive buffer.
  * @param player Reference to the Player object associated with this socket.
  */
-void handleMessage(int clientSocket, const char* message, Player& player);
+void handleMessage(int clientSocket, std::string_view message, Player& player);
+
+/**
+ * @brief Picks the reactor shard that has to handle a message (--reactors=N).
+ * * JOIN/BOT/WATCH with a lobby id go to the lobby's owner, as does a CREATE whose
+ * name holds a paused seat (playerPool.h). BOT without an id is passed on to the
+ * next shard until one has a free lobby, or every shard was asked. QUEUE
+ * goes to a shard where a partner is waiting (matchQueue.h). Lobby
+ * commands for a lobby of another shard are rejected.
+ * @param message The raw message line.
+ * @param player The sender's Player.
+ * @param hops Shards the message has already been passed through.
+ * @return SHARD_LOCAL, SHARD_REJECT or the index of the target shard.
+ */
+int selectMessageShard(std::string_view message, const Player& player, int hops);
 
 /**
  * @brief Logic for a player attempting to join a specific lobby.
  * * Checks if the lobby is full, assigns the player to a slot (P1/P2),
  * and sends the corresponding connection info back to the client.
  * * @param clientSocket The socket of the joining player.
- * @param lobbyId The ID of the target lobby (0-indexed).
+ * @param lobbyId The ID of the target lobby, created on demand (isOpenableLobbyId).
+ * @param player Reference to the Player object.
+ * @param boardSize Board size (6, 8 or 10). Sets the size of an empty lobby,
+ * otherwise it has to match the size the first player picked.
+ * @return 1 if joined as P1, 2 if joined as P2, 3 if full or another size, -1 on error.
+ */
+int handleLobbyJoin(int clientSocket, int lobbyId, Player& player, int boardSize = BOARD_SIZE_STANDARD);
+
+/**
+ * @brief Seats a player against the computer.
+ * * Takes the given lobby (or the lowest idle one of this shard when lobbyId
+ * is -1, created on demand),
+ * puts the player in as P1 and the computer as P2.
+ * Sends "REV CONNECT 1" on success, "REV CONNECT 3" when no lobby is free.
+ * * @param clientSocket The socket of the joining player.
+ * @param lobbyId The ID of the target lobby, -1 for any free lobby.
+ * @param player Reference to the Player object.
+ * @return The ID of the joined lobby, -1 if none was free.
+ */
+int handleBotJoin(int clientSocket, int lobbyId, Player& player);
+
+/**
+ * @brief Adds a client in the menu to the spectators of a lobby.
+ * * Sends "REV SPECTATE" with the players and the STATE of the board.
+ * From then on the spectator gets the board after every move (with
+ * PASS/END), a new SPECTATE when a game starts and END on a forfeit, each
+ * serialized once for all spectators (broadcastMessage). A spectator that
+ * is behind skips to the newest board.
+ * * @param clientSocket The socket of the spectator.
+ * @param lobbyId The ID of the lobby, created on demand (isOpenableLobbyId).
  * @param player Reference to the Player object.
- * @return 1 if joined as P1, 2 if joined as P2, 3 if full, -1 on error.
+ * @return 0 on success, -1 on error.
  */
-int handleLobbyJoin(int clientSocket, int lobbyId, Player& player);
+int handleWatch(int clientSocket, int lobbyId, Player& player);
+
+/**
+ * @brief Removes a spectator from the lobby it watches (EXIT or disconnect).
+ * @return 0 on success, -1 if it was not watching.
+ */
+int handleStopWatching(int clientSocket, Player& player);
+
+/**
+ * @brief Seats two players paired by the matchmaking queue in a fresh lobby.
+ * * Takes the lowest idle lobby of this shard (created on demand), sets its
+ * board size and moves both players to PLAYING. Called by the queue with
+ * its lock held, nothing is sent yet.
+ * * @param first The player who waited longer, seated as P1.
+ * @param second Seated as P2.
+ * @param boardSize Board size (6, 8 or 10).
+ * @return The ID of the lobby, -1 if none was free.
+ */
+int seatMatchedPlayers(Player& first, Player& second, int boardSize);
+
+/**
+ * @brief Starts the game of a pair seated by seatMatchedPlayers.
+ * * Sends "REV CONNECT 1" and "REV CONNECT 2", then the START messages.
+ * * @param lobbyId The ID of the lobby returned by seatMatchedPlayers.
+ */
+void startMatchedGame(int lobbyId);
 
 /**
  * @brief Logic for a player leaving a lobby.
@@ -48,18 +111,20 @@ int handleLobbyExit(int clientSocket, int lobbyId);
  * the new state to both players. also checks for Game Over or Pass conditions.
  * * @param x Column index of the move (0-7).
  * @param y Row index of the move (0-7).
- * @param clientSocket The socket of the player making the move.
+ * If the computer is to move next, its search is queued (see bot.h).
+ * * @param clientSocket The socket of the player making the move (BOT_SOCKET for the computer).
  * @param lobbyId The ID of the lobby where the game is happening.
+ * @param expectedVersion Refuse the move unless the lobby state version matches (-1 = no check).
  * @return 0 on success, -1 on invalid move/error.
  */
-int handleMoving(int x, int y, int clientSocket, int lobbyId);
+int handleMoving(int x, int y, int clientSocket, int lobbyId, long expectedVersion = -1);
 
 /**
  * @brief Logic for restoring a player's session after a disconnect.
- * * Re-associates the new socket with the old player slot in the lobby
- * and syncs the game state so the match can resume.
+ * * The new connection's Player already took the old slot over
+ * (Lobby::reconnectUser), this syncs the game state so the match can resume.
  * * @param clientSocket The new socket descriptor.
- * @param player Reference to the new Player object.
+ * @param player Reference to the new Player object, now seated.
  * @param lobby Reference to the lobby the user is rejoining.
  * @param connectedUser The player number (1 or 2) they are reconnecting as.
  * @return 0 on success, -1 on error.
@@ -68,6 +133,26 @@ int handleReconecting(int clientSocket, Player& player, Lobby& lobby, int connec
 
 int handleRematch(int clientSocket, int lobbyId);
 
+/**
+ * @brief Sends the full board to a seated player whose DELTA versions have a gap.
+ * * Answers "REV RESYNC <lobbyId>" with "REV STATE", whose last field is
+ * the state version the next DELTA builds on.
+ * @param clientSocket The socket of the player asking.
+ * @param lobbyId The ID of the player's lobby.
+ * @return 0 on success, -1 if the player is not seated there.
+ */
+int handleResync(int clientSocket, int lobbyId);
+
+/**
+ * @brief Forfeits a paused game whose player did not come back in time.
+ * * Called on the lobby's shard when the reconnect grace period ends (see
+ * reconnectGrace.h). The opponent still connected gets "REV END" with
+ * themselves as the winner. Nothing happens if the game was resumed or
+ * the lobby was released since.
+ * @param lobby Handle of the paused lobby, taken when the game was paused.
+ */
+void handleReconnectTimeout(LobbyHandle lobby);
+
 /**
  * @brief Starts the match in a specific lobby.
  * * Sets the lobby status to Active and sends the "REV START" command
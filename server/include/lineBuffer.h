@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <sys/uio.h>
+
+// Longest accepted message, '\n' included. A client sending more without a
+// line break is disconnected instead of growing its buffer.
+#define MAX_FRAME_SIZE 1024
+// Ring capacity, twice the frame limit so a read always has room (power of two)
+#define LINE_BUFFER_CAPACITY (2 * MAX_FRAME_SIZE)
+// Binary frames start with their length (u16, little-endian), see binaryProtocol.h
+#define FRAME_LENGTH_SIZE 2
+
+/**
+ * @brief Fixed-size receive ring that splits the byte stream into lines.
+ * * Sockets read straight into the free part of the ring (writeVectors +
+ * commit), lines are handed out as string_views into the ring: nothing is
+ * allocated, erased or moved per message. Only a line wrapping around the
+ * end of the ring is copied once, into a frame-sized scratch buffer.
+ * * Usage: fill, then `while (frontLine(line)) { handle(line); dropLine(); }`,
+ * then check overflowed().
+ * * Clients of the binary protocol send length-prefixed frames instead of
+ * lines, frontLine then hands out one frame without its length. The
+ * framing can change from one message to the next.
+ */
+class LineBuffer {
+public:
+    LineBuffer();
+
+    /**
+     * @brief Free space for the next read, in ring order.
+     * @param vectors Receives one or two segments (readv style).
+     * @return Number of segments, 0 when the ring is full.
+     */
+    int writeVectors(struct iovec vectors[2]);
+
+    /**
+     * @brief Makes `count` bytes written through writeVectors readable.
+     */
+    void commit(size_t count);
+
+    /**
+     * @brief Copies received bytes in, as many as fit.
+     * @return Bytes taken, the rest has to be appended after the pending lines are handled.
+     */
+    size_t append(const char* data, size_t length);
+
+    /**
+     * @brief Oldest complete line, without its '\n'.
+     * * The view stays valid until dropLine or the next write into the buffer.
+     * @param binaryFrames Read a length-prefixed frame instead of a line.
+     * @return false if no complete line is buffered.
+     */
+    bool frontLine(std::string_view& line, bool binaryFrames = false);
+
+    /**
+     * @brief Removes the line returned by frontLine.
+     */
+    void dropLine();
+
+    /**
+     * @brief True once a line or frame longer than MAX_FRAME_SIZE was received.
+     */
+    bool overflowed() const { return overflow; }
+
+    bool empty() const { return head == tail; }
+
+private:
+    // Monotonic positions, the ring index is position % LINE_BUFFER_CAPACITY
+    size_t head;
+    size_t tail;
+    size_t scanned;      // Bytes after head already searched for '\n'
+    size_t lineLength;   // Length of the line returned by frontLine, or npos
+    size_t framing;      // Bytes around that line: its '\n' or the frame length
+    bool overflow;
+    char storage[LINE_BUFFER_CAPACITY];
+    char frame[MAX_FRAME_SIZE];   // Wrapped lines are joined here
+
+    std::string_view view(size_t start, size_t length);
+    bool frontFrame(std::string_view& line);
+};
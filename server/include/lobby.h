@@ -1,13 +1,45 @@
 #pragma once
 #include "../include/player.h"
+#include "../include/gameLogic.h"
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <variant>
+#include <cstdint>
 
+/**
+ * @brief Board of one lobby with its STATE digits, for one board size.
+ */
+template <int N>
+struct LobbyBoard {
+      static constexpr int SIZE = N;
+
+      BasicBoard<N> board;
+
+      // Row-major digits of the board (STATE message), patched per move
+      std::string cells;
+      void refreshCells(typename BoardGeometry<N>::Bits changed);
+
+      // Last move (DELTA message), -1 before the first move
+      int lastSquare = -1;
+      typename BoardGeometry<N>::Bits lastFlipped = 0;
+};
+
+// Every size a lobby can be played on, picked by the first player's JOIN
+typedef std::variant<LobbyBoard<BOARD_SIZE_STANDARD>, LobbyBoard<BOARD_SIZE_SMALL>, LobbyBoard<BOARD_SIZE_LARGE>> LobbyBoardState;
 
 class Lobby {
 public:
       Lobby(int id);
       ~Lobby() = default;
 
+      Lobby(const Lobby&) = delete;
+      Lobby& operator=(const Lobby&) = delete;
+
+      // Guards this lobby only, taken through LobbyLock (shard.h)
+      std::mutex mutex;
+
       Player* player1;
       Player* player2;
 
@@ -30,16 +62,75 @@ public:
 
       // Connection-related methods c
       bool isUserConnected(int clientSocket);
-      int reconnectUser(Player new_player);
+      /**
+       * @brief Gives the paused seat of this user name and session token to the new connection's Player.
+       * * The paused Player goes back to the pool, nothing is copied.
+       * @return The seat (1 or 2), -1 if no paused seat has this name and token.
+       */
+      int reconnectUser(Player& player, std::string_view token);
       void removePlayer(int socket);
       void resetLobby();
 
+      /**
+       * @brief Ends a paused game in favour of the player still connected.
+       * * The seat of the disconnected player is freed (its Player deleted),
+       * the lobby is reset if nobody connected is left.
+       * @return Winner (1 or 2), 0 if the game was not paused.
+       */
+      int forfeitDisconnected();
+
+      // Spectators (REV WATCH), any number of them, by socket
+      bool addSpectator(int clientSocket);
+      bool removeSpectator(int clientSocket);
+      bool isSpectator(int clientSocket) const;
+      const std::vector<int>& getSpectators() const;
+
+      /**
+       * @brief What a spectator gets when it starts watching or a game starts.
+       * * "REV SPECTATE <status> <player1> <player2> <lobbyId> <size>" ("-"
+       * for an empty seat, like START otherwise) followed by the STATE line.
+       */
+      std::string getSpectatorView();
+
       // Game-related methods
       int canUserPlay(int clientSocket);
       int calculateWinner();
       bool validateAndApplyMove(int x, int y, int clientSocket);
       std::string getBoardStateString();
 
+      /**
+       * @brief The last move as "<version> <square> <flips> <hints> <score1> <score2> <status>".
+       * * Squares are row-major indices (y * size + x), the flipped squares
+       * and the new legal moves are comma-separated lists, "-" when empty.
+       */
+      std::string getDeltaString();
+
+      /**
+       * @brief The board and the last move as binary frames (OP_STATE, OP_DELTA).
+       * * Built from the bitboards, equal to encoding the text forms.
+       */
+      std::string getStateFrame();
+      std::string getDeltaFrame();
+      int getBoardSize() const;
+      int getEmpties() const;
+
+      /**
+       * @brief Switches an idle lobby to a size x size board (6, 8 or 10).
+       * @return false for an unsupported size.
+       */
+      bool setBoardSize(int size);
+
+      /**
+       * @brief The 8x8 board (engine, book and cache), nullptr for other sizes.
+       */
+      const Board* getBoard() const;
+      unsigned long getStateVersion() const;
+      std::string getTranscript() const;
+
+      // Computer opponent
+      bool hasBot() const;
+      bool isBotTurn() const;
+
       // Rematch methods
       void setRematch(int playerNum);
       void restartGame();
@@ -47,5 +138,37 @@ private:
       int statusBeforePause;
       int lobbyId;
       int status;
-      int board[8][8];
+      LobbyBoardState state;
+
+      // Bumped by every move, reset and rematch (lets async work detect stale boards)
+      unsigned long stateVersion;
+
+      // Start position and squares played since, for the game record
+      std::string startState;
+      std::vector<uint8_t> moveHistory;
+
+      // Seats as last published to the socket index (lobbyIndex.h)
+      int indexedSockets[2];
+      bool inUse;   // As last told to the pool (lobbyPool.h)
+      // As last told to the lobby directory (lobbyDirectory.h)
+      int publishedPlayers;
+      int publishedState;
+      int publishedSize;
+
+      std::vector<int> spectators;
+
+      void loadStartState(const std::string& start);
+
+      /**
+       * @brief Brings the lobby index and the pool up to date after the seats changed.
+       */
+      void reindex();
+
+      /**
+       * @brief Tells the lobby directory about a change of players, state or board size.
+       */
+      void publishDirectory();
+
+      template <int N>
+      bool applyMove(LobbyBoard<N>& current, int x, int y, int player);
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+// Lobbies per "REV DIRECTORY" line, keeps lines (and binary frames) small
+#define DIRECTORY_CHUNK_ENTRIES 128
+
+// What the directory tells about a lobby, besides its players and board size
+#define DIRECTORY_OPEN 0      // No game running, joinable while a seat is free
+#define DIRECTORY_PLAYING 1
+#define DIRECTORY_PAUSED 2    // A player dropped out and may come back
+
+/**
+ * @brief Live list of the lobbies in use, for the clients in the lobby menu.
+ * * Keeps one entry per occupied lobby (players, state, board size) and a
+ * version bumped by every change. A client entering the menu subscribes
+ * and gets the whole snapshot once:
+ *   REV DIRECTORY <version> <more> <id>:<players>:<state>:<size> ...
+ * (DIRECTORY_CHUNK_ENTRIES lobbies per line, <more> is 0 on the last
+ * line), then one line per change:
+ *   REV LOBBYDIFF <version> <id> <players> <state> <size>
+ * An emptied lobby is announced with 0 players and drops out of the
+ * snapshot. Versions increase by one per change, the snapshot's version
+ * is the last change it includes.
+ * * A change is only recorded under the lobby's lock: the entry, the
+ * version and its text line, in O(1). It goes out once the lobby lock is
+ * released (flushLobbyDirectory): one thread at a time hands the recorded
+ * changes, in version order, to every subscriber's outbox, serialized once
+ * (text, and a frame for binary clients). A thread finding another one
+ * delivering leaves its changes to that one. The snapshot is rebuilt only
+ * when a client asks for it after a change: the entries are copied under
+ * the lock and the lines built outside it, into one buffer shared by every
+ * subscriber of that version.
+ */
+
+/**
+ * @brief Records the entry of a lobby (Lobby::publishDirectory, under the lobby's lock).
+ * * Nothing is recorded if the entry did not change. Sent right away when
+ * no LobbyLock is held, otherwise when it is released.
+ * @param players Seats taken, the computer included.
+ * @param state DIRECTORY_OPEN, DIRECTORY_PLAYING or DIRECTORY_PAUSED.
+ */
+void updateLobbyDirectory(int lobbyId, int players, int state, int boardSize);
+
+/**
+ * @brief Sends the recorded changes to the subscribers (LobbyLock's destructor).
+ * * Returns at once if another thread is delivering, that one sends them.
+ */
+void flushLobbyDirectory();
+
+/**
+ * @brief Sends "REV LOBBY <count>" and the snapshot, then every change to the client.
+ * * Subscribing again resends the snapshot. What the calling thread's
+ * MessageBatch holds is written first (the SESSION reply of a LOGIN).
+ * @return 0 on success, -1 for an invalid socket.
+ */
+int subscribeLobbyDirectory(int clientSocket);
+
+/**
+ * @brief Stops the updates (the client left the menu or disconnected).
+ */
+void unsubscribeLobbyDirectory(int clientSocket);
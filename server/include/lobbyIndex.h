@@ -0,0 +1,24 @@
+#pragma once
+
+/**
+ * @brief Where players sit, without scanning the lobbies.
+ * * Maps the socket of every seated player to the lobby id (paused seats
+ * are found by user name through their session, playerPool.h). Lobbies keep it up to date
+ * themselves whenever a seat changes (Lobby::reindex), under their own
+ * lock; the index has a lock of its own and never takes a lobby lock, so
+ * lookups can be done before deciding which lobby to lock.
+ * * An entry only says where to look: callers check the lobby again under
+ * its lock before acting on it.
+ */
+
+void indexLobbySocket(int clientSocket, int lobbyId);
+
+/**
+ * @brief Drops the entry, unless the socket was indexed for another lobby since.
+ */
+void unindexLobbySocket(int clientSocket, int lobbyId);
+
+/**
+ * @brief Lobby the socket is seated in, -1 if none.
+ */
+int findLobbyBySocket(int clientSocket);
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+class Lobby;
+
+// Lobbies are created LOBBY_SLAB_SIZE at a time, and retired the same way once idle
+#define LOBBY_SLAB_SIZE 1024
+#define MAX_LOBBY_SLABS 128
+// Highest lobby id + 1 (131072)
+#define MAX_LOBBIES (LOBBY_SLAB_SIZE * MAX_LOBBY_SLABS)
+// The lobby list never shows fewer lobbies, even on an idle server
+#define MIN_LISTED_LOBBIES 5
+// JOIN and WATCH reach this many ids past the listed ones (isOpenableLobbyId)
+#define LOBBY_OPEN_MARGIN 32
+// Slabs are checked this often, one idle for LOBBY_TRIM_IDLE_SWEEPS checks is
+// taken out of the pool
+#define LOBBY_TRIM_INTERVAL_MS 30000
+#define LOBBY_TRIM_IDLE_SWEEPS 2
+
+/**
+ * @brief A lobby id as seen by work that outlives the current game.
+ * * The generation changes every time the lobby is released, a timer or
+ * task holding an older handle finds out the lobby was reused.
+ */
+struct LobbyHandle {
+    int id;
+    uint32_t generation;
+};
+
+/**
+ * @brief Every lobby of the server, created on demand.
+ * * Lobbies live in slabs allocated the first time one of their ids is
+ * opened, a Lobby never moves and an idle lobby only costs its own (small)
+ * object. A lobby is in use from its first player until it is reset, then
+ * it is released and its id can be handed out again. The ids in use decide
+ * how many lobbies the list shows, and clients can only open ids close to
+ * those (isOpenableLobbyId).
+ * * A slab (except the first) without a lobby in use or watched for
+ * LOBBY_TRIM_IDLE_SWEEPS checks is retired: findLobby no longer returns
+ * its lobbies and handles to them are stale. Its memory is never given
+ * back, so a Lobby* handed out before stays valid however long its user
+ * stalls; opening or using one of its lobbies puts the slab back as it was.
+ * * Allocation is guarded by the pool's own lock, looking a lobby up is
+ * lock-free. The lobby itself is guarded by LobbyLock (shard.h).
+ */
+
+/**
+ * @brief Creates the first slab and starts retiring idle slabs, once at startup.
+ */
+void initLobbyPool();
+
+bool isValidLobbyId(int lobbyId);
+
+/**
+ * @brief True for an id a client may JOIN or WATCH.
+ * * The listed ids and LOBBY_OPEN_MARGIN more, so a client cannot make the
+ * server allocate slabs far above the lobbies in use.
+ */
+bool isOpenableLobbyId(int lobbyId);
+
+/**
+ * @brief The lobby with this id, nullptr if its slab was not opened (or retired since).
+ * * The lobby may be idle (empty), callers check it under its lock. The
+ * pointer is meant for the current operation, later ones look it up again.
+ */
+Lobby* findLobby(int lobbyId);
+
+/**
+ * @brief The lobby with this id, its slab is created if needed.
+ * @return nullptr for an id outside [0, MAX_LOBBIES).
+ */
+Lobby* openLobby(int lobbyId);
+
+/**
+ * @brief Lowest id from `first` on that is not in use, among the ids `offset` mod `stride`.
+ * * Nothing is reserved: the caller opens the lobby, checks it is still
+ * empty under its lock and asks again from the next id otherwise.
+ * @return The id, -1 if every lobby is in use.
+ */
+int findIdleLobby(int first, int stride, int offset);
+
+/**
+ * @brief Marks a lobby as in use (Lobby::reindex, under the lobby's lock).
+ */
+void markLobbyInUse(int lobbyId);
+
+/**
+ * @brief Releases an idle lobby, its id may be handed out again (under the lobby's lock).
+ */
+void releaseLobby(int lobbyId);
+
+/**
+ * @brief A lobby got its first spectator or lost its last one (under the lobby's lock).
+ * * A watched lobby keeps its slab, like one in use.
+ */
+void setLobbyWatched(int lobbyId, bool watched);
+
+/**
+ * @brief Number of lobbies announced by "REV LOBBY".
+ * * Every id up to the highest one in use plus one free id after it, at
+ * least MIN_LISTED_LOBBIES. Free ids below the highest one can be joined too.
+ */
+int getListedLobbyCount();
+
+LobbyHandle getLobbyHandle(int lobbyId);
+
+/**
+ * @brief True if the lobby was not released since the handle was taken.
+ */
+bool isLobbyHandleCurrent(LobbyHandle handle);
+
+/**
+ * @brief Pool summary for the log: slabs, lobbies in use, bytes per lobby.
+ */
+std::string formatLobbyPoolStats();
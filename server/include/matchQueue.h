@@ -0,0 +1,65 @@
+#pragma once
+#include "../include/player.h"
+#include <string>
+
+// Ratings are grouped in bands of this width, a player is paired within its band at once
+#define QUEUE_RATING_BAND 100
+#define QUEUE_MAX_RATING 3999
+// Rating of a player who queues without one
+#define QUEUE_DEFAULT_RATING 1500
+// Every QUEUE_WIDEN_MS of waiting accepts opponents one band further away
+#define QUEUE_WIDEN_MS 1000
+// How often waiting players are paired again with their widened band
+#define QUEUE_MATCH_INTERVAL_MS 500
+
+/**
+ * @brief Matchmaking for "REV QUEUE": pairs waiting players and opens a lobby per pair.
+ * * Players wait in FIFO buckets by shard, board size and rating band. A
+ * new player is paired with the longest waiting one of its own bucket,
+ * an O(1) check; if there is none it joins the bucket. A timer thread
+ * pairs the oldest player of each bucket with the nearest band its wait
+ * allows, one more band on each side per QUEUE_WIDEN_MS.
+ * * The queue has its own lock and seats a pair while holding it, so a
+ * queued player that disconnects (leaveMatchQueue) is either still queued
+ * or already seated. With --reactors=N only players of the same shard are
+ * paired, as the lobby has to belong to that shard; a new player is handed
+ * over to the shard with the closest partner waiting (findMatchQueueShard).
+ */
+
+/**
+ * @brief Starts the thread pairing players with widened bands, once at startup.
+ */
+void startMatchQueue();
+
+/**
+ * @brief Pairs the player with the longest waiting one of its bucket, or queues it.
+ * * A pair is seated in a fresh lobby (seatMatchedPlayers, handler.h),
+ * the caller starts the game (startMatchedGame).
+ * Without a free lobby the player is queued as well.
+ * @param rating 0 to QUEUE_MAX_RATING.
+ * @return The lobby of the new game, -1 if the player was queued, -2 for an invalid size or rating.
+ */
+int joinMatchQueue(Player& player, int boardSize, int rating);
+
+/**
+ * @brief Takes the player out of the queue (EXIT or disconnect).
+ * @return false if it was not queued (any more).
+ */
+bool leaveMatchQueue(const Player& player);
+
+/**
+ * @brief Players waiting right now.
+ */
+int getMatchQueueDepth();
+
+/**
+ * @brief Shard with the waiting player of this board size closest in rating, -1 if none.
+ * * The calling shard is preferred on a tie. Only says where to look, the
+ * partner may be taken before the player gets there.
+ */
+int findMatchQueueShard(int boardSize, int rating);
+
+/**
+ * @brief Queue summary for the log: players waiting, matched, time to match.
+ */
+std::string formatMatchQueueStats();
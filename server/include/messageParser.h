@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tokens kept per message, the longest valid command (MOVE) has 5 and the
+// longest server message the binary encoder translates (DELTA) has 9
+#define MAX_MESSAGE_TOKENS 10
+// Arguments after "REV <COMMAND>"
+#define MAX_COMMAND_ARGS (MAX_MESSAGE_TOKENS - 2)
+
+// Commands of the text protocol ("REV <COMMAND> ...")
+enum CommandId {
+    CMD_UNKNOWN,
+    CMD_HEARTBEAT,
+    CMD_CREATE,
+    CMD_JOIN,
+    CMD_BOT,
+    CMD_EXIT,
+    CMD_MOVE,
+    CMD_REMATCH,
+    CMD_RESYNC,
+    CMD_QUEUE,
+    CMD_WATCH
+};
+
+/**
+ * @brief One received line, split into views of its words.
+ * * The views point into the line, which has to outlive the message.
+ */
+struct ParsedMessage {
+    std::string_view tokens[MAX_MESSAGE_TOKENS];
+    int tokenCount;        // Words in the line, may exceed MAX_MESSAGE_TOKENS (the rest is not kept)
+    CommandId command;     // From the second word, CMD_UNKNOWN if missing or not a command
+
+    // Word `index`, empty if the line has fewer words
+    std::string_view arg(int index) const {
+        return (index < tokenCount && index < MAX_MESSAGE_TOKENS) ? tokens[index] : std::string_view();
+    }
+};
+
+/**
+ * @brief A client command, decoded from a text line or a binary frame.
+ * * What the handler dispatches on, so both protocols share one state machine.
+ */
+struct ClientCommand {
+    CommandId command;
+    std::string_view name;       // Command word, for the logs
+    int argCount;                // Arguments after the command word
+    int numericCount;            // Leading arguments that are valid ints (stored in args)
+    int args[MAX_COMMAND_ARGS];
+    std::string_view text[MAX_COMMAND_ARGS];   // Arguments as written (text protocol only)
+};
+
+/**
+ * @brief Splits a line at whitespace (like operator>>) and identifies the command.
+ * * Works in place: nothing is copied or allocated and nothing throws.
+ * @param line One message without its '\n'.
+ * @param message Receives the views and the command.
+ */
+void parseMessage(std::string_view line, ParsedMessage& message);
+
+/**
+ * @brief Decodes a text line ("REV <COMMAND> <args>").
+ * @return false if the line does not start with "REV".
+ */
+bool decodeTextMessage(std::string_view line, ClientCommand& command);
+
+/**
+ * @brief Maps a command word to its id with a switch on length and first letter.
+ */
+CommandId lookupCommand(std::string_view name);
+
+/**
+ * @brief Word of a command id ("MOVE"), "" for CMD_UNKNOWN.
+ */
+const char* commandName(CommandId command);
+
+/**
+ * @brief Reads a whole word as a decimal int (std::from_chars).
+ * @return false if the word is empty, not a number, out of range or has trailing characters.
+ */
+bool parseInt(std::string_view token, int& value);
+
+/**
+ * @brief Splits a message into words, allocating each one.
+ * * The tokenizer used before parseMessage, kept for the parser benchmark.
+ * @return Array of params
+ */
+std::vector<std::string> splitMessage(const std::string &s);
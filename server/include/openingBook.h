@@ -0,0 +1,92 @@
+#pragma once
+#include "../include/gameLogic.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define BOOK_MAGIC "REVBOOK1"
+
+/**
+ * One (position, move) pair of the book file. The position is stored in
+ * its canonical orientation (side to move first), the move as well.
+ * Records are sorted by (own, opp, square), the file is a 16 byte header
+ * (magic + record count) followed by the raw records.
+ */
+struct BookRecord {
+      uint64_t own;
+      uint64_t opp;
+      uint32_t square;
+      uint32_t games;
+      uint32_t points;     // Win 2, draw 1, loss 0 for the side that played the move
+      int32_t margin;      // Sum of the final disc differences, same point of view
+};
+
+struct BookHeader {
+      char magic[8];
+      uint64_t count;
+};
+
+/**
+ * @brief Applies one of the 8 board symmetries to a bitboard.
+ * * Bit 2 of `symmetry` transposes, bit 0 mirrors the columns and bit 1
+ * mirrors the rows (in this order).
+ */
+uint64_t transformBitboard(uint64_t bits, int symmetry);
+
+/**
+ * @brief Rewrites a position into its canonical orientation.
+ * * The canonical form is the smallest (own, opp) pair of all 8
+ * symmetric positions.
+ * @return The symmetry that maps the given position to the canonical one.
+ */
+int canonicalizePosition(uint64_t &own, uint64_t &opp);
+
+/**
+ * @brief Read-only opening book mapped into memory.
+ * * open() only maps the file and checks the header, the records are
+ * used in place, so startup does not depend on the size of the book.
+ * Lookups are a binary search over the sorted records.
+ */
+class OpeningBook {
+public:
+      OpeningBook();
+      ~OpeningBook();
+      OpeningBook(const OpeningBook&) = delete;
+      OpeningBook& operator=(const OpeningBook&) = delete;
+
+      bool open(const std::string& path);
+      void close();
+
+      size_t size() const;
+      const BookRecord* records() const;
+
+      /**
+       * @brief Finds the moves recorded for a canonical position.
+       * @param count Set to the number of consecutive records found.
+       * @return First record of the position, nullptr if it is not in the book.
+       */
+      const BookRecord* findPosition(uint64_t own, uint64_t opp, size_t &count) const;
+
+      /**
+       * @brief Picks the best scoring book move of a position.
+       * @param board Current position, hints are not required.
+       * @param player Side to move (1 or 2).
+       * @param minGames Moves played less often are ignored.
+       * @return The square (y * 8 + x) in the board's orientation, -1 if none.
+       */
+      int lookup(const Board& board, int player, unsigned minGames) const;
+
+private:
+      void *mapping;
+      size_t mappingSize;
+      const BookRecord *entries;
+      size_t count;
+};
+
+/**
+ * @brief Appends one finished game to a text game record file.
+ * * Thread safe, one line per game: "<start state> <move> <move> ...",
+ * moves as column letter and row number (e.g. d3), passes are implicit.
+ * @return false if the file could not be written.
+ */
+bool appendGameRecord(const std::string& path, const std::string& transcript);
@@ -0,0 +1,92 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+
+// A client with more unsent bytes than this is too slow to keep up and is disconnected
+#define OUTBOX_HIGH_WATER (256 * 1024)
+// Messages of one batch sent with a single writev, longer batches are joined first
+#define OUTBOX_MAX_IOVECS 16
+
+// An immutable message shared by the outboxes of several clients (broadcasts)
+typedef std::shared_ptr<const std::string> SharedMessage;
+
+/**
+ * @brief Outgoing side of the thread and epoll modes.
+ * * Every registered socket has an outbox. Messages are written without
+ * blocking: whatever the socket does not take is kept in order and
+ * written by one flusher thread as soon as the socket is writable again,
+ * so a slow client never blocks the thread that sends to it. A client
+ * whose backlog passes OUTBOX_HIGH_WATER is shut down, its reader then
+ * sees the hang-up and releases it as for any disconnect.
+ * * The backlog is a queue of shared buffers: a broadcast stays one
+ * buffer however many slow clients still have to receive it.
+ * * The io_uring mode queues its sends itself and does not use this.
+ */
+
+/**
+ * @brief Starts the flusher thread, once at startup.
+ */
+void startOutboxFlusher();
+
+/**
+ * @brief Creates the outbox of an accepted socket.
+ */
+void openOutbox(int clientSocket);
+
+/**
+ * @brief Drops the outbox and its unsent bytes, before the socket is closed.
+ */
+void closeOutbox(int clientSocket);
+
+/**
+ * @brief Writes messages to a client, in order, with one writev.
+ * * Never blocks. Messages to a socket without an outbox are dropped.
+ * @return 0 if the bytes were written or queued, -1 if the client is gone.
+ */
+int writeToOutbox(int clientSocket, const std::string* messages, int count);
+
+/**
+ * @brief Writes a message shared with other clients, without copying it.
+ * * Never blocks. Whatever the socket does not take stays queued as a
+ * reference to the shared buffer.
+ * @param skippable The message only matters until a newer one: while the
+ * client is behind, a newer skippable message replaces it (skips forward).
+ * @return 0 if the bytes were written or queued, -1 if the client is gone.
+ */
+int writeSharedToOutbox(int clientSocket, const SharedMessage& message, bool skippable);
+
+/**
+ * @brief Collects what the calling thread sends while it exists.
+ * * The messages produced by one event (a move answers with STATE and
+ * PASS/END to both players) leave with one write per client when the
+ * outermost batch ends, instead of one syscall per message. Batches nest.
+ */
+class MessageBatch {
+public:
+    MessageBatch();
+    ~MessageBatch();
+
+    MessageBatch(const MessageBatch&) = delete;
+    MessageBatch& operator=(const MessageBatch&) = delete;
+};
+
+/**
+ * @brief Writes what the calling thread's batch holds so far, the batch stays open.
+ * * For messages written past the batch (the lobby directory), which must
+ * not overtake what the batch already holds.
+ */
+void flushBatch();
+
+/**
+ * @brief Adds a message to the calling thread's batch.
+ * @return false if no batch is open, the caller sends right away.
+ */
+bool addToBatch(int clientSocket, const std::string& message);
+
+/**
+ * @brief Runs `task` once the calling thread's batch is written, right away if none is open.
+ * * Work answered from another thread (a bot move, a score prediction)
+ * starts after the messages it follows, so its answer cannot overtake them.
+ */
+void runAfterBatch(std::function<void()> task);
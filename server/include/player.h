@@ -1,23 +1,42 @@
 #pragma once
+#include <atomic>
 #include <string>
 
 enum ClientState {
     STATE_LOGIN,     // Connected, but no username yet
     STATE_MENU,      // Logged in, browsing lobbies
+    STATE_QUEUED,    // Waiting in the matchmaking queue (matchQueue.h)
     STATE_WAITING,   // Inside a lobby, alone
     STATE_PLAYING,   // Inside a lobby, game is active
-    STATE_GAME_OVER  // Game finished
+    STATE_GAME_OVER, // Game finished
+    STATE_WATCHING   // Spectating a lobby (REV WATCH)
 };
 
+// The computer opponent sits in a lobby seat with this fake socket
+#define BOT_SOCKET -2
+#define BOT_USERNAME "COMPUTER"
+
 class Player {
 public:
     int socket;
     std::string username;
     int tolerance; 
+    bool isBot;
+    bool binaryProtocol;   // Sends length-prefixed frames since CREATE ... BIN (binaryProtocol.h)
+    bool deltaUpdates;     // Gets DELTA after moves instead of the full STATE (CREATE ... DELTA)
+    std::string sessionToken;   // Issued at login, resumes its seat after a disconnect (playerPool.h)
     
-    ClientState state; 
+    // Also set from other threads: the match queue seats a waiting player,
+    // a lobby's game ends or restarts for both seats
+    std::atomic<ClientState> state;
+
+    // Who holds the object, kept by playerPool.h
+    bool connected;
+    int seatLobby;         // Lobby of its seat, -1 if none
+    int watchLobby;        // Lobby it spectates, -1 if none
 
-    Player(int s) : socket(s), tolerance(0), state(STATE_MENU) {}
+    Player(int s) : socket(s), tolerance(0), isBot(false), binaryProtocol(false), deltaUpdates(false), state(STATE_MENU),
+                    connected(false), seatLobby(-1), watchLobby(-1) {}
 
     void appendName(std::string name) { username = name; }
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "../include/player.h"
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Owner of every Player: connections, lobby seats and paused sessions.
+ * * A Player is held by its connection and by the lobby seat it sits in.
+ * Both let go through the pool, which hands the object out again once
+ * neither holds it; nobody else deletes a Player. Released objects are
+ * kept on a free list, so connection churn reuses them (and the capacity
+ * of their name) instead of going to the allocator.
+ * * Every login gets a session token (issueSessionToken). A seated player
+ * whose connection ends is a paused session, registered under its token
+ * until it reconnects or loses its seat. Logging in again with the same
+ * name and token finds it in O(1) (findSession); the name alone does not.
+ */
+
+/**
+ * @brief A Player for a new connection, in STATE_LOGIN.
+ */
+Player* acquirePlayer(int clientSocket);
+
+/**
+ * @brief A Player for the computer seat (BOT_SOCKET, no connection).
+ */
+Player* acquireBotPlayer();
+
+/**
+ * @brief The player now sits in `lobbyId` (Lobby::setPlayer, under the lobby's lock).
+ */
+void seatPlayer(Player* player, int lobbyId);
+
+/**
+ * @brief The lobby let go of the seat (also for a computer player never seated).
+ * * Ends the player's paused session, if any. Returned to the pool if its
+ * connection is gone as well.
+ */
+void unseatPlayer(Player* player);
+
+/**
+ * @brief Gives the player a fresh random session token and returns it.
+ */
+const std::string& issueSessionToken(Player* player);
+
+/**
+ * @brief The connection of the player ended.
+ * * A seated human stays alive as a paused session, anything else goes
+ * back to the pool. Called under the seat lobby's lock before the seat
+ * is paused, so a login looking for the session cannot slip in between.
+ */
+void releaseConnection(Player* player);
+
+/**
+ * @brief Lobby holding the paused session with this token and user name, -1 if none.
+ * * Only says where to look: the lobby checks again under its lock
+ * (Lobby::reconnectUser).
+ */
+int findSession(std::string_view username, std::string_view token);
+
+/**
+ * @brief Pool summary for the log: players in use, free objects, paused sessions.
+ */
+std::string formatPlayerPoolStats();
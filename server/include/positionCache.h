@@ -0,0 +1,103 @@
+#pragma once
+#include "../include/gameLogic.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#define POSITION_CACHE_SHARDS 16
+#define POSITION_CACHE_WAYS 4
+
+// What a cache entry can hold for one position (and side to move)
+enum CacheKind {
+      CACHE_LEGAL_MOVES,
+      CACHE_EVALUATION,
+      CACHE_SOLVED,
+      CACHE_KIND_COUNT
+};
+
+struct CachedEvaluation {
+      int square;   // Best move found by the search
+      int score;    // Search score, side to move's point of view
+      int depth;    // Completed search depth
+};
+
+struct CachedSolve {
+      int square;   // Perfect move, -1 when the side to move has to pass
+      int score;    // Exact final disc difference, side to move's point of view
+};
+
+struct PositionCacheStats {
+      uint64_t lookups[CACHE_KIND_COUNT];
+      uint64_t hits[CACHE_KIND_COUNT];
+      size_t capacity;
+      size_t used;
+};
+
+/**
+ * @brief Bounded position cache shared by every lobby and the bot.
+ * * Keyed by the Zobrist position key (getPositionKey), the stored discs
+ * are compared as well so a hash collision is never served. Entries are
+ * split over POSITION_CACHE_SHARDS independently locked shards picked by
+ * the top bits of the key; inside a shard every key maps to a set of
+ * POSITION_CACHE_WAYS entries and the least recently used one is replaced.
+ * * Lookups and hits are counted per kind (see getStats) to size the cache.
+ */
+class PositionCache {
+public:
+      /**
+       * @param capacity Number of entries, rounded up to a power of two.
+       */
+      explicit PositionCache(size_t capacity);
+
+      /**
+       * @brief Legal moves of `player`, computed and stored on a miss.
+       */
+      uint64_t getMoveMask(const Board& board, int player);
+
+      bool getEvaluation(const Board& board, int player, CachedEvaluation& evaluation);
+      void storeEvaluation(const Board& board, int player, const CachedEvaluation& evaluation);
+
+      bool getSolved(const Board& board, int player, CachedSolve& solve);
+      void storeSolved(const Board& board, int player, const CachedSolve& solve);
+
+      PositionCacheStats getStats() const;
+
+      /**
+       * @brief One log line: capacity, fill and hit rate per kind.
+       */
+      std::string formatStats() const;
+
+private:
+      struct Entry {
+            uint64_t key;
+            uint64_t discs[2];
+            uint64_t legal;
+            uint32_t lastUse;
+            uint8_t player;      // 0 = unused slot
+            uint8_t flags;       // Bit per CacheKind that holds data
+            int8_t evalMove;
+            int8_t evalDepth;
+            int16_t evalScore;
+            int8_t solvedMove;
+            int8_t solvedScore;
+      };
+
+      struct Shard {
+            mutable std::mutex mutex;
+            std::unique_ptr<Entry[]> entries;
+            uint32_t clock;
+            size_t used;
+            uint64_t lookups[CACHE_KIND_COUNT];
+            uint64_t hits[CACHE_KIND_COUNT];
+      };
+
+      Shard& shardFor(uint64_t key);
+      Entry* findLocked(Shard& shard, uint64_t key, const Board& board, int player);
+      Entry& insertLocked(Shard& shard, uint64_t key, const Board& board, int player);
+
+      std::unique_ptr<Shard[]> shards;
+      size_t setMask;      // Sets per shard - 1
+      size_t capacity;
+};
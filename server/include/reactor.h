@@ -0,0 +1,47 @@
+#pragma once
+#include "../include/player.h"
+#include "../include/lineBuffer.h"
+#include "../include/timerWheel.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define REACTOR_MAX_EVENTS 256
+
+/**
+ * @brief State of one client served by the epoll reactor.
+ * * Replaces the locals of handleClientLogic (receive buffer, Player) so a
+ * single thread can serve every client.
+ */
+struct Connection {
+    int socket;
+    Player *player;          // Created with the first received data, like in thread mode
+    LineBuffer lines;        // Received bytes, split into lines in place
+    int hops;                // Shards the pending line was passed through (--reactors)
+    std::chrono::steady_clock::time_point lastActivity;
+    Timer idleTimer;         // Due CLIENT_TIMEOUT_SEC after the last activity, checked lazily
+};
+
+/**
+ * @brief Serves every client from one edge-triggered epoll loop.
+ * * The listening and client sockets are non-blocking, every readiness
+ * event is drained until EAGAIN. Complete lines are passed to
+ * handleMessage exactly as in thread mode. Clients silent for
+ * CLIENT_TIMEOUT_SEC are disconnected by the reactor's timer wheel (the
+ * thread mode uses SO_RCVTIMEO for that). Never returns unless epoll fails.
+ * @param serverSocket A bound, listening socket.
+ */
+void runEpollServer(int serverSocket);
+
+/**
+ * @brief Runs one epoll reactor per listener (--reactors=N).
+ * * The listeners share a port through SO_REUSEPORT, so the kernel spreads
+ * new connections over the reactors. Every reactor runs on its own thread
+ * pinned to its own CPU (the calling thread serves the first one).
+ * Lobbies are owned by reactors (see shard.h): a line that needs a lobby
+ * of another reactor moves its connection there through the target's
+ * mailbox, and the connection stays there while seated. Never returns
+ * unless a reactor cannot be set up.
+ * @param listenSockets Bound, listening sockets, one per reactor.
+ */
+void runShardedEpollServer(const std::vector<int>& listenSockets);
@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @brief Deadline of the paused games (--reconnect-grace-sec).
+ * * A game is paused when a player drops out and resumes when they log in
+ * again under the same name. If they do not come back within the grace
+ * period the game is forfeited: the opponent wins ("REV END") and the
+ * lobby gets free again. One timer wheel on its own thread holds a timer
+ * per paused lobby, the forfeit itself runs on the lobby's shard.
+ */
+
+/**
+ * @brief Starts the timer thread, once at startup (nothing with a grace of 0).
+ */
+void startReconnectGrace();
+
+/**
+ * @brief (Re)starts the grace period of a lobby whose game was just paused.
+ */
+void armReconnectGrace(int lobbyId);
+
+/**
+ * @brief Stops the grace period of a lobby, the player is back.
+ */
+void cancelReconnectGrace(int lobbyId);
@@ -1,6 +1,69 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "../include/lobby.h"
+#include "../include/outbox.h"
+
+// Replaces the plain send() of sendMessage (set by the io_uring reactor)
+typedef void (*TransmitFunction)(int clientSocket, const std::string& message);
+
+/**
+ * @brief Sends one complete protocol message to a client.
+ * * Every message of the server goes through here. Inside a MessageBatch
+ * the message waits for the end of the batch, otherwise it is delivered
+ * right away (deliverMessages).
+ * * @param clientSocket The socket descriptor of the target client.
+ * @param message The message, including the trailing newline.
+ * @return 0 on success, -1 on failure.
+ */
+int sendMessage(int clientSocket, const std::string& message);
+
+/**
+ * @brief sendMessage with the binary frame already built.
+ * * The client gets `frame` if it speaks the binary protocol, `message`
+ * otherwise, so a message for several clients is encoded once and the
+ * boards are framed straight from the game (Lobby::getStateFrame).
+ * Only the form the client gets has to be filled in.
+ * @return 0 on success, -1 on failure.
+ */
+int sendPreparedMessage(int clientSocket, const std::string& message, const std::string& frame);
+
+/**
+ * @brief Hands messages for one client to the network, in order.
+ * * Goes to the client's outbox (one non-blocking writev, see outbox.h)
+ * unless a transmit function is installed (see setTransmitFunction).
+ * @return 0 on success, -1 on failure.
+ */
+int deliverMessages(int clientSocket, const std::string* messages, int count);
+
+/**
+ * @brief Hands a message shared with other clients to the network, without copying it.
+ * * A client that is behind keeps a reference to the buffer (writeSharedToOutbox).
+ * @return 0 on success, -1 on failure.
+ */
+int deliverSharedMessage(int clientSocket, const SharedMessage& message);
+
+/**
+ * @brief Routes every later sendMessage through `function`.
+ * * The function must be thread-safe, messages are sent from the network
+ * thread(s) and from the bot pool.
+ */
+void setTransmitFunction(TransmitFunction function);
+
+/**
+ * @brief Sends the same message to many clients, serialized once.
+ * * The text (and, if a recipient speaks the binary protocol, its frames)
+ * is built once into an immutable reference-counted buffer that every
+ * recipient's outbox shares (writeSharedToOutbox): nothing is copied per
+ * recipient and a slow one never blocks the sender. Bypasses the message
+ * batch. The io_uring mode copies the buffer into each connection's send
+ * queue (its transmit function).
+ * * @param clientSockets The recipients.
+ * @param message One or more complete lines, each with its newline.
+ * @param skippable A newer skippable message replaces this one for a client still behind.
+ * @return 0 on success, -1 if the message is empty.
+ */
+int broadcastMessage(const std::vector<int>& clientSockets, const std::string& message, bool skippable);
 
 /**
  * @brief Sends a connection confirmation to the client.
@@ -12,6 +75,16 @@
  */
 int sendConnectInfo(int clientSocket, int playerNumber);
 
+/**
+ * @brief Confirms a place in the matchmaking queue.
+ * * Sends a "REV QUEUED <Depth>" message, "REV CONNECT" follows once an
+ * opponent is found.
+ * * @param clientSocket The socket descriptor of the queued client.
+ * @param depth Players waiting in the queue, this one included.
+ * @return 0 on success, -1 on failure.
+ */
+int sendQueueInfo(int clientSocket, int depth);
+
 /**
  * @brief Notifies a client that their opponent has disconnected.
  * * Sends a "REV DISCONNECT <WhoDisconnected>" message.
@@ -30,9 +103,19 @@ int sendDisconnectInfo(int clientSocket, int disconnectedUser);
  */
 int sendReconnectInfo(int clientSocket);
 
+/**
+ * @brief Hands a client the session token of its login.
+ * * Sends "REV SESSION <token>". The client passes it back in
+ * "REV CREATE <name> ... <token>" to resume a paused game.
+ * * @param clientSocket The socket descriptor of the target client.
+ * @param token The token issued for this login.
+ * @return 0 on success, -1 on failure.
+ */
+int sendSessionToken(int clientSocket, const std::string& token);
+
 /**
  * @brief Sends the Game Start signal and initial data.
- * * Sends "REV START <PlayerNum> <P1Name> <P2Name> <LobbyID>" followed
+ * * Sends "REV START <PlayerNum> <P1Name> <P2Name> <LobbyID> <BoardSize>" followed
  * by the initial board state.
  * * @param clientSocket The socket descriptor of the target client.
  * @param player1 Username of Player 1.
@@ -54,10 +137,24 @@ int sendStartingPlayerInfo(int clientSocket, std::string player1, std::string pl
 int sendState(int clientSocket, Lobby& lobby);
 
 /**
- * @brief Sends the list of available lobbies to a client.
- * * Sends "REV LOBBY <Count>". Currently sends the total count,
- * allowing the client to generate the list UI.
+ * @brief Sends the list of available lobbies to a client entering the menu.
+ * * Sends "REV LOBBY <Count>" followed by the lobby directory snapshot
+ * ("REV DIRECTORY") and subscribes the client to its changes
+ * ("REV LOBBYDIFF") until it leaves the menu (lobbyDirectory.h).
+ * Bypasses the message batch, so the changes arrive in order.
  * * @param clientSocket The socket descriptor of the target client.
  * @return 0 on success.
  */
-int sendLobbyList(int clientSocket);
\ No newline at end of file
+int sendLobbyList(int clientSocket);
+
+/**
+ * @brief Sends the exact final result of the running game.
+ * * Sends "REV PREDICT <Winner> <Margin>" (winner 1, 2 or 3 for a draw,
+ * margin in discs) once the endgame solver proved the outcome with
+ * perfect play from both sides.
+ * * @param clientSocket The socket descriptor of the target client.
+ * @param winner Predicted winner, same codes as "REV END".
+ * @param margin Predicted disc difference between the players.
+ * @return 0 on success, -1 on failure.
+ */
+int sendPrediction(int clientSocket, int winner, int margin);
\ No newline at end of file
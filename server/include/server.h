@@ -1,4 +1,5 @@
 #pragma once
+#include "../include/player.h"
 #include <string>
 
 /**
@@ -6,7 +7,8 @@
  * * 1. Creates the server socket.
  * 2. Binds to PORT.
  * 3. Listens for incoming connections.
- * 4. Spawns a new thread (handleClientLogic) for each connected client.
+ * 4. Spawns a new thread (handleClientLogic) for each connected client,
+ * or with --io=epoll serves every client from one reactor (runEpollServer).
  */
 void startServer(std::string ip, int port);
 
@@ -16,4 +18,24 @@ void startServer(std::string ip, int port);
  * and managing the lifecycle of the Player object (memory allocation/cleanup).
  * * @param clientSocket The file descriptor for the connected client.
  */
-void handleClientLogic(int clientSocket);
\ No newline at end of file
+void handleClientLogic(int clientSocket);
+
+/**
+ * @brief Adds an accepted socket to clientSockets (and turns Nagle off).
+ */
+void registerClient(int clientSocket);
+
+/**
+ * @brief Removes a closed socket from clientSockets.
+ */
+void unregisterClient(int clientSocket);
+
+/**
+ * @brief Detaches a disconnected client from its lobby.
+ * * A running game is paused and the opponent is notified, the Player then
+ * stays owned by the lobby for a reconnect. Otherwise the Player is deleted.
+ * Does not close the socket.
+ * @param clientSocket The socket of the disconnected client.
+ * @param player The client's Player, may be nullptr (nothing received yet).
+ */
+void releaseClient(int clientSocket, Player *player);
\ No newline at end of file
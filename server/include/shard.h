@@ -0,0 +1,96 @@
+#pragma once
+#include <functional>
+#include <mutex>
+
+class Lobby;
+
+// Routing results of selectMessageShard besides a shard index
+#define SHARD_LOCAL -1
+#define SHARD_REJECT -2
+
+/**
+ * @brief Lobby ownership for the multi-reactor server (--reactors=N).
+ * * With N > 1 reactor shards, lobby i belongs to shard i % N and its state
+ * is only touched by that shard's thread: a client sitting in a lobby is
+ * served by the lobby's shard, and everything else reaches the lobby
+ * through the shard's mailbox (runOnLobbyOwner). No global lock is taken.
+ * * With a single reactor (or the thread/io_uring modes) there is no
+ * ownership: tasks run on the calling thread and LobbyLock takes the
+ * lobby's own mutex.
+ */
+
+/**
+ * @brief Sets up `count` shard mailboxes, before any shard runs.
+ * @param count Number of reactor shards, 1 disables the ownership rules.
+ */
+void initShards(int count);
+
+bool lobbiesSharded();
+
+int getShardCount();
+
+int getLobbyOwner(int lobbyId);
+
+/**
+ * @brief Shard served by the calling thread, -1 outside the reactors.
+ */
+int getCurrentShard();
+
+void setCurrentShard(int shard);
+
+/**
+ * @brief True if the calling thread may touch the lobby (always when unsharded).
+ */
+bool isLobbyLocal(int lobbyId);
+
+/**
+ * @brief Runs `task` where the lobby's state may be touched.
+ * * Inline when unsharded or already on the owning shard, otherwise queued
+ * to the owner's mailbox and the call returns at once.
+ */
+void runOnLobbyOwner(int lobbyId, std::function<void()> task);
+
+/**
+ * @brief Same as runOnLobbyOwner, but waits until `task` has run.
+ * * For threads outside the reactors (bot pool). A shard waiting for
+ * another shard could deadlock, shards use runOnLobbyOwner.
+ */
+void runOnLobbyOwnerAndWait(int lobbyId, std::function<void()> task);
+
+/**
+ * @brief Queues `task` for a shard and wakes it up.
+ */
+void postToShard(int shard, std::function<void()> task);
+
+/**
+ * @brief eventfd the shard's reactor polls, readable when tasks are queued.
+ */
+int getShardWakeFd(int shard);
+
+/**
+ * @brief Runs the queued tasks of a shard (called by its reactor thread).
+ */
+void runShardMailbox(int shard);
+
+/**
+ * @brief True while the calling thread holds a LobbyLock.
+ */
+bool holdsLobbyLock();
+
+/**
+ * @brief Exclusive access to one lobby.
+ * * Locks the lobby's mutex unless the lobbies are sharded, then the
+ * owning shard is the only thread touching a lobby and nothing is locked.
+ * Games in different lobbies never wait for each other. Hold one at a
+ * time: nothing orders the locks of two lobbies.
+ * * Lobby directory changes made while it is held are sent out once it is
+ * released (flushLobbyDirectory), not while the lobby waits.
+ */
+class LobbyLock {
+public:
+    explicit LobbyLock(Lobby& lobby);
+    ~LobbyLock();
+
+private:
+    std::unique_lock<std::mutex> lock;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+
+enum SimdLevel {
+      SIMD_SCALAR,   // Portable shift/mask loop from gameLogic.cpp
+      SIMD_SSE2,     // 2 directions per vector (one axis, both ways)
+      SIMD_AVX2,     // 4 directions per vector, 2 vectors
+      SIMD_AVX512    // All 8 directions in one vector
+};
+
+typedef uint64_t (*MoveMaskKernel)(uint64_t own, uint64_t opp);
+typedef uint64_t (*FlipMaskKernel)(int square, uint64_t own, uint64_t opp);
+
+// Kernels used by getMoveMask/getFlipMask, scalar until initMoveKernels runs.
+extern MoveMaskKernel activeMoveMaskKernel;
+extern FlipMaskKernel activeFlipMaskKernel;
+
+/**
+ * @brief Detects the best instruction set usable on this CPU.
+ * * Reads the CPUID feature bits and checks with XGETBV that the OS
+ * saves the wide registers, so AVX2/AVX-512 are only reported when usable.
+ */
+SimdLevel detectSimdLevel();
+
+/**
+ * @brief Selects the move generator used by the game logic.
+ * * Picks the best level supported by the CPU (capped by maxLevel) and
+ * runs the self-check against the scalar kernels. A level that fails the
+ * check is skipped and the next lower one is tried.
+ * @param maxLevel Highest level allowed (e.g. to force the scalar path).
+ * @return The level that is now active.
+ */
+SimdLevel initMoveKernels(SimdLevel maxLevel);
+
+/**
+ * @brief Compares the kernels of a level with the scalar ones.
+ * * Uses positions from deterministic random playouts, comparing legal
+ * move masks and the flips of every legal and some illegal squares.
+ * @return true when every result matches.
+ */
+bool selfCheckMoveKernels(SimdLevel level);
+
+SimdLevel getMoveKernelLevel();
+
+const char* getSimdLevelName(SimdLevel level);
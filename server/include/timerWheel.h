@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#define TIMER_TICK_MS 100
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+// 4 levels of 64 slots at 100 ms: up to 64^4 ticks (about 19 days) ahead
+#define TIMER_WHEEL_LEVELS 4
+
+typedef void (*TimerCallback)(void *context);
+
+/**
+ * @brief A deadline kept by a TimerWheel, embedded in the object it belongs to.
+ * * Scheduling, rescheduling and cancelling only relink the timer, nothing
+ * is allocated. A destroyed timer unlinks itself.
+ */
+class Timer {
+public:
+    Timer();
+    ~Timer();
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    /**
+     * @brief Sets what runs when the timer expires.
+     * * The callback may destroy the timer (and its owner), it is not
+     * touched by the wheel after the call.
+     */
+    void setCallback(TimerCallback function, void *context);
+
+    void cancel();
+
+    bool isScheduled() const { return next != nullptr; }
+
+private:
+    friend class TimerWheel;
+
+    Timer *prev;
+    Timer *next;
+    uint64_t expires;   // Tick the timer is due at
+    TimerCallback callback;
+    void *context;
+};
+
+/**
+ * @brief Hierarchical timing wheel (4 levels of 64 slots, TIMER_TICK_MS ticks).
+ * * schedule and cancel are O(1). advance visits one slot per elapsed tick
+ * and moves the timers of a coarser level down once per lap of the finer
+ * one, so the cost does not depend on how many timers are pending. A
+ * timer fires at the first tick at or after its deadline.
+ * * Not thread-safe: every wheel belongs to one thread (a reactor) or is
+ * locked by its owner.
+ */
+class TimerWheel {
+public:
+    TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief (Re)arms `timer` to fire `delayMs` from now.
+     */
+    void schedule(Timer& timer, long delayMs);
+
+    /**
+     * @brief Runs the callbacks of every timer due by `now`.
+     */
+    void advance(std::chrono::steady_clock::time_point now);
+
+private:
+    Timer slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];   // List heads (circular)
+    uint64_t currentTick;                                  // Next tick to process
+    std::chrono::steady_clock::time_point start;
+
+    static void splice(Timer& from, Timer& to);
+    void insert(Timer& timer);
+    void cascade(int level, int slot);
+    void runSlot(int slot);
+};
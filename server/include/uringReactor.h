@@ -0,0 +1,24 @@
+#pragma once
+
+#define URING_QUEUE_DEPTH 4096
+#define URING_BUFFER_COUNT 1024      // Provided receive buffers (power of two)
+#define URING_BUFFER_SIZE 4096
+#define URING_BUFFER_GROUP 1
+
+/**
+ * @brief Serves every client through io_uring (--io=uring).
+ * * One multishot accept feeds the connections, each connection has one
+ * multishot recv that picks its buffers from a registered provided-buffer
+ * ring, so a steady client costs no syscall per message. Messages sent
+ * meanwhile (sendMessage, also from the bot pool) are queued per client
+ * and submitted as one batch of IORING_OP_SEND per loop iteration,
+ * together with waiting for the next completions. The io_uring queues are
+ * driven with raw syscalls, liburing is not needed.
+ * * Complete lines go to handleMessage exactly as in the other modes,
+ * clients silent for CLIENT_TIMEOUT_SEC are disconnected.
+ * @param serverSocket A bound, listening socket.
+ * @return false right away when io_uring (or one of the features above)
+ * is not available, the caller then falls back to epoll. Never returns
+ * otherwise, unless the ring fails.
+ */
+bool runUringServer(int serverSocket);
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed set of threads with one task deque per thread.
+ * * A worker pops its own deque from the back (newest first, good cache
+ * locality for tasks it spawned itself) and steals from the front of the
+ * other deques when it runs dry. Tasks submitted from outside the pool
+ * are spread round-robin. The thread count never changes, so the pool
+ * size is a hard cap on the CPU time spent by everything running in it.
+ */
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threadCount);
+    ~WorkStealingPool();
+
+    /**
+     * @brief Queues a task. From a pool thread it goes to that thread's deque.
+     */
+    void submit(std::function<void()> task);
+
+    int getThreadCount() const;
+
+    /**
+     * @brief Workers currently waiting for work (a hint, may change any time).
+     */
+    int getIdleCount() const;
+
+    /**
+     * @brief Index of the calling pool thread, -1 outside the pool.
+     */
+    static int currentWorkerIndex();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::atomic<int> pending;
+    std::atomic<int> idle;
+    std::atomic<unsigned> nextWorker;
+    std::atomic<bool> stopping;
+
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+
+    void run(int index);
+    bool takeTask(int index, std::function<void()>& task);
+};
@@ -1,9 +1,70 @@
 #include "./include/server.h" // Include the server header
+#include "./include/global.h"
 #include <iostream>
 #include <string>
 #include <stdexcept>
 #include <signal.h>
 
+#define USAGE_OPTIONS " [<IP> <PORT>] [--bot-time-ms=N] [--bot-threads=N] [--smp-helpers=N] [--endgame-empties=N] [--book=PATH] [--record-games=PATH] [--cache-entries=N] [--io=threads|epoll|uring] [--reactors=N] [--reconnect-grace-sec=N]"
+
+// Parses "--name=value" options into serverConfig, false if unknown/invalid
+static bool parseServerOption(const std::string& option) {
+    size_t eq = option.find('=');
+    if (option.rfind("--", 0) != 0 || eq == std::string::npos) return false;
+
+    std::string name = option.substr(2, eq - 2);
+    std::string value = option.substr(eq + 1);
+
+    try {
+        if (name == "bot-time-ms") {
+            serverConfig.botMoveTimeMs = std::stoi(value);
+            return serverConfig.botMoveTimeMs > 0;
+        }
+        if (name == "bot-threads") {
+            serverConfig.botThreads = std::stoi(value);
+            return serverConfig.botThreads > 0;
+        }
+        if (name == "smp-helpers") {
+            serverConfig.smpHelpers = std::stoi(value);
+            return serverConfig.smpHelpers >= 0;
+        }
+        if (name == "endgame-empties") {
+            serverConfig.endgameEmpties = std::stoi(value);
+            return serverConfig.endgameEmpties >= 0 && serverConfig.endgameEmpties <= 64;
+        }
+        if (name == "book") {
+            serverConfig.bookPath = value;
+            return true;
+        }
+        if (name == "record-games") {
+            serverConfig.gamesPath = value;
+            return true;
+        }
+        if (name == "cache-entries") {
+            serverConfig.cacheEntries = std::stoi(value);
+            return serverConfig.cacheEntries > 0;
+        }
+        if (name == "io") {
+            if (value == "threads") serverConfig.ioMode = IO_THREADS;
+            else if (value == "epoll") serverConfig.ioMode = IO_EPOLL;
+            else if (value == "uring") serverConfig.ioMode = IO_URING;
+            else return false;
+            return true;
+        }
+        if (name == "reactors") {
+            serverConfig.reactorCount = std::stoi(value);
+            return serverConfig.reactorCount > 0;
+        }
+        if (name == "reconnect-grace-sec") {
+            serverConfig.reconnectGraceSec = std::stoi(value);
+            return serverConfig.reconnectGraceSec >= 0;
+        }
+    } catch (const std::exception& e) {
+        return false;
+    }
+    return false;
+}
+
 int main(int argc, char* argv[]) {
 
     signal(SIGPIPE, SIG_IGN);
@@ -12,16 +73,23 @@ int main(int argc, char* argv[]) {
         std::string serverIP = "";
         int serverPort = 0;
 
-        if (argc == 3) {
+        int argIndex = 1;
+
+        if (argc >= 3 && argv[1][0] != '-') {
             serverIP = argv[1];
             try {
                 serverPort = std::stoi(argv[2]);
             } catch (const std::exception& e) {
                 throw std::runtime_error("Invalid port number provided.");
             }
-        } else if (argc != 1) {
-            std::cout << "[WARNING] Usage: " << argv[0] << " <IP> <PORT>" << std::endl;
-            return 1;
+            argIndex = 3;
+        }
+
+        for (; argIndex < argc; ++argIndex) {
+            if (!parseServerOption(argv[argIndex])) {
+                std::cout << "[WARNING] Usage: " << argv[0] << USAGE_OPTIONS << std::endl;
+                return 1;
+            }
         }
 
         startServer(serverIP, serverPort);
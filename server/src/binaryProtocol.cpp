@@ -0,0 +1,306 @@
+#include "../include/binaryProtocol.h"
+#include "../include/boardGeometry.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+static std::shared_mutex binaryClientsMutex;
+static std::unordered_set<int> binaryClients;
+static std::atomic<int> binaryClientCount(0);   // Lets text-only servers skip the lookup
+
+static int readU8(std::string_view payload, size_t offset) {
+    return (unsigned char)payload[offset];
+}
+
+static int readU16(std::string_view payload, size_t offset) {
+    return (unsigned char)payload[offset] | (unsigned char)payload[offset + 1] << 8;
+}
+
+// Lobby ids are u32, larger than an int allows means an invalid id (negative)
+static int readU32(std::string_view payload, size_t offset) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) value = value << 8 | (unsigned char)payload[offset + i];
+    return (int)value;
+}
+
+bool decodeBinaryFrame(std::string_view frame, ClientCommand& command) {
+    if (frame.empty()) return false;
+
+    std::string_view payload = frame.substr(1);
+    size_t size = payload.size();
+    bool valid = true;
+    command.argCount = 0;
+
+    switch ((unsigned char)frame[0]) {
+        case OP_HEARTBEAT:
+            command.command = CMD_HEARTBEAT;
+            valid = size == 0;
+            break;
+        case OP_JOIN:
+            command.command = CMD_JOIN;
+            valid = size == 4 || size == 5;
+            if (valid) {
+                command.args[command.argCount++] = readU32(payload, 0);
+                if (size == 5) command.args[command.argCount++] = readU8(payload, 4);
+            }
+            break;
+        case OP_BOT:
+            command.command = CMD_BOT;
+            valid = size == 0 || size == 4;
+            if (valid && size == 4) command.args[command.argCount++] = readU32(payload, 0);
+            break;
+        case OP_EXIT:
+        case OP_REMATCH:
+        case OP_RESYNC:
+        case OP_WATCH:
+            switch ((unsigned char)frame[0]) {
+                case OP_EXIT: command.command = CMD_EXIT; break;
+                case OP_REMATCH: command.command = CMD_REMATCH; break;
+                case OP_RESYNC: command.command = CMD_RESYNC; break;
+                default: command.command = CMD_WATCH; break;
+            }
+            valid = size == 4;
+            if (valid) command.args[command.argCount++] = readU32(payload, 0);
+            break;
+        case OP_QUEUE:
+            command.command = CMD_QUEUE;
+            valid = size == 0 || size == 1 || size == 3;
+            if (valid && size >= 1) command.args[command.argCount++] = readU8(payload, 0);
+            if (valid && size == 3) command.args[command.argCount++] = readU16(payload, 1);
+            break;
+        case OP_MOVE:
+            command.command = CMD_MOVE;
+            valid = size == 6;
+            if (valid) {
+                command.args[command.argCount++] = readU8(payload, 0);
+                command.args[command.argCount++] = readU8(payload, 1);
+                command.args[command.argCount++] = readU32(payload, 2);
+            }
+            break;
+        default:
+            return false;
+    }
+
+    command.name = commandName(command.command);
+    if (valid) {
+        command.numericCount = command.argCount;
+    } else {
+        // Rejected by the handler like a malformed text argument
+        command.argCount = 1;
+        command.numericCount = 0;
+    }
+    for (int i = 0; i < command.argCount; i++) command.text[i] = std::string_view();
+    return true;
+}
+
+static void beginFrame(std::string& frame, int opcode) {
+    frame.assign(FRAME_LENGTH_SIZE, '\0');
+    frame += (char)opcode;
+}
+
+static void putU8(std::string& frame, int value) {
+    frame += (char)(value & 0xFF);
+}
+
+static void putU32(std::string& frame, unsigned long value) {
+    for (int i = 0; i < 4; i++) frame += (char)((value >> (8 * i)) & 0xFF);
+}
+
+static void putName(std::string& frame, std::string_view name) {
+    size_t length = std::min(name.size(), (size_t)255);
+    putU8(frame, (int)length);
+    frame.append(name.data(), length);
+}
+
+static void endFrame(std::string& frame) {
+    size_t length = frame.size() - FRAME_LENGTH_SIZE;
+    frame[0] = (char)(length & 0xFF);
+    frame[1] = (char)((length >> 8) & 0xFF);
+}
+
+// "REV STATE <digits> <score1> <score2> <status> <version>": the digits become three bitboards
+static bool encodeState(std::string& frame, const ParsedMessage& parsed) {
+    std::string_view cells = parsed.arg(2);
+    int score1, score2, status, version;
+    if (!parseInt(parsed.arg(3), score1) || !parseInt(parsed.arg(4), score2) || !parseInt(parsed.arg(5), status)
+        || !parseInt(parsed.arg(6), version)) return false;
+
+    size_t bytes = (cells.size() + 7) / 8;
+    size_t offset = frame.size();
+    frame.append(3 * bytes, '\0');
+    for (size_t square = 0; square < cells.size(); square++) {
+        int cell = cells[square] - '0';
+        if (cell < 0 || cell > 3) return false;
+        if (cell == 0) continue;
+        frame[offset + (cell - 1) * bytes + square / 8] |= (char)(1 << (square % 8));
+    }
+    putU8(frame, score1);
+    putU8(frame, score2);
+    putU8(frame, status);
+    putU32(frame, (unsigned long)version);
+    return true;
+}
+
+// "3,12,40" or "-" as a count and one byte per square
+static bool putSquareList(std::string& frame, std::string_view list) {
+    size_t countOffset = frame.size();
+    putU8(frame, 0);
+    if (list == "-") return true;
+
+    int count = 0;
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        int square;
+        if (!parseInt(list.substr(0, comma), square)) return false;
+        putU8(frame, square);
+        count++;
+        list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+    }
+    frame[countOffset] = (char)count;
+    return true;
+}
+
+// "REV DELTA <version> <square> <flips> <hints> <score1> <score2> <status>"
+static bool encodeDelta(std::string& frame, const ParsedMessage& parsed) {
+    int version, square, score1, score2, status;
+    if (!parseInt(parsed.arg(2), version) || !parseInt(parsed.arg(3), square) || !parseInt(parsed.arg(6), score1)
+        || !parseInt(parsed.arg(7), score2) || !parseInt(parsed.arg(8), status)) return false;
+
+    putU32(frame, (unsigned long)version);
+    putU8(frame, square);
+    if (!putSquareList(frame, parsed.arg(4)) || !putSquareList(frame, parsed.arg(5))) return false;
+    putU8(frame, score1);
+    putU8(frame, score2);
+    putU8(frame, status);
+    return true;
+}
+
+static bool encodeKnownMessage(std::string& frame, const ParsedMessage& parsed) {
+    std::string_view word = parsed.arg(1);
+    int count = parsed.tokenCount;
+    int first, second;
+
+    if (word == "DELTA" && count == 9) {
+        beginFrame(frame, OP_DELTA);
+        return encodeDelta(frame, parsed);
+    }
+    if (word == "STATE" && count == 7) {
+        beginFrame(frame, OP_STATE);
+        return encodeState(frame, parsed);
+    }
+    if (word == "HEARTPOP" || word == "PASS" || word == "RECONNECT") {
+        if (count != 2) return false;
+        beginFrame(frame, word == "HEARTPOP" ? OP_HEARTPOP : word == "PASS" ? OP_PASS : OP_RECONNECT);
+        return true;
+    }
+    if (word == "LOBBY" && count == 3 && parseInt(parsed.arg(2), first)) {
+        beginFrame(frame, OP_LOBBY);
+        putU32(frame, (unsigned long)first);
+        return true;
+    }
+    if ((word == "CONNECT" || word == "END" || word == "DISCONNECT") && count == 3 && parseInt(parsed.arg(2), first)) {
+        beginFrame(frame, word == "CONNECT" ? OP_CONNECT : word == "END" ? OP_END : OP_DISCONNECT);
+        putU8(frame, first);
+        return true;
+    }
+    if (word == "PREDICT" && count == 4 && parseInt(parsed.arg(2), first) && parseInt(parsed.arg(3), second)) {
+        beginFrame(frame, OP_PREDICT);
+        putU8(frame, first);
+        putU8(frame, second);
+        return true;
+    }
+    // "REV START <status> <player1> <player2> <lobby> <size>"
+    int lobbyId, size;
+    if (word == "START" && count == 7 && parseInt(parsed.arg(2), first)
+        && parseInt(parsed.arg(5), lobbyId) && parseInt(parsed.arg(6), size)) {
+        beginFrame(frame, OP_START);
+        putU8(frame, first);
+        putU32(frame, (unsigned long)lobbyId);
+        putU8(frame, size);
+        putName(frame, parsed.arg(3));
+        putName(frame, parsed.arg(4));
+        return true;
+    }
+    return false;
+}
+
+std::string encodeBinaryMessage(const std::string& message) {
+    std::string_view line(message);
+    if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+
+    ParsedMessage parsed;
+    parseMessage(line, parsed);
+
+    std::string frame;
+    frame.reserve(FRAME_LENGTH_SIZE + 1 + line.size());
+    if (parsed.tokenCount < 2 || parsed.arg(0) != "REV" || !encodeKnownMessage(frame, parsed)) {
+        beginFrame(frame, OP_TEXT);
+        frame.append(line.data(), line.size());
+    }
+    endFrame(frame);
+    return frame;
+}
+
+static void putBitboard(std::string& frame, unsigned __int128 bits, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) putU8(frame, (int)(uint8_t)(bits >> (8 * i)));
+}
+
+static void putSquares(std::string& frame, unsigned __int128 squares) {
+    size_t countOffset = frame.size();
+    putU8(frame, 0);
+    int count = 0;
+    for (; squares; squares &= squares - 1, count++) putU8(frame, lowestSquare(squares));
+    frame[countOffset] = (char)count;
+}
+
+std::string encodeStateFrame(unsigned __int128 player1, unsigned __int128 player2, unsigned __int128 hints, int cells,
+                             int score1, int score2, int status, unsigned long version) {
+    size_t bytes = (size_t)(cells + 7) / 8;
+    std::string frame;
+    frame.reserve(FRAME_LENGTH_SIZE + 1 + 3 * bytes + 7);
+    beginFrame(frame, OP_STATE);
+    putBitboard(frame, player1, bytes);
+    putBitboard(frame, player2, bytes);
+    putBitboard(frame, hints, bytes);
+    putU8(frame, score1);
+    putU8(frame, score2);
+    putU8(frame, status);
+    putU32(frame, version);
+    endFrame(frame);
+    return frame;
+}
+
+std::string encodeDeltaFrame(unsigned long version, int square, unsigned __int128 flipped, unsigned __int128 hints,
+                             int score1, int score2, int status) {
+    std::string frame;
+    frame.reserve(64);
+    beginFrame(frame, OP_DELTA);
+    putU32(frame, version);
+    putU8(frame, square);
+    putSquares(frame, flipped);
+    putSquares(frame, hints);
+    putU8(frame, score1);
+    putU8(frame, score2);
+    putU8(frame, status);
+    endFrame(frame);
+    return frame;
+}
+
+void setBinaryClient(int clientSocket, bool binary) {
+    std::unique_lock<std::shared_mutex> lock(binaryClientsMutex);
+    if (binary) {
+        if (binaryClients.insert(clientSocket).second) binaryClientCount++;
+    } else if (binaryClients.erase(clientSocket) > 0) {
+        binaryClientCount--;
+    }
+}
+
+bool isBinaryClient(int clientSocket) {
+    if (binaryClientCount.load(std::memory_order_relaxed) == 0) return false;
+
+    std::shared_lock<std::shared_mutex> lock(binaryClientsMutex);
+    return binaryClients.count(clientSocket) > 0;
+}
@@ -0,0 +1,324 @@
+#include "../include/bot.h"
+#include "../include/engine.h"
+#include "../include/endgame.h"
+#include "../include/openingBook.h"
+#include "../include/handler.h"
+#include "../include/sender.h"
+#include "../include/global.h"
+#include "../include/workStealing.h"
+#include "../include/shard.h"
+#include "../include/outbox.h"
+#include <iostream>
+#include <sstream>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+// 2^21 slots * 16 bytes = 32 MB, shared by every search thread
+#define BOT_TT_SIZE_LOG2 21
+#define BOT_MAX_DEPTH 60
+// Exact scores are kept apart from the heuristic ones, 2^20 slots = 16 MB
+#define ENDGAME_TT_SIZE_LOG2 20
+// Share of the move budget the solver may use before falling back to the search
+#define ENDGAME_BUDGET_PERCENT 75
+#define PREDICTION_TIME_MS 5000
+// Book moves need this many recorded games behind them
+#define BOOK_MIN_GAMES 2
+
+static WorkStealingPool *searchPool = nullptr;
+static TranspositionTable *sharedTable = nullptr;
+static TranspositionTable *endgameTable = nullptr;
+static OpeningBook openingBook;
+
+// Score predictions, served by their own thread in request order
+static std::mutex predictionMutex;
+static std::condition_variable predictionCv;
+static std::deque<int> predictionQueue;
+static std::unordered_map<int, unsigned long> pendingPredictions;   // Lobby -> version to solve
+static int solvingLobby = -1;
+static std::atomic<bool> predictionStop(false);
+
+// State shared by the main search of one bot move and its Lazy SMP helpers
+struct ParallelSearch {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<bool> stop;
+    bool finished;
+    int activeHelpers;
+    std::vector<SearchResult> helperResults;
+
+    ParallelSearch() : stop(false), finished(false), activeHelpers(0) {}
+};
+
+static void runHelper(std::shared_ptr<ParallelSearch> search, Board board, int player, int helperId, int budgetMs, int firstMove) {
+    {
+        std::lock_guard<std::mutex> lock(search->mutex);
+        if (search->finished) return; // Stolen too late, the move is already played
+        search->activeHelpers++;
+    }
+
+    SearchLimits limits = {budgetMs, BOT_MAX_DEPTH, 1 + helperId, &search->stop, firstMove};
+    SearchResult result = searchBestMove(board, player, limits, *sharedTable);
+
+    {
+        std::lock_guard<std::mutex> lock(search->mutex);
+        search->helperResults.push_back(result);
+        search->activeHelpers--;
+    }
+    search->cv.notify_all();
+}
+
+static std::string formatRate(const SearchResult &result) {
+    double rate = result.seconds > 0 ? result.nodes / result.seconds : 0;
+    std::ostringstream out;
+    out << result.nodes << " nodes, " << (long long)rate << " n/s";
+    return out.str();
+}
+
+static void finishBotMove(int lobbyId, int square, unsigned long version) {
+    // Played by the lobby's shard, the search thread does not wait for it
+    runOnLobbyOwner(lobbyId, [lobbyId, square, version] {
+        MessageBatch batch;
+
+        // Refused if the game was paused, restarted or reset in the meantime
+        handleMoving(square % 8, square / 8, BOT_SOCKET, lobbyId, version);
+
+        Lobby *found = findLobby(lobbyId);
+        if (found == nullptr) return;
+        LobbyLock lock(*found);
+        Lobby &lobby = *found;
+        if (lobby.getStatus() == ENDED_STATUS && lobby.getStateVersion() == version + 1) {
+            Player *p1 = lobby.getPlayer1();
+            Player *p2 = lobby.getPlayer2();
+            if (p1) p1->state = STATE_GAME_OVER;
+            if (p2) p2->state = STATE_GAME_OVER;
+        }
+    });
+}
+
+static void predictFinalScore(int lobbyId, unsigned long version) {
+    Board board;
+    int player;
+    bool playing = false;
+
+    runOnLobbyOwnerAndWait(lobbyId, [&] {
+        Lobby *found = findLobby(lobbyId);
+        if (found == nullptr) return;
+        LobbyLock lock(*found);
+        Lobby &lobby = *found;
+        if (lobby.getStateVersion() != version) return; // Moved on before the solve started
+        player = lobby.getStatus();
+        if (player != 1 && player != 2) return;
+
+        const Board *current = lobby.getBoard();
+        if (current == nullptr) return; // The solver plays 8x8 only
+        board = *current;
+        playing = true;
+    });
+    if (!playing) return;
+
+    CachedSolve solved;
+    double seconds = 0;
+    if (!positionCache->getSolved(board, player, solved)) {
+        EndgameResult result = solveEndgame(board, player, PREDICTION_TIME_MS, &predictionStop, *endgameTable);
+        if (!result.solved) return;
+
+        solved = {result.square, result.score};
+        seconds = result.seconds;
+        positionCache->storeSolved(board, player, solved);
+    }
+
+    // Solver scores are for the side to move, messages use player 1's view
+    int margin = player == 1 ? solved.score : -solved.score;
+    int winner = margin > 0 ? 1 : (margin < 0 ? 2 : 3);
+
+    int clientSocket1 = -1, clientSocket2 = -1;
+    bool upToDate = false;
+    runOnLobbyOwnerAndWait(lobbyId, [&] {
+        Lobby *found = findLobby(lobbyId);
+        if (found == nullptr) return;
+        LobbyLock lock(*found);
+        Lobby &lobby = *found;
+        if (lobby.getStateVersion() != version) return; // Already outdated
+        clientSocket1 = lobby.getPlayerSocket1();
+        clientSocket2 = lobby.getPlayerSocket2();
+        upToDate = true;
+    });
+    if (!upToDate) return;
+
+    std::cout << "[LOBBY " << lobbyId << "] Solved: player " << winner << " by " << std::abs(margin)
+              << " (" << board.empties << " empties, " << (int)(seconds * 1000) << " ms)" << std::endl;
+    sendPrediction(clientSocket1, winner, std::abs(margin));
+    sendPrediction(clientSocket2, winner, std::abs(margin));
+}
+
+static void runPredictions() {
+    std::unique_lock<std::mutex> lock(predictionMutex);
+    while (true) {
+        predictionCv.wait(lock, [] { return !predictionQueue.empty(); });
+        int lobbyId = predictionQueue.front();
+        predictionQueue.pop_front();
+        unsigned long version = pendingPredictions[lobbyId];
+        pendingPredictions.erase(lobbyId);
+        solvingLobby = lobbyId;
+        predictionStop = false;
+
+        lock.unlock();
+        predictFinalScore(lobbyId, version);
+        lock.lock();
+        solvingLobby = -1;
+    }
+}
+
+static void playBotMove(int lobbyId) {
+    Board board;
+    int player;
+    unsigned long version;
+    bool botTurn = false;
+
+    runOnLobbyOwnerAndWait(lobbyId, [&] {
+        Lobby *found = findLobby(lobbyId);
+        if (found == nullptr) return;
+        LobbyLock lock(*found);
+        Lobby &lobby = *found;
+        if (!lobby.isBotTurn()) return;
+
+        const Board *current = lobby.getBoard();
+        if (current == nullptr) return;
+        board = *current;
+        player = lobby.getStatus();
+        version = lobby.getStateVersion();
+        botTurn = true;
+    });
+    if (!botTurn) return;
+
+    // Known openings are played straight from the book
+    int bookMove = openingBook.lookup(board, player, BOOK_MIN_GAMES);
+    if (bookMove >= 0) {
+        std::cout << "[BOT] Lobby " << lobbyId << ": move " << bookMove % 8 << "," << bookMove / 8 << " from the book" << std::endl;
+        finishBotMove(lobbyId, bookMove, version);
+        return;
+    }
+
+    // Positions already solved (rematch, other lobbies) are not solved again
+    CachedSolve cachedSolve;
+    if (positionCache->getSolved(board, player, cachedSolve) && cachedSolve.square >= 0) {
+        std::cout << "[BOT] Lobby " << lobbyId << ": move " << cachedSolve.square % 8 << "," << cachedSolve.square / 8
+                  << " solved (cached), final margin " << cachedSolve.score << std::endl;
+        finishBotMove(lobbyId, cachedSolve.square, version);
+        return;
+    }
+    // A cached evaluation may come from a shallow search, its move is only searched first
+    CachedEvaluation cachedEvaluation;
+    int firstMove = -1;
+    if (positionCache->getEvaluation(board, player, cachedEvaluation)) firstMove = cachedEvaluation.square;
+
+    // Heavy part, no lock held. Close to the end the solver plays perfectly,
+    // if it runs out of time the search below gets the rest of the budget.
+    int budgetMs = serverConfig.botMoveTimeMs;
+    if (board.empties <= serverConfig.endgameEmpties) {
+        EndgameResult solved = solveEndgame(board, player, budgetMs * ENDGAME_BUDGET_PERCENT / 100, nullptr, *endgameTable);
+        if (solved.solved && solved.square >= 0) {
+            std::cout << "[BOT] Lobby " << lobbyId << ": move " << solved.square % 8 << "," << solved.square / 8
+                      << " solved, final margin " << solved.score << " in " << (int)(solved.seconds * 1000) << " ms ("
+                      << solved.nodes << " nodes)" << std::endl;
+            positionCache->storeSolved(board, player, CachedSolve{solved.square, solved.score});
+            finishBotMove(lobbyId, solved.square, version);
+            return;
+        }
+        budgetMs = std::max(1, budgetMs - (int)(solved.seconds * 1000));
+    }
+
+    // Helpers only use threads that are idle right now
+    std::shared_ptr<ParallelSearch> search = std::make_shared<ParallelSearch>();
+    int helpers = std::min(serverConfig.smpHelpers, searchPool->getIdleCount());
+    for (int i = 1; i <= helpers; ++i) {
+        searchPool->submit([search, board, player, i, budgetMs, firstMove] { runHelper(search, board, player, i, budgetMs, firstMove); });
+    }
+
+    SearchLimits limits = {budgetMs, BOT_MAX_DEPTH, 1, &search->stop, firstMove};
+    SearchResult result = searchBestMove(board, player, limits, *sharedTable);
+
+    std::vector<SearchResult> helperResults;
+    {
+        std::unique_lock<std::mutex> lock(search->mutex);
+        search->stop = true;
+        search->finished = true;
+        search->cv.wait(lock, [&search] { return search->activeHelpers == 0; });
+        helperResults = search->helperResults;
+    }
+
+    // A helper that completed a deeper iteration knows better
+    std::ostringstream threads;
+    threads << "main: " << formatRate(result);
+    SearchResult best = result;
+    for (size_t i = 0; i < helperResults.size(); ++i) {
+        threads << " | helper " << i + 1 << ": " << formatRate(helperResults[i]);
+        if (helperResults[i].square >= 0 && helperResults[i].depth > best.depth) {
+            best = helperResults[i];
+        }
+    }
+    if (best.square < 0) return;
+
+    std::cout << "[BOT] Lobby " << lobbyId << ": move " << best.square % 8 << "," << best.square / 8
+              << " depth " << best.depth << " score " << best.score
+              << " in " << (int)(result.seconds * 1000) << " ms (" << threads.str() << ")" << std::endl;
+
+    positionCache->storeEvaluation(board, player, CachedEvaluation{best.square, best.score, best.depth});
+    finishBotMove(lobbyId, best.square, version);
+}
+
+void startBotService(int workerCount) {
+    if (workerCount < 1) workerCount = 1;
+
+    sharedTable = new TranspositionTable(BOT_TT_SIZE_LOG2);
+    endgameTable = new TranspositionTable(ENDGAME_TT_SIZE_LOG2);
+    searchPool = new WorkStealingPool(workerCount);
+    std::thread(runPredictions).detach();
+
+    if (serverConfig.bookPath.empty()) {
+        std::cout << "[BOT] No opening book" << std::endl;
+    } else if (openingBook.open(serverConfig.bookPath)) {
+        std::cout << "[BOT] Opening book " << serverConfig.bookPath << ": " << openingBook.size() << " moves" << std::endl;
+    } else {
+        std::cout << "[BOT] Opening book " << serverConfig.bookPath << " not loaded, searching every move" << std::endl;
+    }
+
+    std::cout << "[BOT] " << workerCount << " search thread(s) max, up to " << serverConfig.smpHelpers
+              << " helper(s) per move, " << serverConfig.botMoveTimeMs << " ms per move, exact play from "
+              << serverConfig.endgameEmpties << " empties" << std::endl;
+}
+
+void requestBotMove(int lobbyId) {
+    if (!isValidLobbyId(lobbyId)) return;
+
+    // A fast answer (book, cached solve) must not overtake the STATE of the move before it
+    runAfterBatch([lobbyId] { searchPool->submit([lobbyId] { playBotMove(lobbyId); }); });
+}
+
+// Called once the batch holding the move's STATE/DELTA is written, PREDICT follows it
+static void queueScorePrediction(int lobbyId, unsigned long version) {
+    std::lock_guard<std::mutex> lock(predictionMutex);
+    // The position being solved is outdated now
+    if (lobbyId == solvingLobby) predictionStop = true;
+
+    auto it = pendingPredictions.find(lobbyId);
+    if (it != pendingPredictions.end()) {
+        it->second = version;   // Keeps its place in the queue
+        return;
+    }
+    pendingPredictions.emplace(lobbyId, version);
+    predictionQueue.push_back(lobbyId);
+    predictionCv.notify_one();
+}
+
+void requestScorePrediction(int lobbyId, unsigned long version) {
+    if (!isValidLobbyId(lobbyId)) return;
+    runAfterBatch([lobbyId, version] { queueScorePrediction(lobbyId, version); });
+}
@@ -0,0 +1,332 @@
+#include "../include/endgame.h"
+#include <chrono>
+
+#define COLUMN_A 0x0101010101010101ULL
+#define COLUMN_H 0x8080808080808080ULL
+#define ROW_1 0x00000000000000ffULL
+#define ROW_8 0xff00000000000000ULL
+#define BORDER (COLUMN_A | COLUMN_H | ROW_1 | ROW_8)
+
+// Below this many empties the transposition table costs more than it saves
+#define ENDGAME_TT_MIN_EMPTIES 7
+// Fastest-first ordering (opponent mobility) above this many empties
+#define ENDGAME_FASTEST_FIRST_EMPTIES 5
+#define ENDGAME_SMALL_EMPTIES 4
+// Room for every square, --endgame-empties is not bounded
+#define MAX_MOVES 64
+
+typedef std::chrono::steady_clock Clock;
+
+struct EndgameContext {
+      TranspositionTable *tt;
+      Clock::time_point deadline;
+      std::atomic<bool> *stop;
+      uint64_t nodes;
+      bool stopped;
+};
+
+// Quadrant (0-3) of every square, used for parity ordering
+static inline int quadrantOf(int square) {
+      return ((square & 7) >= 4 ? 1 : 0) | ((square >> 3) >= 4 ? 2 : 0);
+}
+
+static const uint64_t QUADRANT_MASKS[4] = {
+      0x000000000f0f0f0fULL, 0x00000000f0f0f0f0ULL,
+      0x0f0f0f0f00000000ULL, 0xf0f0f0f000000000ULL
+};
+
+// Bit q set when quadrant q has an odd number of empties
+static inline int quadrantParity(uint64_t empties) {
+      int parity = 0;
+      for (int q = 0; q < 4; q++) {
+            if (__builtin_popcountll(empties & QUADRANT_MASKS[q]) & 1) parity |= 1 << q;
+      }
+      return parity;
+}
+
+// ---------------------------------------------------------------------------
+// Stability
+// ---------------------------------------------------------------------------
+
+struct LineMasks {
+      uint64_t diagonal9[15];   // a1-h8 direction
+      uint64_t diagonal7[15];   // h1-a8 direction
+};
+
+static LineMasks buildLineMasks() {
+      LineMasks masks = {};
+      for (int square = 0; square < 64; square++) {
+            int x = square & 7;
+            int y = square >> 3;
+            masks.diagonal9[x - y + 7] |= 1ULL << square;
+            masks.diagonal7[x + y] |= 1ULL << square;
+      }
+      return masks;
+}
+
+static const LineMasks LINE_MASKS = buildLineMasks();
+
+uint64_t getStableDiscs(uint64_t color, uint64_t occupied) {
+      // Lines that are completely filled cannot change along their axis
+      uint64_t fullH = 0, fullV = 0, full9 = 0, full7 = 0;
+      for (int i = 0; i < 8; i++) {
+            uint64_t row = ROW_1 << (8 * i);
+            uint64_t column = COLUMN_A << i;
+            if ((occupied & row) == row) fullH |= row;
+            if ((occupied & column) == column) fullV |= column;
+      }
+      for (int i = 0; i < 15; i++) {
+            if ((occupied & LINE_MASKS.diagonal9[i]) == LINE_MASKS.diagonal9[i]) full9 |= LINE_MASKS.diagonal9[i];
+            if ((occupied & LINE_MASKS.diagonal7[i]) == LINE_MASKS.diagonal7[i]) full7 |= LINE_MASKS.diagonal7[i];
+      }
+
+      uint64_t stable = 0;
+      while (true) {
+            uint64_t okH = fullH | COLUMN_A | COLUMN_H | ((stable << 1) & ~COLUMN_A) | ((stable >> 1) & ~COLUMN_H);
+            uint64_t okV = fullV | ROW_1 | ROW_8 | (stable << 8) | (stable >> 8);
+            uint64_t ok9 = full9 | BORDER | ((stable << 9) & ~COLUMN_A) | ((stable >> 9) & ~COLUMN_H);
+            uint64_t ok7 = full7 | BORDER | ((stable << 7) & ~COLUMN_H) | ((stable >> 7) & ~COLUMN_A);
+
+            uint64_t next = color & okH & okV & ok9 & ok7;
+            if (next == stable) return stable;
+            stable = next;
+      }
+}
+
+// ---------------------------------------------------------------------------
+// Last empties: square lists, no move generation
+// ---------------------------------------------------------------------------
+
+static inline int discDifference(uint64_t own, uint64_t opp) {
+      return __builtin_popcountll(own) - __builtin_popcountll(opp);
+}
+
+static int solveLast1(EndgameContext &ctx, uint64_t own, uint64_t opp, int square) {
+      ctx.nodes++;
+      int base = discDifference(own, opp);
+
+      uint64_t flips = getFlipMask(square, own, opp);
+      if (flips) return base + 2 * __builtin_popcountll(flips) + 1;
+
+      // We pass, the opponent may still take the last square
+      flips = getFlipMask(square, opp, own);
+      if (flips) return base - 2 * __builtin_popcountll(flips) - 1;
+
+      return base;
+}
+
+static int solveSmall(EndgameContext &ctx, uint64_t own, uint64_t opp, int alpha, int beta, int *squares, int count, bool passed) {
+      if (count == 1) return solveLast1(ctx, own, opp, squares[0]);
+      ctx.nodes++;
+
+      int best = -SCORE_INFINITY;
+      for (int i = 0; i < count; i++) {
+            int square = squares[i];
+            uint64_t flips = getFlipMask(square, own, opp);
+            if (!flips) continue;
+
+            // Remaining squares keep their (parity) order
+            int rest[ENDGAME_SMALL_EMPTIES];
+            int restCount = 0;
+            for (int j = 0; j < count; j++) {
+                  if (j != i) rest[restCount++] = squares[j];
+            }
+
+            int score = -solveSmall(ctx, opp & ~flips, own | flips | (1ULL << square), -beta, -alpha, rest, restCount, false);
+            if (score > best) {
+                  best = score;
+                  if (score > alpha) {
+                        alpha = score;
+                        if (alpha >= beta) break;
+                  }
+            }
+      }
+
+      if (best == -SCORE_INFINITY) {
+            if (passed) return discDifference(own, opp);
+            return -solveSmall(ctx, opp, own, -beta, -alpha, squares, count, true);
+      }
+      return best;
+}
+
+// ---------------------------------------------------------------------------
+// Main solver
+// ---------------------------------------------------------------------------
+
+static int orderEndgameMoves(uint64_t own, uint64_t opp, uint64_t legal, int empties, int hashMove, int moves[MAX_MOVES]) {
+      int parity = quadrantParity(~(own | opp));
+      int keys[MAX_MOVES];
+      int count = 0;
+
+      for (uint64_t bits = legal; bits; bits &= bits - 1) {
+            int square = __builtin_ctzll(bits);
+            int key = 0;
+            if (square == hashMove) {
+                  key = SCORE_INFINITY;
+            } else {
+                  if (parity & (1 << quadrantOf(square))) key += 4;
+                  if (empties > ENDGAME_FASTEST_FIRST_EMPTIES) {
+                        uint64_t flips = getFlipMask(square, own, opp);
+                        key -= 16 * __builtin_popcountll(getMoveMask(opp & ~flips, own | flips | (1ULL << square)));
+                  }
+            }
+
+            int i = count++;
+            while (i > 0 && keys[i - 1] < key) {
+                  keys[i] = keys[i - 1];
+                  moves[i] = moves[i - 1];
+                  i--;
+            }
+            keys[i] = key;
+            moves[i] = square;
+      }
+      return count;
+}
+
+static int solveDeep(EndgameContext &ctx, uint64_t own, uint64_t opp, int alpha, int beta, bool passed) {
+      uint64_t emptyMask = ~(own | opp);
+      int empties = __builtin_popcountll(emptyMask);
+
+      if (empties <= ENDGAME_SMALL_EMPTIES) {
+            // Odd quadrants first, the rest afterwards
+            int parity = quadrantParity(emptyMask);
+            int squares[ENDGAME_SMALL_EMPTIES];
+            int count = 0;
+            for (uint64_t bits = emptyMask; bits; bits &= bits - 1) {
+                  int square = __builtin_ctzll(bits);
+                  if (parity & (1 << quadrantOf(square))) squares[count++] = square;
+            }
+            for (uint64_t bits = emptyMask; bits; bits &= bits - 1) {
+                  int square = __builtin_ctzll(bits);
+                  if (!(parity & (1 << quadrantOf(square)))) squares[count++] = square;
+            }
+            if (count == 0) return discDifference(own, opp);
+            return solveSmall(ctx, own, opp, alpha, beta, squares, count, false);
+      }
+
+      ctx.nodes++;
+      if ((ctx.nodes & 4095) == 0) {
+            if (Clock::now() >= ctx.deadline) ctx.stopped = true;
+            if (ctx.stop != nullptr && ctx.stop->load(std::memory_order_relaxed)) ctx.stopped = true;
+      }
+      if (ctx.stopped) return 0;
+
+      // Stability cutoff: stable opponent stones cap what we can reach
+      if (alpha > 0) {
+            int upper = 64 - 2 * __builtin_popcountll(getStableDiscs(opp, own | opp));
+            if (upper <= alpha) return upper;
+            if (upper < beta) beta = upper;
+      }
+
+      uint64_t legal = getMoveMask(own, opp);
+      if (legal == 0) {
+            if (passed || getMoveMask(opp, own) == 0) return discDifference(own, opp);
+            return -solveDeep(ctx, opp, own, -beta, -alpha, true);
+      }
+
+      uint64_t key = 0;
+      int hashMove = -1;
+      if (empties >= ENDGAME_TT_MIN_EMPTIES) {
+            key = hashPosition(own, opp);
+            TTEntry entry;
+            if (ctx.tt->probe(key, entry)) {
+                  hashMove = entry.bestMove;
+                  if (entry.flag == TT_FLAG_EXACT) return entry.score;
+                  if (entry.flag == TT_FLAG_LOWER && entry.score >= beta) return entry.score;
+                  if (entry.flag == TT_FLAG_UPPER && entry.score <= alpha) return entry.score;
+            }
+      }
+
+      int moves[MAX_MOVES];
+      int count = orderEndgameMoves(own, opp, legal, empties, hashMove, moves);
+
+      int originalAlpha = alpha;
+      int best = -SCORE_INFINITY;
+      int bestMove = -1;
+      for (int i = 0; i < count; i++) {
+            int square = moves[i];
+            uint64_t flips = getFlipMask(square, own, opp);
+            uint64_t newOwn = own | flips | (1ULL << square);
+            uint64_t newOpp = opp & ~flips;
+
+            // Principal variation search: prove the rest worse with a null window
+            int score;
+            if (i == 0) {
+                  score = -solveDeep(ctx, newOpp, newOwn, -beta, -alpha, false);
+            } else {
+                  score = -solveDeep(ctx, newOpp, newOwn, -alpha - 1, -alpha, false);
+                  if (score > alpha && score < beta && !ctx.stopped) score = -solveDeep(ctx, newOpp, newOwn, -beta, -alpha, false);
+            }
+            if (ctx.stopped) return 0;
+
+            if (score > best) {
+                  best = score;
+                  bestMove = square;
+                  if (score > alpha) {
+                        alpha = score;
+                        if (alpha >= beta) break;
+                  }
+            }
+      }
+
+      if (empties >= ENDGAME_TT_MIN_EMPTIES) {
+            int flag = TT_FLAG_EXACT;
+            if (best <= originalAlpha) flag = TT_FLAG_UPPER;
+            else if (best >= beta) flag = TT_FLAG_LOWER;
+            ctx.tt->store(key, empties, best, flag, bestMove);
+      }
+      return best;
+}
+
+EndgameResult solveEndgame(const Board& board, int player, int timeBudgetMs, std::atomic<bool> *stop, TranspositionTable& tt) {
+      Clock::time_point start = Clock::now();
+      EndgameResult result = {false, -1, 0, 0, 0.0};
+      if (player != 1 && player != 2) return result;
+
+      EndgameContext ctx;
+      ctx.tt = &tt;
+      ctx.deadline = start + std::chrono::milliseconds(timeBudgetMs);
+      ctx.stop = stop;
+      ctx.nodes = 0;
+      ctx.stopped = false;
+
+      uint64_t own = board.discs[player - 1];
+      uint64_t opp = board.discs[2 - player];
+      uint64_t legal = getMoveMask(own, opp);
+
+      if (legal == 0) {
+            // Forced pass (or game over), the score is still exact
+            result.score = solveDeep(ctx, own, opp, -SCORE_INFINITY, SCORE_INFINITY, false);
+      } else {
+            int empties = 64 - __builtin_popcountll(own | opp);
+            int moves[MAX_MOVES];
+            int count = orderEndgameMoves(own, opp, legal, empties, -1, moves);
+
+            int alpha = -SCORE_INFINITY;
+            for (int i = 0; i < count && !ctx.stopped; i++) {
+                  int square = moves[i];
+                  uint64_t flips = getFlipMask(square, own, opp);
+                  uint64_t newOwn = own | flips | (1ULL << square);
+                  uint64_t newOpp = opp & ~flips;
+
+                  int score;
+                  if (i == 0) {
+                        score = -solveDeep(ctx, newOpp, newOwn, -SCORE_INFINITY, SCORE_INFINITY, false);
+                  } else {
+                        score = -solveDeep(ctx, newOpp, newOwn, -alpha - 1, -alpha, false);
+                        if (score > alpha && !ctx.stopped) score = -solveDeep(ctx, newOpp, newOwn, -SCORE_INFINITY, -alpha, false);
+                  }
+                  if (ctx.stopped) break;
+                  if (score > alpha) {
+                        alpha = score;
+                        result.square = square;
+                  }
+            }
+            result.score = alpha;
+      }
+
+      result.solved = !ctx.stopped;
+      result.nodes = ctx.nodes;
+      result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      return result;
+}
@@ -0,0 +1,264 @@
+#include "../include/engine.h"
+#include <algorithm>
+#include <chrono>
+
+// Classic disc-square weights: corners are gold, the squares next to them
+// give the corner away.
+static const int SQUARE_WEIGHTS[64] = {
+      100, -20,  10,   5,   5,  10, -20, 100,
+      -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+       10,  -2,  -1,  -1,  -1,  -1,  -2,  10,
+        5,  -2,  -1,  -1,  -1,  -1,  -2,   5,
+        5,  -2,  -1,  -1,  -1,  -1,  -2,   5,
+       10,  -2,  -1,  -1,  -1,  -1,  -2,  10,
+      -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+      100, -20,  10,   5,   5,  10, -20, 100,
+};
+
+#define MOBILITY_WEIGHT 8
+// Room for every square, positions with more than 32 legal moves exist
+#define MAX_MOVES 64
+
+typedef std::chrono::steady_clock Clock;
+
+struct SearchContext {
+      TranspositionTable *tt;
+      Clock::time_point deadline;
+      std::atomic<bool> *stop;
+      uint64_t nodes;
+      bool stopped;
+};
+
+// Packed slot data: score (16 bits) | depth (8) | flag (8) | best move (8)
+static inline uint64_t packEntry(int score, int depth, int flag, int bestMove) {
+      return (uint64_t)(uint16_t)score
+           | ((uint64_t)(uint8_t)depth << 16)
+           | ((uint64_t)(uint8_t)flag << 24)
+           | ((uint64_t)(uint8_t)bestMove << 32);
+}
+
+TranspositionTable::TranspositionTable(int sizeLog2) {
+      size_t size = (size_t)1 << sizeLog2;
+      slots.reset(new Slot[size]);
+      mask = size - 1;
+      clear();
+}
+
+void TranspositionTable::clear() {
+      for (size_t i = 0; i <= mask; i++) {
+            slots[i].check.store(0, std::memory_order_relaxed);
+            slots[i].data.store(0, std::memory_order_relaxed);
+      }
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+      const Slot &slot = slots[key & mask];
+      uint64_t data = slot.data.load(std::memory_order_relaxed);
+      uint64_t check = slot.check.load(std::memory_order_relaxed);
+      if ((check ^ data) != key || data == 0) return false;
+
+      entry.key = key;
+      entry.score = (int16_t)(data & 0xffff);
+      entry.depth = (int8_t)((data >> 16) & 0xff);
+      entry.flag = (uint8_t)((data >> 24) & 0xff);
+      entry.bestMove = (int8_t)((data >> 32) & 0xff);
+      return true;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, int flag, int bestMove) {
+      Slot &slot = slots[key & mask];
+
+      uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+      uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+      if ((oldCheck ^ oldData) == key && (int8_t)((oldData >> 16) & 0xff) > depth) return;
+
+      uint64_t data = packEntry(score, depth, flag, bestMove);
+      slot.check.store(key ^ data, std::memory_order_relaxed);
+      slot.data.store(data, std::memory_order_relaxed);
+}
+
+static inline uint64_t mix64(uint64_t value) {
+      value ^= value >> 33;
+      value *= 0xff51afd7ed558ccdULL;
+      value ^= value >> 33;
+      value *= 0xc4ceb9fe1a85ec53ULL;
+      value ^= value >> 33;
+      return value;
+}
+
+uint64_t hashPosition(uint64_t own, uint64_t opp) {
+      return mix64(own ^ mix64(opp + 0x9e3779b97f4a7c15ULL));
+}
+
+int evaluatePosition(uint64_t own, uint64_t opp) {
+      int score = 0;
+      for (uint64_t bits = own; bits; bits &= bits - 1) score += SQUARE_WEIGHTS[__builtin_ctzll(bits)];
+      for (uint64_t bits = opp; bits; bits &= bits - 1) score -= SQUARE_WEIGHTS[__builtin_ctzll(bits)];
+
+      int ownMobility = __builtin_popcountll(getMoveMask(own, opp));
+      int oppMobility = __builtin_popcountll(getMoveMask(opp, own));
+      score += MOBILITY_WEIGHT * (ownMobility - oppMobility);
+
+      return score;
+}
+
+static int finalScore(uint64_t own, uint64_t opp) {
+      int diff = __builtin_popcountll(own) - __builtin_popcountll(opp);
+      if (diff > 0) return SCORE_WIN + diff;
+      if (diff < 0) return -SCORE_WIN + diff;
+      return 0;
+}
+
+/**
+ * Fills `moves` with the legal squares, best candidates first:
+ * the hash move, then moves leaving the opponent few replies.
+ */
+static int orderMoves(uint64_t own, uint64_t opp, uint64_t legal, int hashMove, int moves[MAX_MOVES]) {
+      int keys[MAX_MOVES];
+      int count = 0;
+
+      for (uint64_t bits = legal; bits; bits &= bits - 1) {
+            int square = __builtin_ctzll(bits);
+            int key;
+            if (square == hashMove) {
+                  key = SCORE_INFINITY;
+            } else {
+                  uint64_t flips = getFlipMask(square, own, opp);
+                  uint64_t newOwn = own | flips | (1ULL << square);
+                  uint64_t newOpp = opp & ~flips;
+                  key = SQUARE_WEIGHTS[square] - 16 * __builtin_popcountll(getMoveMask(newOpp, newOwn));
+            }
+
+            // Insertion sort, rarely more than ~30 moves
+            int i = count++;
+            while (i > 0 && keys[i - 1] < key) {
+                  keys[i] = keys[i - 1];
+                  moves[i] = moves[i - 1];
+                  i--;
+            }
+            keys[i] = key;
+            moves[i] = square;
+      }
+      return count;
+}
+
+static int negamax(SearchContext &ctx, uint64_t own, uint64_t opp, int depth, int alpha, int beta) {
+      ctx.nodes++;
+      if ((ctx.nodes & 1023) == 0) {
+            if (Clock::now() >= ctx.deadline) ctx.stopped = true;
+            if (ctx.stop != nullptr && ctx.stop->load(std::memory_order_relaxed)) ctx.stopped = true;
+      }
+      if (ctx.stopped) return 0;
+
+      uint64_t legal = getMoveMask(own, opp);
+      if (legal == 0) {
+            // Pass: same rules as resolveNextPlayer, a pass does not use depth
+            if (getMoveMask(opp, own) == 0) return finalScore(own, opp);
+            return -negamax(ctx, opp, own, depth, -beta, -alpha);
+      }
+
+      if (depth <= 0) return evaluatePosition(own, opp);
+
+      uint64_t key = hashPosition(own, opp);
+      int hashMove = -1;
+      TTEntry entry;
+      if (ctx.tt->probe(key, entry)) {
+            hashMove = entry.bestMove;
+            if (entry.depth >= depth) {
+                  if (entry.flag == TT_FLAG_EXACT) return entry.score;
+                  if (entry.flag == TT_FLAG_LOWER && entry.score >= beta) return entry.score;
+                  if (entry.flag == TT_FLAG_UPPER && entry.score <= alpha) return entry.score;
+            }
+      }
+
+      int moves[MAX_MOVES];
+      int count = orderMoves(own, opp, legal, hashMove, moves);
+
+      int originalAlpha = alpha;
+      int best = -SCORE_INFINITY;
+      int bestMove = -1;
+
+      for (int i = 0; i < count; i++) {
+            int square = moves[i];
+            uint64_t flips = getFlipMask(square, own, opp);
+            uint64_t newOwn = own | flips | (1ULL << square);
+            uint64_t newOpp = opp & ~flips;
+
+            int score = -negamax(ctx, newOpp, newOwn, depth - 1, -beta, -alpha);
+            if (ctx.stopped) return 0;
+
+            if (score > best) {
+                  best = score;
+                  bestMove = square;
+            }
+            if (score > alpha) alpha = score;
+            if (alpha >= beta) break;
+      }
+
+      int flag = TT_FLAG_EXACT;
+      if (best <= originalAlpha) flag = TT_FLAG_UPPER;
+      else if (best >= beta) flag = TT_FLAG_LOWER;
+      ctx.tt->store(key, depth, best, flag, bestMove);
+
+      return best;
+}
+
+SearchResult searchBestMove(const Board& board, int player, const SearchLimits& limits, TranspositionTable& tt) {
+      Clock::time_point start = Clock::now();
+
+      SearchResult result = {-1, 0, 0, 0, 0.0};
+      if (player != 1 && player != 2) return result;
+
+      uint64_t own = board.discs[player - 1];
+      uint64_t opp = board.discs[2 - player];
+      uint64_t legal = getMoveMask(own, opp);
+      if (legal == 0) return result;
+
+      SearchContext ctx;
+      ctx.tt = &tt;
+      ctx.deadline = start + std::chrono::milliseconds(limits.timeBudgetMs);
+      ctx.stop = limits.stop;
+      ctx.nodes = 0;
+      ctx.stopped = false;
+
+      // Always have an answer, even if depth 1 does not finish in time
+      result.square = __builtin_ctzll(legal);
+      if (limits.firstMove >= 0 && limits.firstMove < 64 && ((legal >> limits.firstMove) & 1)) result.square = limits.firstMove;
+
+      int empties = 64 - __builtin_popcountll(own | opp);
+      int maxDepth = std::min(limits.maxDepth, empties);
+
+      for (int depth = std::max(1, std::min(limits.startDepth, maxDepth)); depth <= maxDepth; depth++) {
+            int moves[MAX_MOVES];
+            int count = orderMoves(own, opp, legal, result.square, moves);
+
+            int alpha = -SCORE_INFINITY;
+            int bestMove = moves[0];
+            for (int i = 0; i < count; i++) {
+                  int square = moves[i];
+                  uint64_t flips = getFlipMask(square, own, opp);
+                  int score = -negamax(ctx, opp & ~flips, own | flips | (1ULL << square), depth - 1, -SCORE_INFINITY, -alpha);
+                  if (ctx.stopped) break;
+                  if (score > alpha) {
+                        alpha = score;
+                        bestMove = square;
+                  }
+            }
+            if (ctx.stopped) break;
+
+            result.square = bestMove;
+            result.score = alpha;
+            result.depth = depth;
+
+            // Solved to the end, deeper iterations cannot change anything
+            if (alpha >= SCORE_WIN || alpha <= -SCORE_WIN) break;
+
+            // The next iteration would most likely not finish anyway
+            double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            if (elapsed * 2 > limits.timeBudgetMs) break;
+      }
+
+      result.nodes = ctx.nodes;
+      result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      return result;
+}
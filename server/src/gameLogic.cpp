@@ -1,140 +1,260 @@
 #include "../include/gameLogic.h"
-#include <array>
-#include <vector>
-#include <iostream>
-#include <algorithm>
-
-int getScoreForPlayer(int playerId, int board[][8]) {
-    int count = 0;
-    for(int i = 0; i < 8; ++i) {
-        for(int j = 0; j < 8; ++j) {
-            if(board[i][j] == playerId) {
-                count++;
-            }
-        }
-    }
-    return count; // Example: score is 10 times the player ID
-}
-
-int getWinnerResults(int board[][8]) {
-      int score1 = 0;
-      int score2 = 0;
-      for(int i = 0; i < 8; ++i) {
-        for(int j = 0; j < 8; ++j) {
-            if(board[i][j] == 1) {
-                score1++;
-            }
-            else if (board[i][j] == 2) {
-                score2++;
-            }
-        }
-    }
+#include "../include/simdMoves.h"
+#include "../include/positionCache.h"
+
+// Zobrist keys, generated at compile time with splitmix64 (fixed seed, so
+// hashes are the same in every process and tool)
+template <int N>
+struct ZobristKeys {
+      uint64_t discs[2][N * N];
+      uint64_t flip[N * N];   // discs[0] ^ discs[1], one XOR per flipped stone
+      uint64_t secondToMove;
+};
+
+static constexpr uint64_t splitMix64(uint64_t &state) {
+      state += 0x9e3779b97f4a7c15ULL;
+      uint64_t z = state;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+}
+
+template <int N>
+static constexpr ZobristKeys<N> buildZobristKeys() {
+      ZobristKeys<N> keys = {};
+      uint64_t state = 0x5265766572736921ULL;
+      for (int color = 0; color < 2; color++) {
+            for (int square = 0; square < N * N; square++) keys.discs[color][square] = splitMix64(state);
+      }
+      for (int square = 0; square < N * N; square++) keys.flip[square] = keys.discs[0][square] ^ keys.discs[1][square];
+      keys.secondToMove = splitMix64(state);
+      return keys;
+}
+
+template <int N>
+static constexpr ZobristKeys<N> ZOBRIST = buildZobristKeys<N>();
+
+uint64_t computeZobristHash(uint64_t discs1, uint64_t discs2) {
+      uint64_t hash = 0;
+      for (uint64_t bits = discs1; bits; bits &= bits - 1) hash ^= ZOBRIST<8>.discs[0][__builtin_ctzll(bits)];
+      for (uint64_t bits = discs2; bits; bits &= bits - 1) hash ^= ZOBRIST<8>.discs[1][__builtin_ctzll(bits)];
+      return hash;
+}
+
+uint64_t getPositionKey(const Board& board, int player) {
+      return player == 2 ? board.hash ^ ZOBRIST<8>.secondToMove : board.hash;
+}
+
+// 8x8 goes through the SIMD dispatch, the other sizes use the generic kernels
+template <int N>
+static inline typename BoardGeometry<N>::Bits legalMoves(typename BoardGeometry<N>::Bits own, typename BoardGeometry<N>::Bits opp) {
+      if constexpr (N == 8) return getMoveMask(own, opp);
+      else return computeMoveMask<N>(own, opp);
+}
+
+template <int N>
+static inline typename BoardGeometry<N>::Bits flippedStones(int square, typename BoardGeometry<N>::Bits own, typename BoardGeometry<N>::Bits opp) {
+      if constexpr (N == 8) return getFlipMask(square, own, opp);
+      else return computeFlipMask<N>(square, own, opp);
+}
+
+template <int N>
+int getScoreForPlayer(int playerId, const BasicBoard<N>& board) {
+      if (playerId != 1 && playerId != 2) return 0;
+      return board.scores[playerId - 1];
+}
+
+template <int N>
+int getWinnerResults(const BasicBoard<N>& board) {
+      int score1 = board.scores[0];
+      int score2 = board.scores[1];
+
+      if (score1 == score2) {
+            return 3;
+      }
+      else if (score1 > score2) {
+            return 1;
+      }
+      else {
+            return 2;
+      }
+}
+
+uint64_t getMoveMaskScalar(uint64_t own, uint64_t opp) {
+      return computeMoveMask<8>(own, opp);
+}
+
+uint64_t getFlipMaskScalar(int square, uint64_t own, uint64_t opp) {
+      return computeFlipMask<8>(square, own, opp);
+}
+
+uint64_t getMoveMask(uint64_t own, uint64_t opp) {
+      return activeMoveMaskKernel(own, opp);
+}
 
-    if (score1 == score2) {
-      return 3;
-    }
-    else if (score1 > score2) {
-      return 1;
-    }
-    else {
-      return 2;
-    }
+uint64_t getFlipMask(int square, uint64_t own, uint64_t opp) {
+      return activeFlipMaskKernel(square, own, opp);
 }
 
-bool processMove(int x, int y, int board[][8], int player, bool apply) {
+template <int N>
+bool processMove(int x, int y, BasicBoard<N>& board, int player, bool apply, typename BoardGeometry<N>::Bits *flipped) {
+      typedef typename BoardGeometry<N>::Bits Bits;
+
       // 1. Bounds Check
-      if (x < 0 || x >= 8 || y < 0 || y >= 8) return false;
+      if (x < 0 || x >= N || y < 0 || y >= N) return false;
+      if (player != 1 && player != 2) return false;
 
       // 2. Occupied Check: You cannot place a piece on top of another player
-      // We allow 0 (Empty) and 3 (Hint)
-      if (board[y][x] == 1 || board[y][x] == 2) {
-            std::cout << "hovno" << std::endl;
-            return false; 
+      int square = y * N + x;
+      Bits &own = board.discs[player - 1];
+      Bits &opp = board.discs[2 - player];
+
+      Bits flips = flippedStones<N>(square, own, opp);
+      if (flips == 0) return false;
+
+      // 3. Final Placement
+      if (apply) {
+            int flipCount = bitCount(flips);
+            own |= flips | ((Bits)1 << square);
+            opp &= ~flips;
+
+            board.scores[player - 1] += flipCount + 1;
+            board.scores[2 - player] -= flipCount;
+            board.empties--;
+
+            board.hash ^= ZOBRIST<N>.discs[player - 1][square];
+            for (Bits bits = flips; bits; bits &= bits - 1) board.hash ^= ZOBRIST<N>.flip[lowestSquare(bits)];
       }
+      if (flipped != nullptr) *flipped = flips;
 
-      int opponent = (player == 1) ? 2 : 1;
-      bool valid_move = false;
-
-      // 8 Directions
-      int dx[] = {-1, -1, -1,  0,  0,  1, 1, 1};
-      int dy[] = {-1,  0,  1, -1,  1, -1, 0, 1};
-
-      for (int i = 0; i < 8; i++) {
-            int currX = x + dx[i];
-            int currY = y + dy[i];
-            bool found_opponent = false;
-            
-            // Walk in this direction
-            while (currX >= 0 && currX < 8 && currY >= 0 && currY < 8) {
-                  
-                  if (board[currY][currX] == opponent) {
-                  // Found an opponent, keep walking to look for our piece
-                  found_opponent = true;
-                  currX += dx[i];
-                  currY += dy[i];
-                  } 
-                  else if (board[currY][currX] == player) {
-                  // Found our own piece!
-                  if (found_opponent) {
-                        // SANDWICH CONFIRMED
-                        valid_move = true;
-
-                        // Optimization: If we are only checking (hints), we can stop now!
-                        if (!apply) return true;
-
-                        // If applying, walk BACKWARDS and flip
-                        int flipX = currX - dx[i];
-                        int flipY = currY - dy[i];
-                        while (flipX != x || flipY != y) {
-                              board[flipY][flipX] = player;
-                              flipX -= dx[i];
-                              flipY -= dy[i];
-                        }
-                  }
-                  break; // Stop looking in this direction (we hit our own piece)
-                  } 
-                  else {
-                  // Hit an Empty cell (0) or Hint (3) -> Sandwich broken
-                  break; 
-                  }
+      return true;
+}
+
+template <int N>
+bool getAvaiableMoves(BasicBoard<N>& board, int currentPlayer, PositionCache *cache) {
+      if (currentPlayer != 1 && currentPlayer != 2) {
+            board.hints = 0;
+            return false;
+      }
+
+      if constexpr (N == 8) {
+            if (cache != nullptr) {
+                  board.hints = cache->getMoveMask(board, currentPlayer);
+                  return board.hints != 0;
             }
       }
-      
-      // 3. Final Placement
-      if (valid_move && apply) {
-            board[y][x] = player;
-            // std::cout << "Move applied at " << x << "," << y << std::endl;
+      board.hints = legalMoves<N>(board.discs[currentPlayer - 1], board.discs[2 - currentPlayer]);
+      return board.hints != 0;
+}
+
+template <int N>
+int resolveNextPlayer(BasicBoard<N>& board, int player, PositionCache *cache) {
+      int opponent = (player == 1) ? 2 : 1;
+
+      if (board.empties == 0) {
+            board.hints = 0;
+            return 0;
       }
 
-      return valid_move;
+      if (getAvaiableMoves(board, opponent, cache)) return opponent;
+      if (getAvaiableMoves(board, player, cache)) return player;
+      return 0;
 }
 
-bool getAvaiableMoves(int board[][8], int currentPlayer) {
-      bool can_play = false;
+template <int N>
+bool validateMove(int x, int y, const BasicBoard<N>& board, int currentPlayer) {
+      if (x < 0 || x >= N || y < 0 || y >= N) return false;
+      if (currentPlayer != 1 && currentPlayer != 2) return false;
 
-      for(int r = 0; r < 8; ++r) {
-           for(int c = 0; c < 8; ++c) {
-                if (board[r][c] == 3) board[r][c] = 0;
-           }
+      return flippedStones<N>(y * N + x, board.discs[currentPlayer - 1], board.discs[2 - currentPlayer]) != 0;
+}
+
+template <int N>
+int getCell(const BasicBoard<N>& board, int x, int y) {
+      typedef typename BoardGeometry<N>::Bits Bits;
+
+      Bits bit = (Bits)1 << (y * N + x);
+      if (board.discs[0] & bit) return CELL_PLAYER_ONE;
+      if (board.discs[1] & bit) return CELL_PLAYER_TWO;
+      if (board.hints & bit) return CELL_HINT;
+      return CELL_EMPTY;
+}
+
+template <int N>
+void setCell(BasicBoard<N>& board, int x, int y, int value) {
+      typedef typename BoardGeometry<N>::Bits Bits;
+
+      int square = y * N + x;
+      Bits bit = (Bits)1 << square;
+      if (board.discs[0] & bit) {
+            board.scores[0]--;
+            board.hash ^= ZOBRIST<N>.discs[0][square];
+      }
+      else if (board.discs[1] & bit) {
+            board.scores[1]--;
+            board.hash ^= ZOBRIST<N>.discs[1][square];
+      }
+      else board.empties--;
+
+      board.discs[0] &= ~bit;
+      board.discs[1] &= ~bit;
+      board.hints &= ~bit;
+
+      if (value == CELL_PLAYER_ONE) {
+            board.discs[0] |= bit;
+            board.scores[0]++;
+            board.hash ^= ZOBRIST<N>.discs[0][square];
+      }
+      else if (value == CELL_PLAYER_TWO) {
+            board.discs[1] |= bit;
+            board.scores[1]++;
+            board.hash ^= ZOBRIST<N>.discs[1][square];
+      }
+      else {
+            board.empties++;
       }
+}
+
+template <int N>
+void loadBoard(BasicBoard<N>& board, const std::string& state) {
+      board.discs[0] = 0;
+      board.discs[1] = 0;
+      board.hints = 0;
+      board.hash = 0;
+      board.scores[0] = 0;
+      board.scores[1] = 0;
+      board.empties = N * N;
 
-      // Calculate new hints
-      for(int y = 0; y < 8; ++y) { // y is Row
-            for(int x = 0; x < 8; ++x) { // x is Column
-                  if(board[y][x] == 0) { // Only check empty spots
-                       // validateMove expects (x, y)
-                       if(validateMove(x, y, board, currentPlayer)) {
-                            board[y][x] = 3; 
-                            can_play = true;
-                       }
-                  }
+      for (int i = 0; i < N * N && i < (int)state.size(); ++i) {
+            int val = state[i] - '0';
+            if (val == CELL_PLAYER_ONE || val == CELL_PLAYER_TWO) {
+                  setCell(board, i % N, i / N, val);
             }
       }
+}
 
-      return can_play;
+std::string getStandardStartState(int size) {
+      std::string state(size * size, '0');
+      int center = size / 2;
+      state[(center - 1) * size + center - 1] = '1';
+      state[(center - 1) * size + center] = '2';
+      state[center * size + center - 1] = '2';
+      state[center * size + center] = '1';
+      return state;
 }
 
-bool validateMove(int x, int y, int board[][8], int currentPlayer) {
-    // Pass 'false' to just check validity without modifying board
-    return processMove(x, y, board, currentPlayer, false);
-}
\ No newline at end of file
+// Every offered board size gets its own fully specialized rules
+#define INSTANTIATE_BOARD_RULES(N) \
+      template int getScoreForPlayer<N>(int, const BasicBoard<N>&); \
+      template int getWinnerResults<N>(const BasicBoard<N>&); \
+      template bool getAvaiableMoves<N>(BasicBoard<N>&, int, PositionCache*); \
+      template bool processMove<N>(int, int, BasicBoard<N>&, int, bool, BoardGeometry<N>::Bits*); \
+      template bool validateMove<N>(int, int, const BasicBoard<N>&, int); \
+      template int resolveNextPlayer<N>(BasicBoard<N>&, int, PositionCache*); \
+      template int getCell<N>(const BasicBoard<N>&, int, int); \
+      template void setCell<N>(BasicBoard<N>&, int, int, int); \
+      template void loadBoard<N>(BasicBoard<N>&, const std::string&);
+
+INSTANTIATE_BOARD_RULES(BOARD_SIZE_SMALL)
+INSTANTIATE_BOARD_RULES(BOARD_SIZE_STANDARD)
+INSTANTIATE_BOARD_RULES(BOARD_SIZE_LARGE)
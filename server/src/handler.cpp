@@ -1,39 +1,85 @@
 #include "../include/handler.h"
 #include "../include/sender.h" // Handler needs to send responses
 #include "../include/global.h"
+#include "../include/bot.h"
+#include "../include/openingBook.h"
+#include "../include/shard.h"
+#include "../include/outbox.h"
+#include "../include/reconnectGrace.h"
+#include "../include/messageParser.h"
+#include "../include/binaryProtocol.h"
+#include "../include/lobbyIndex.h"
+#include "../include/playerPool.h"
+#include "../include/matchQueue.h"
+#include "../include/lobbyDirectory.h"
 #include <iostream>
-#include <sstream>
 #include <cstring>
 #include <vector>
-#include <iterator>
 #include <sys/socket.h>
 
-// Note: Globals (lobbies, mutexes) are extern'd in globals.h
-std::vector<std::string> splitMessage(const std::string &s) {
-    std::istringstream iss(s);
-    return std::vector<std::string>{std::istream_iterator<std::string>{iss},
-                                    std::istream_iterator<std::string>{}};
+// Note: Globals (lobby pool, mutexes) are extern'd in globals.h
+
+// Malformed arguments are logged and the message is dropped
+static void reportInvalid(const char *reason) {
+    std::cerr << "[SECURITY] Error: " << reason << std::endl;
+}
+
+// Text lines and binary frames end up as the same command
+static bool decodeClientMessage(std::string_view message, const Player& player, ClientCommand& command) {
+    return player.binaryProtocol ? decodeBinaryFrame(message, command) : decodeTextMessage(message, command);
+}
+
+// REV CREATE <username> [BIN] [DELTA] [<session token>] : flags in any order, any other
+// word is the token of an earlier login (REV SESSION) whose paused game is resumed
+struct LoginArgs {
+    bool binary = false;
+    bool delta = false;
+    std::string_view token;
+};
+
+static bool parseLoginArgs(const ClientCommand& command, LoginArgs& login) {
+    int argCount = command.argCount;
+    if (argCount < 1 || argCount > 4) return false;
+    for (int i = 1; i < argCount && i < MAX_COMMAND_ARGS; i++) {
+        if (command.text[i] == BINARY_PROTOCOL_FLAG) login.binary = true;
+        else if (command.text[i] == DELTA_UPDATES_FLAG) login.delta = true;
+        else if (login.token.empty()) login.token = command.text[i];
+        else return false;
+    }
+    return true;
 }
 
-void handleMessage(int clientSocket, const char* message, Player& player) {
-    std::string messageStr(message);   
-    std::vector<std::string> args = splitMessage(messageStr);
+void handleMessage(int clientSocket, std::string_view message, Player& player) {
+    // Everything this message triggers leaves with one write per client
+    MessageBatch batch;
 
-    if (args.empty() || args[0] != "REV") {
+    // Views into the receive buffer, nothing is copied
+    ClientCommand command;
+    if (!decodeClientMessage(message, player, command)) {
         player.tolerance++;
         std::cout << "[SECURITY] Invalid prefix from client " << clientSocket << std::endl;
         return;
     }
-    if (args.size() < 2) return;
+    if (command.name.empty()) return;
 
-    std::string command = args[1];
+    int argCount = command.argCount;
+    bool numeric = command.numericCount == argCount;
     player.tolerance = 0;
 
     try {
         // --- GLOBAL COMMANDS ---
-        if (command == "HEARTBEAT") {
-            std::string response = "REV HEARTPOP\n";
-            send(clientSocket, response.c_str(), response.size(), 0);
+        if (command.command == CMD_HEARTBEAT) {
+            static const std::string response = "REV HEARTPOP\n";
+            sendMessage(clientSocket, response);
+            return;
+        }
+        if (command.command == CMD_RESYNC) {
+            // REV RESYNC <lobbyId> : full STATE after a gap in the DELTA versions
+            if (argCount != 1 || !numeric) {
+                reportInvalid("Invalid RESYNC args");
+                return;
+            }
+            handleResync(clientSocket, command.args[0]);
             return;
         }
 
@@ -41,25 +87,40 @@ void handleMessage(int clientSocket, const char* message, Player& player) {
         switch (player.state) {
 
             case STATE_LOGIN:
-                if (command == "CREATE") {
-                    if (args.size() != 3) throw std::runtime_error("Invalid CREATE args");
+                if (command.command == CMD_CREATE) {
+                    // BIN switches to binary frames (binaryProtocol.h), DELTA asks for DELTA
+                    // instead of STATE after moves
+                    LoginArgs login;
+                    if (!parseLoginArgs(command, login)) {
+                        reportInvalid("Invalid CREATE args");
+                        break;
+                    }
+                    player.deltaUpdates = login.delta;
                     
-                    std::string username = args[2];
-                    player.appendName(username);
-                    std::cout << "[LOGIN] User " << username << " logged in." << std::endl;
+                    player.appendName(std::string(command.text[0]));
+                    std::cout << "[LOGIN] User " << player.username << " logged in." << std::endl;
 
-                    // Check Reconnection
+                    // Binary from the SESSION reply on, the batch writes it before the lobby directory
+                    if (login.binary) {
+                        player.binaryProtocol = true;
+                        setBinaryClient(clientSocket, true);
+                    }
+                    sendSessionToken(clientSocket, issueSessionToken(&player));
+
+                    // Check Reconnection (the session registry says which lobby holds name and token)
                     bool reconnected = false;
-                    {
-                        std::lock_guard<std::mutex> lock(lobbies_mutex);
-                        for (auto &lobby : lobbies) {
-                            int connectedUser = lobby.reconnectUser(player);
-                            if (connectedUser != -1) {
-                                handleReconecting(clientSocket, player, lobby, connectedUser);
-                                player.state = STATE_PLAYING;
-                                reconnected = true;
-                                return;
-                            }
+                    int pausedLobby = findSession(player.username, login.token);
+                    Lobby *paused = findLobby(pausedLobby);
+                    if (paused != nullptr && isLobbyLocal(pausedLobby)) {
+                        LobbyLock lock(*paused);
+                        Lobby &lobby = *paused;
+                        int connectedUser = lobby.reconnectUser(player, login.token);
+                        if (connectedUser != -1) {
+                            cancelReconnectGrace(pausedLobby);
+                            handleReconecting(clientSocket, player, lobby, connectedUser);
+                            player.state = STATE_PLAYING;
+                            reconnected = true;
+                            return;
                         }
                     }
 
@@ -69,16 +130,21 @@ void handleMessage(int clientSocket, const char* message, Player& player) {
                     }
                 }
                 else {
-                    std::cerr << "[SECURITY] Blocked " << command << " in LOGIN state." << std::endl;
+                    std::cerr << "[SECURITY] Blocked " << command.name << " in LOGIN state." << std::endl;
                 }
                 break;
 
             case STATE_MENU:
-                if (command == "JOIN") {
-                    if (args.size() != 3) throw std::runtime_error("Invalid JOIN args");
-                    int lobbyId = std::stoi(args[2]); 
+                if (command.command == CMD_JOIN) {
+                    // REV JOIN <lobbyId> [6|8|10] : the first player picks the board size
+                    if ((argCount != 1 && argCount != 2) || !numeric) {
+                        reportInvalid("Invalid JOIN args");
+                        break;
+                    }
+                    int lobbyId = command.args[0];
+                    int boardSize = (argCount == 2) ? command.args[1] : BOARD_SIZE_STANDARD;
                     
-                    int result = handleLobbyJoin(clientSocket, lobbyId, player);
+                    int result = handleLobbyJoin(clientSocket, lobbyId, player, boardSize);
                     
                     // result 1: Joined as P1 (Waiting)
                     // result 2: Joined as P2 (Game Start)
@@ -89,8 +155,9 @@ void handleMessage(int clientSocket, const char* message, Player& player) {
                         player.state = STATE_PLAYING;
                         
                         {
-                            std::lock_guard<std::mutex> lock(lobbies_mutex);
-                            Player* p1 = lobbies[lobbyId].getPlayer1();
+                            Lobby &lobby = *findLobby(lobbyId);   // Opened by the join
+                            LobbyLock lock(lobby);
+                            Player* p1 = lobby.getPlayer1();
                             if (p1) p1->state = STATE_PLAYING;
                         }
 
@@ -98,98 +165,257 @@ void handleMessage(int clientSocket, const char* message, Player& player) {
                     } else if(result == 3) {
                         std::cout << "[SERVER] Lobby " << lobbyId << " is full." << std::endl;
                     } else {
-                        throw std::runtime_error("Error when joining players to lobby");
+                        reportInvalid("Error when joining players to lobby");
+                    }
+                }
+                else if (command.command == CMD_BOT) {
+                    // REV BOT [lobbyId] : play against the computer
+                    if (argCount > 1 || !numeric) {
+                        reportInvalid("Invalid BOT args");
+                        break;
+                    }
+                    int lobbyId = (argCount == 1) ? command.args[0] : -1;
+
+                    int joinedLobby = handleBotJoin(clientSocket, lobbyId, player);
+                    if (joinedLobby >= 0) {
+                        player.state = STATE_PLAYING;
+                        startGame(joinedLobby);
+                    }
+                }
+                else if (command.command == CMD_WATCH) {
+                    // REV WATCH <lobbyId> : follow the game as a spectator
+                    if (argCount != 1 || !numeric) {
+                        reportInvalid("Invalid WATCH args");
+                        break;
+                    }
+                    if (handleWatch(clientSocket, command.args[0], player) == 0) {
+                        player.state = STATE_WATCHING;
+                    }
+                }
+                else if (command.command == CMD_QUEUE) {
+                    // REV QUEUE [6|8|10] [rating] : paired with a waiting player of a close rating
+                    if (argCount > 2 || !numeric) {
+                        reportInvalid("Invalid QUEUE args");
+                        break;
+                    }
+                    int boardSize = (argCount >= 1) ? command.args[0] : BOARD_SIZE_STANDARD;
+                    int rating = (argCount == 2) ? command.args[1] : QUEUE_DEFAULT_RATING;
+                    if (findLobbyBySocket(clientSocket) >= 0) {
+                        std::cout << "[SERVER] User already connected to a lobby." << std::endl;
+                        break;
+                    }
+
+                    // Set first, a partner found by the queue's timer moves it on to PLAYING
+                    player.state = STATE_QUEUED;
+                    int lobbyId = joinMatchQueue(player, boardSize, rating);
+                    if (lobbyId == -2) {
+                        player.state = STATE_MENU;
+                        reportInvalid("Invalid QUEUE board size or rating");
+                    } else if (lobbyId >= 0) {
+                        startMatchedGame(lobbyId);
+                    } else {
+                        sendQueueInfo(clientSocket, getMatchQueueDepth());
                     }
                 }
-                else if (command == "CREATE") {
+                else if (command.command == CMD_CREATE) {
                      std::cerr << "[SECURITY] User already logged in." << std::endl;
                 }
                 else {
-                     std::cerr << "[SECURITY] Blocked " << command << " in MENU state." << std::endl;
+                     std::cerr << "[SECURITY] Blocked " << command.name << " in MENU state." << std::endl;
+                }
+
+                // Directory updates are for the menu only, sendLobbyList subscribes again
+                if (player.state != STATE_MENU) unsubscribeLobbyDirectory(clientSocket);
+                break;
+
+            case STATE_QUEUED:
+                if (command.command == CMD_EXIT) {
+                    // REV EXIT [lobbyId] : leaves the queue, or the game it was just paired into
+                    if (!leaveMatchQueue(player)) {
+                        int lobbyId = findLobbyBySocket(clientSocket);
+                        if (lobbyId >= 0) handleLobbyExit(clientSocket, lobbyId);
+                    }
+                    player.state = STATE_MENU;
+                    sendLobbyList(clientSocket);
+                }
+                else {
+                    std::cerr << "[SECURITY] Blocked " << command.name << " in QUEUED state." << std::endl;
+                }
+                break;
+
+            case STATE_WATCHING:
+                if (command.command == CMD_EXIT) {
+                    // REV EXIT [lobbyId] : stop watching
+                    handleStopWatching(clientSocket, player);
+                    player.state = STATE_MENU;
+                    sendLobbyList(clientSocket);
+                }
+                else {
+                    std::cerr << "[SECURITY] Blocked " << command.name << " in WATCHING state." << std::endl;
                 }
                 break;
 
             case STATE_WAITING:
-                if (command == "EXIT") {
-                    if (args.size() != 3) throw std::runtime_error("Invalid EXIT args");
-                    int lobbyId = std::stoi(args[2]);
+                if (command.command == CMD_EXIT) {
+                    if (argCount != 1 || !numeric) {
+                        reportInvalid("Invalid EXIT args");
+                        break;
+                    }
+                    int lobbyId = command.args[0];
                     
                     handleLobbyExit(clientSocket, lobbyId);
                     player.state = STATE_MENU;
                     sendLobbyList(clientSocket);
                 }
                 else {
-                    std::cerr << "[SECURITY] Blocked " << command << " in WAITING state." << std::endl;
+                    std::cerr << "[SECURITY] Blocked " << command.name << " in WAITING state." << std::endl;
                 }
                 break;
 
             case STATE_PLAYING:
-                if (command == "MOVE") {
-                    if (args.size() != 5) throw std::runtime_error("Invalid MOVE args");
-                    int x = std::stoi(args[2]);
-                    int y = std::stoi(args[3]);
-                    int lobbyId = std::stoi(args[4]);
+                if (command.command == CMD_MOVE) {
+                    if (argCount != 3 || !numeric) {
+                        reportInvalid("Invalid MOVE args");
+                        break;
+                    }
+                    int x = command.args[0];
+                    int y = command.args[1];
+                    int lobbyId = command.args[2];
+                    Lobby *lobby = findLobby(lobbyId);
+                    if (lobby == nullptr) {
+                        reportInvalid("Invalid MOVE lobby");
+                        break;
+                    }
                     
                     handleMoving(x, y, clientSocket, lobbyId);
                     
-                    std::lock_guard<std::mutex> lock(lobbies_mutex);
-                    if (lobbies[lobbyId].getStatus() == 0) {
+                    LobbyLock lock(*lobby);
+                    if (lobby->getStatus() == 0) {
                         player.state = STATE_GAME_OVER;
                         
-                        Player* opp = (lobbies[lobbyId].getPlayer1() == &player) 
-                                      ? lobbies[lobbyId].getPlayer2() 
-                                      : lobbies[lobbyId].getPlayer1();
+                        Player* opp = (lobby->getPlayer1() == &player) 
+                                      ? lobby->getPlayer2() 
+                                      : lobby->getPlayer1();
                         if (opp) opp->state = STATE_GAME_OVER;
                     }
                 }
-                else if (command == "EXIT") {
-                    int lobbyId = std::stoi(args[2]);
-                    handleLobbyExit(clientSocket, lobbyId);
+                else if (command.command == CMD_EXIT) {
+                    if (argCount < 1 || command.numericCount < 1) {
+                        reportInvalid("Invalid EXIT args");
+                        break;
+                    }
+                    handleLobbyExit(clientSocket, command.args[0]);
                     player.state = STATE_MENU;
                     sendLobbyList(clientSocket);
                 }
                 else {
-                    std::cerr << "[SECURITY] Blocked " << command << " in PLAYING state." << std::endl;
+                    std::cerr << "[SECURITY] Blocked " << command.name << " in PLAYING state." << std::endl;
                 }
                 break;
 
             case STATE_GAME_OVER:
-                if (command == "REMATCH") {
-                    int lobbyId = std::stoi(args[2]);
-                    handleRematch(clientSocket, lobbyId);
-                }
-                else if (command == "EXIT") {
-                    int lobbyId = std::stoi(args[2]);
-                    handleLobbyExit(clientSocket, lobbyId);
-                    player.state = STATE_MENU;
-                    sendLobbyList(clientSocket);
+                if (command.command == CMD_REMATCH || command.command == CMD_EXIT) {
+                    if (argCount < 1 || command.numericCount < 1) {
+                        reportInvalid("Invalid lobby id");
+                        break;
+                    }
+                    int lobbyId = command.args[0];
+
+                    if (command.command == CMD_REMATCH) {
+                        handleRematch(clientSocket, lobbyId);
+                    }
+                    else {
+                        handleLobbyExit(clientSocket, lobbyId);
+                        player.state = STATE_MENU;
+                        sendLobbyList(clientSocket);
+                    }
                 }
                 break;
         }
 
     } catch (const std::exception& e) {
+        // Only the lobby and sending code below the parser may still throw (allocation)
         std::cerr << "[SECURITY] Error: " << e.what() << std::endl;
     }
 }
 
-int handleLobbyJoin(int clientSocket, int lobbyId, Player& player) {
-    if (lobbyId < 0 || lobbyId >= LOBBY_COUNT) {
+int selectMessageShard(std::string_view message, const Player& player, int hops) {
+    ClientCommand command;
+    if (!decodeClientMessage(message, player, command)) return SHARD_LOCAL;
+
+    CommandId id = command.command;
+    int argCount = command.argCount;
+    int nextShard = (getCurrentShard() + 1) % getShardCount();
+    bool canHop = hops < getShardCount() - 1;
+
+    // A paused game of this user may be held by any shard, the last one logs in fresh
+    LoginArgs login;
+    if (player.state == STATE_LOGIN && id == CMD_CREATE && parseLoginArgs(command, login)) {
+        int pausedLobby = findSession(command.text[0], login.token);
+        if (pausedLobby >= 0) return isLobbyLocal(pausedLobby) ? SHARD_LOCAL : getLobbyOwner(pausedLobby);
+        return SHARD_LOCAL;
+    }
+
+    // Players are paired on their own shard, a shard with a partner waiting takes the player over
+    if (player.state == STATE_MENU && id == CMD_QUEUE && argCount <= 2 && command.numericCount == argCount) {
+        int boardSize = (argCount >= 1) ? command.args[0] : BOARD_SIZE_STANDARD;
+        int rating = (argCount == 2) ? command.args[1] : QUEUE_DEFAULT_RATING;
+        int shard = findMatchQueueShard(boardSize, rating);
+        return (shard >= 0 && shard != getCurrentShard()) ? shard : SHARD_LOCAL;
+    }
+
+    // Malformed numbers stay here and are reported by handleMessage
+    if (player.state == STATE_MENU && (id == CMD_JOIN || id == CMD_BOT || id == CMD_WATCH)) {
+        if (argCount >= 1) {
+            if (command.numericCount < 1) return SHARD_LOCAL;
+            int lobbyId = command.args[0];
+            if (!isValidLobbyId(lobbyId) || isLobbyLocal(lobbyId)) return SHARD_LOCAL;
+            return getLobbyOwner(lobbyId);
+        }
+        // Every shard opens lobbies of its own, it only passes on when all of them are in use
+        if (id == CMD_BOT) {
+            if (findIdleLobby(0, getShardCount(), getCurrentShard()) >= 0) return SHARD_LOCAL;
+            return canHop ? nextShard : SHARD_LOCAL;
+        }
+    }
+
+    // Seated players are served by their lobby's shard, other lobbies are off limits
+    int lobbyId = -1;
+    if (id == CMD_MOVE && argCount == 3 && command.numericCount == 3) lobbyId = command.args[2];
+    else if ((id == CMD_EXIT || id == CMD_REMATCH || id == CMD_RESYNC) && command.numericCount >= 1) lobbyId = command.args[0];
+    if (isValidLobbyId(lobbyId) && !isLobbyLocal(lobbyId)) return SHARD_REJECT;
+    return SHARD_LOCAL;
+}
+
+int handleLobbyJoin(int clientSocket, int lobbyId, Player& player, int boardSize) {
+    if (!isOpenableLobbyId(lobbyId)) {
         return -1; 
     }
 
+    if (findLobbyBySocket(clientSocket) >= 0) {
+        std::cout << "[SERVER] User already connected to a lobby." << std::endl;
+        return -1;
+    }
+
     int result;
     Lobby *lobbyPtr = nullptr;
     {
-        std::lock_guard<std::mutex> lock(lobbies_mutex);
-        for (auto &lobby : lobbies) {
-            if (lobby.isUserConnected(clientSocket)) {
-                std::cout << "[SERVER] User already connected to a lobby." << std::endl;
-                return -1;
-            }
+        // Ids up to a little past the listed ones can be joined, created on demand
+        lobbyPtr = openLobby(lobbyId);
+        LobbyLock lock(*lobbyPtr);
+
+        // An empty lobby takes the size of its first player, the second one has to match
+        bool empty = lobbyPtr->getPlayer1() == nullptr && lobbyPtr->getPlayer2() == nullptr;
+        if (empty && lobbyPtr->getStatus() == ENDED_STATUS) {
+            if (!lobbyPtr->setBoardSize(boardSize)) return -1;
+            result = lobbyPtr->setPlayer(&player);
+        } else if (lobbyPtr->getBoardSize() != boardSize) {
+            std::cout << "[LOBBY " << lobbyId << "] Board size " << boardSize << " does not match "
+                      << lobbyPtr->getBoardSize() << "." << std::endl;
+            result = 3;
+        } else {
+            result = lobbyPtr->setPlayer(&player);
         }
-
-        lobbyPtr = &lobbies[lobbyId];
-        result = lobbyPtr->setPlayer(&player);
     }
 
     if(result > 0) {
@@ -199,17 +425,138 @@ int handleLobbyJoin(int clientSocket, int lobbyId, Player& player) {
     return result;
 }
 
+int handleBotJoin(int clientSocket, int lobbyId, Player& player) {
+    if (lobbyId != -1 && !isOpenableLobbyId(lobbyId)) {
+        return -1;
+    }
+
+    if (findLobbyBySocket(clientSocket) >= 0) {
+        std::cout << "[SERVER] User already connected to a lobby." << std::endl;
+        return -1;
+    }
+
+    // Without an id the lowest idle lobby of this shard is taken (opened if needed)
+    int stride = getShardCount();
+    int offset = lobbiesSharded() ? getCurrentShard() : 0;
+    int candidate = (lobbyId != -1) ? lobbyId : findIdleLobby(0, stride, offset);
+
+    int joinedLobby = -1;
+    for (; candidate >= 0; candidate = (lobbyId != -1) ? -1 : findIdleLobby(candidate + 1, stride, offset)) {
+        if (!isLobbyLocal(candidate)) continue;
+        Lobby &lobby = *openLobby(candidate);
+
+        // Only the lobby being looked at is locked, it may have been taken meanwhile
+        LobbyLock lock(lobby);
+        if (lobby.getPlayer1() != nullptr || lobby.getPlayer2() != nullptr) continue;
+        if (lobby.getStatus() != ENDED_STATUS) continue;
+
+        // The computer only plays the standard board
+        lobby.setBoardSize(BOARD_SIZE_STANDARD);
+
+        Player *bot = acquireBotPlayer();
+
+        if (lobby.setPlayer(&player) != 1 || lobby.setPlayer(bot) != 2) {
+            unseatPlayer(bot);
+            lobby.resetLobby();
+            return -1;
+        }
+        joinedLobby = lobby.getId();
+        break;
+    }
+
+    if (joinedLobby < 0) {
+        std::cout << "[SERVER] No free lobby for a game against the computer." << std::endl;
+        sendConnectInfo(clientSocket, 3);
+        return -1;
+    }
+
+    sendConnectInfo(clientSocket, 1);
+    return joinedLobby;
+}
+
+int handleWatch(int clientSocket, int lobbyId, Player& player) {
+    if (clientSocket < 0 || !isOpenableLobbyId(lobbyId)) return -1;
+
+    if (findLobbyBySocket(clientSocket) >= 0) {
+        std::cout << "[SERVER] User already connected to a lobby." << std::endl;
+        return -1;
+    }
+
+    // Any lobby can be watched, an idle one until its next game starts
+    Lobby &lobby = *openLobby(lobbyId);
+    LobbyLock lock(lobby);
+    if (!lobby.addSpectator(clientSocket)) return -1;
+    player.watchLobby = lobbyId;
+
+    // Same path as the updates that follow, so the view arrives first
+    broadcastMessage({ clientSocket }, lobby.getSpectatorView(), false);
+    return 0;
+}
+
+int handleStopWatching(int clientSocket, Player& player) {
+    Lobby *lobby = findLobby(player.watchLobby);
+    player.watchLobby = -1;
+    if (lobby == nullptr) return -1;
+
+    LobbyLock lock(*lobby);
+    return lobby->removeSpectator(clientSocket) ? 0 : -1;
+}
+
+int seatMatchedPlayers(Player& first, Player& second, int boardSize) {
+    // The lowest idle lobby of this shard, opened if needed
+    int stride = getShardCount();
+    int offset = lobbiesSharded() ? getCurrentShard() : 0;
+
+    for (int candidate = findIdleLobby(0, stride, offset); candidate >= 0; candidate = findIdleLobby(candidate + 1, stride, offset)) {
+        if (!isLobbyLocal(candidate)) continue;
+        Lobby &lobby = *openLobby(candidate);
+
+        // Only the lobby being looked at is locked, it may have been taken meanwhile
+        LobbyLock lock(lobby);
+        if (lobby.getPlayer1() != nullptr || lobby.getPlayer2() != nullptr) continue;
+        if (lobby.getStatus() != ENDED_STATUS) continue;
+
+        if (!lobby.setBoardSize(boardSize)) return -1;
+        if (lobby.setPlayer(&first) != 1 || lobby.setPlayer(&second) != 2) {
+            lobby.resetLobby();
+            return -1;
+        }
+        first.state = STATE_PLAYING;
+        second.state = STATE_PLAYING;
+        return candidate;
+    }
+
+    std::cout << "[SERVER] No free lobby for a matched pair." << std::endl;
+    return -1;
+}
+
+void startMatchedGame(int lobbyId) {
+    Lobby *lobby = findLobby(lobbyId);
+    if (lobby == nullptr) return;
+
+    int socket1, socket2;
+    {
+        LobbyLock lock(*lobby);
+        socket1 = lobby->getPlayerSocket1();
+        socket2 = lobby->getPlayerSocket2();
+    }
+
+    sendConnectInfo(socket1, 1);
+    sendConnectInfo(socket2, 2);
+    startGame(lobbyId);
+    std::cout << "[QUEUE] " << formatMatchQueueStats() << std::endl;
+}
+
 int handleLobbyExit(int clientSocket, int lobbyId) {
-    if (lobbyId < 0 || lobbyId >= LOBBY_COUNT) return -1;
+    Lobby *lobby = findLobby(lobbyId);
+    if (lobby == nullptr) return -1;
     if (clientSocket < 0) return -1;
 
-    Lobby *lobby = nullptr;
     int opponentSocket = -1;
     int leaverId = 0;
     
     {
-        std::lock_guard<std::mutex> lock(lobbies_mutex);
-        lobby = &lobbies[lobbyId];
+        LobbyLock lock(*lobby);
     
         if (lobby->getPlayerSocket1() == clientSocket) {
             leaverId = 1;
@@ -234,21 +581,35 @@ int handleLobbyExit(int clientSocket, int lobbyId) {
     return 0;
 }
 
-int handleMoving(int x, int y, int clientSocket, int lobbyId) {
-    if (lobbyId < 0 || lobbyId >= LOBBY_COUNT) return -1;
-    if (x < 0 || x >= 8 || y < 0 || y >= 8) return -1;
-    if (clientSocket < 0) return -1;
+int handleMoving(int x, int y, int clientSocket, int lobbyId, long expectedVersion) {
+    Lobby *lobby = findLobby(lobbyId);
+    if (lobby == nullptr) return -1;
+    if (x < 0 || y < 0) return -1; // Upper bound depends on the lobby's board size
+    if (clientSocket < 0 && clientSocket != BOT_SOCKET) return -1;
 
     int clientSocket1 = -1, clientSocket2 = -1;
+    bool delta1 = false, delta2 = false;   // The player asked for DELTA instead of STATE
     bool valid = false;
     std::string boardStateMsg; // We will store the message here safely
+    std::string deltaMsg;      // Only the changed squares, for delta players
+    std::string stateFrame, deltaFrame;    // The same for binary players, framed from the board
     std::string extraMsg;      // For END or PASS
-    
-    Lobby *lobby = nullptr;
+    std::string extraFrame;
+    std::vector<int> spectators;
+    std::string spectatorMsg;  // Full board and END or PASS, one buffer for all spectators
+    bool botToMove = false;
+    bool predict = false;
+    unsigned long predictVersion = 0;
+    bool gameOver = false;
+    std::string transcript;    // Finished game, for the game record
 
     {
-        std::lock_guard<std::mutex> lock(lobbies_mutex);
-        lobby = &lobbies[lobbyId];
+        LobbyLock lock(*lobby);
+
+        if (expectedVersion >= 0 && (long)lobby->getStateVersion() != expectedVersion) {
+            std::cout << "[LOBBY " << lobbyId << "] Stale move dropped." << std::endl;
+            return -1;
+        }
 
         int currentPlayer = lobby->canUserPlay(clientSocket);
         if(currentPlayer == -1) {
@@ -264,23 +625,70 @@ int handleMoving(int x, int y, int clientSocket, int lobbyId) {
             int newStatus = lobby->getStatus();
 
 
-            boardStateMsg = "REV STATE " + lobby->getBoardStateString() + "\n";
+            Player *player1 = lobby->getPlayer1();
+            Player *player2 = lobby->getPlayer2();
+            delta1 = player1 != nullptr && player1->deltaUpdates;
+            delta2 = player2 != nullptr && player2->deltaUpdates;
+
+            // Each form is only built if someone gets it
+            bool binary1 = isBinaryClient(clientSocket1), binary2 = isBinaryClient(clientSocket2);
+            bool text1 = clientSocket1 >= 0 && !binary1, text2 = clientSocket2 >= 0 && !binary2;
+            bool frame1 = clientSocket1 >= 0 && binary1, frame2 = clientSocket2 >= 0 && binary2;
+            if ((text1 && !delta1) || (text2 && !delta2)) {
+                boardStateMsg = "REV STATE " + lobby->getBoardStateString() + "\n";
+            }
+            if ((text1 && delta1) || (text2 && delta2)) {
+                deltaMsg = "REV DELTA " + lobby->getDeltaString() + "\n";
+            }
+            if ((frame1 && !delta1) || (frame2 && !delta2)) stateFrame = lobby->getStateFrame();
+            if ((frame1 && delta1) || (frame2 && delta2)) deltaFrame = lobby->getDeltaFrame();
 
             if (newStatus == ENDED_STATUS) {
                 extraMsg = "REV END " + std::to_string(lobby->calculateWinner()) + "\n";
+                if (!serverConfig.gamesPath.empty()) transcript = lobby->getTranscript();
+                gameOver = true;
             } else if (newStatus == currentPlayer) {
                 extraMsg = "REV PASS\n";
             }
+            if (!extraMsg.empty() && (frame1 || frame2)) extraFrame = encodeBinaryMessage(extraMsg);
+
+            if (!lobby->getSpectators().empty()) {
+                spectators = lobby->getSpectators();
+                spectatorMsg = (boardStateMsg.empty() ? "REV STATE " + lobby->getBoardStateString() + "\n" : boardStateMsg) + extraMsg;
+            }
+
+            botToMove = lobby->isBotTurn();
+            predict = newStatus != ENDED_STATUS && lobby->getBoard() != nullptr
+                      && lobby->getEmpties() <= serverConfig.endgameEmpties;
+            predictVersion = lobby->getStateVersion();
         }
     }
 
     if (valid) {
-        if(clientSocket1 != -1) send(clientSocket1, boardStateMsg.c_str(), boardStateMsg.size(), 0);
-        if(clientSocket2 != -1) send(clientSocket2, boardStateMsg.c_str(), boardStateMsg.size(), 0);
+        if(clientSocket1 >= 0) sendPreparedMessage(clientSocket1, delta1 ? deltaMsg : boardStateMsg, delta1 ? deltaFrame : stateFrame);
+        if(clientSocket2 >= 0) sendPreparedMessage(clientSocket2, delta2 ? deltaMsg : boardStateMsg, delta2 ? deltaFrame : stateFrame);
 
         if (!extraMsg.empty()) {
-            if(clientSocket1 != -1) send(clientSocket1, extraMsg.c_str(), extraMsg.size(), 0);
-            if(clientSocket2 != -1) send(clientSocket2, extraMsg.c_str(), extraMsg.size(), 0);
+            if(clientSocket1 >= 0) sendPreparedMessage(clientSocket1, extraMsg, extraFrame);
+            if(clientSocket2 >= 0) sendPreparedMessage(clientSocket2, extraMsg, extraFrame);
+        }
+
+        // A spectator behind on its updates skips to the newest board
+        if (!spectators.empty()) {
+            broadcastMessage(spectators, spectatorMsg, true);
+        }
+
+        if (botToMove) {
+            requestBotMove(lobbyId);
+        }
+        if (predict) {
+            requestScorePrediction(lobbyId, predictVersion);
+        }
+        if (!transcript.empty() && !appendGameRecord(serverConfig.gamesPath, transcript)) {
+            std::cout << "[WARNING] Could not write game record to " << serverConfig.gamesPath << std::endl;
+        }
+        if (gameOver) {
+            std::cout << "[CACHE] " << positionCache->formatStats() << std::endl;
         }
     }
     return 0;
@@ -293,22 +701,28 @@ int handleReconecting(int clientSocket, Player& player, Lobby& lobby, int connec
 
       sendStartingPlayerInfo(clientSocket, lobby.getPlayer1Username(), lobby.getPlayer2Username(), lobby.getStatus(), lobby);
       sendReconnectInfo(connectedUser == 1 ? lobby.getPlayerSocket2() : lobby.getPlayerSocket1());
+
+      // The computer's pending move was dropped while the game was paused
+      if (lobby.isBotTurn()) {
+            requestBotMove(lobby.getId());
+      }
       return 0;
 }
 
 int handleRematch(int clientSocket, int lobbyId) {
-    if(clientSocket < 0 || lobbyId < 0 || lobbyId > LOBBY_COUNT) {
+    Lobby *lobby = findLobby(lobbyId);
+    if(clientSocket < 0 || lobby == nullptr) {
         return -1;
     }
 
-    Lobby *lobby = nullptr;
     int playerSocket1, playerSocket2;
     std::string name1, name2;
     bool wantsRematch = false;
+    std::vector<int> spectators;
+    std::string spectatorView;
 
     {
-        std::lock_guard<std::mutex> lock(lobbies_mutex);
-        lobby = &lobbies[lobbyId];
+        LobbyLock lock(*lobby);
         lobby->setRematch(clientSocket);
 
         wantsRematch = lobby->p1WantsRematch && lobby->p2WantsRematch;
@@ -321,6 +735,9 @@ int handleRematch(int clientSocket, int lobbyId) {
     
             playerSocket1 = lobby->getPlayerSocket1();
             playerSocket2 = lobby->getPlayerSocket2();
+
+            spectators = lobby->getSpectators();
+            if (!spectators.empty()) spectatorView = lobby->getSpectatorView();
         } 
     }
 
@@ -331,24 +748,74 @@ int handleRematch(int clientSocket, int lobbyId) {
         player2->state = STATE_PLAYING;
         sendStartingPlayerInfo(playerSocket1, name1, name2, 1, *lobby);
         sendStartingPlayerInfo(playerSocket2, name1, name2, 1, *lobby);
+        if (!spectators.empty()) broadcastMessage(spectators, spectatorView, false);
+    }
+
+    return 0;
+}
+
+int handleResync(int clientSocket, int lobbyId) {
+    Lobby *found = findLobby(lobbyId);
+    if (found == nullptr) return -1;
+
+    LobbyLock lock(*found);
+    Lobby &lobby = *found;
+    if (!lobby.isUserConnected(clientSocket) && !lobby.isSpectator(clientSocket)) {
+        std::cout << "[LOBBY " << lobbyId << "] Resync refused, client " << clientSocket << " is not seated here." << std::endl;
+        return -1;
     }
 
+    sendState(clientSocket, lobby);
     return 0;
 }
 
+void handleReconnectTimeout(LobbyHandle handle) {
+    Lobby *found = findLobby(handle.id);
+    if (found == nullptr) return;
+
+    int winner = 0;
+    int winnerSocket = -1;
+    std::vector<int> spectators;
+    {
+        LobbyLock lock(*found);
+        Lobby &lobby = *found;
+        // A lobby released since the pause holds another game now
+        if (!isLobbyHandleCurrent(handle)) return;
+        winner = lobby.forfeitDisconnected();
+        spectators = lobby.getSpectators();
+
+        Player *remaining = (winner == 1) ? lobby.getPlayer1() : (winner == 2) ? lobby.getPlayer2() : nullptr;
+        if (remaining != nullptr && !remaining->isBot) {
+            remaining->state = STATE_GAME_OVER;
+            winnerSocket = remaining->socket;
+        }
+    }
+
+    if (winner == 0) return;
+    if (winnerSocket >= 0) {
+        sendMessage(winnerSocket, "REV END " + std::to_string(winner) + "\n");
+    }
+    if (!spectators.empty()) {
+        broadcastMessage(spectators, "REV END " + std::to_string(winner) + "\n", false);
+    }
+    std::cout << "[CACHE] " << positionCache->formatStats() << std::endl;
+}
+
 
 void startGame(int lobbyIndex) {
-    if(lobbyIndex < 0 || lobbyIndex >= LOBBY_COUNT) return;
+    Lobby* lobbyPtr = findLobby(lobbyIndex);
+    if(lobbyPtr == nullptr) return;
 
     std::string p1Name, p2Name;
     int p1Socket, p2Socket;
-    Lobby* lobbyPtr = nullptr;
+    std::vector<int> spectators;
+    std::string spectatorView;
 
     {
-        std::lock_guard<std::mutex> lock(lobbies_mutex);
-
-        lobbyPtr = &lobbies[lobbyIndex];
+        LobbyLock lock(*lobbyPtr);
         lobbyPtr->setStatus(1); 
+        spectators = lobbyPtr->getSpectators();
+        if (!spectators.empty()) spectatorView = lobbyPtr->getSpectatorView();
 
         p1Name = lobbyPtr->getPlayer1Username();
         p2Name = lobbyPtr->getPlayer2Username();
@@ -362,5 +829,6 @@ void startGame(int lobbyIndex) {
     if (lobbyPtr != nullptr) {
         sendStartingPlayerInfo(p1Socket, p1Name, p2Name, 1, *lobbyPtr); 
         sendStartingPlayerInfo(p2Socket, p1Name, p2Name, 1, *lobbyPtr);
+        if (!spectators.empty()) broadcastMessage(spectators, spectatorView, false);
     }
 }
\ No newline at end of file
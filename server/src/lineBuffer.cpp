@@ -0,0 +1,109 @@
+#include "../include/lineBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+#define RING_MASK (LINE_BUFFER_CAPACITY - 1)
+
+static_assert((LINE_BUFFER_CAPACITY & RING_MASK) == 0, "LINE_BUFFER_CAPACITY must be a power of two");
+
+LineBuffer::LineBuffer() : head(0), tail(0), scanned(0), lineLength(std::string_view::npos), framing(0), overflow(false) {}
+
+int LineBuffer::writeVectors(struct iovec vectors[2]) {
+    size_t space = LINE_BUFFER_CAPACITY - (tail - head);
+    if (space == 0) return 0;
+
+    size_t start = tail & RING_MASK;
+    size_t first = std::min(space, (size_t)LINE_BUFFER_CAPACITY - start);
+    vectors[0].iov_base = storage + start;
+    vectors[0].iov_len = first;
+    if (first == space) return 1;
+
+    vectors[1].iov_base = storage;
+    vectors[1].iov_len = space - first;
+    return 2;
+}
+
+void LineBuffer::commit(size_t count) {
+    tail += count;
+}
+
+size_t LineBuffer::append(const char* data, size_t length) {
+    struct iovec vectors[2];
+    int count = writeVectors(vectors);
+
+    size_t taken = 0;
+    for (int i = 0; i < count && taken < length; i++) {
+        size_t part = std::min(length - taken, vectors[i].iov_len);
+        memcpy(vectors[i].iov_base, data + taken, part);
+        taken += part;
+    }
+    commit(taken);
+    return taken;
+}
+
+// `length` bytes from ring position `start`, joined in the scratch buffer if they wrap
+std::string_view LineBuffer::view(size_t start, size_t length) {
+    size_t index = start & RING_MASK;
+    if (index + length <= LINE_BUFFER_CAPACITY) {
+        return std::string_view(storage + index, length);
+    }
+
+    size_t first = LINE_BUFFER_CAPACITY - index;
+    memcpy(frame, storage + index, first);
+    memcpy(frame + first, storage, length - first);
+    return std::string_view(frame, length);
+}
+
+bool LineBuffer::frontFrame(std::string_view& line) {
+    if (tail - head < FRAME_LENGTH_SIZE) return false;
+
+    size_t length = (unsigned char)storage[head & RING_MASK]
+                    | (size_t)(unsigned char)storage[(head + 1) & RING_MASK] << 8;
+    if (length + FRAME_LENGTH_SIZE > MAX_FRAME_SIZE) {
+        overflow = true;
+        return false;
+    }
+    if (tail - head < FRAME_LENGTH_SIZE + length) return false;
+
+    lineLength = length;
+    framing = FRAME_LENGTH_SIZE;
+    line = view(head + FRAME_LENGTH_SIZE, length);
+    return true;
+}
+
+bool LineBuffer::frontLine(std::string_view& line, bool binaryFrames) {
+    if (overflow) return false;
+    if (binaryFrames) return frontFrame(line);
+
+    // Search only the bytes that arrived since the last call
+    bool found = false;
+    while (head + scanned < tail) {
+        size_t position = (head + scanned) & RING_MASK;
+        size_t run = std::min(tail - head - scanned, (size_t)LINE_BUFFER_CAPACITY - position);
+        const char *newline = (const char*)memchr(storage + position, '\n', run);
+        if (newline != nullptr) {
+            scanned += newline - (storage + position);
+            found = true;
+            break;
+        }
+        scanned += run;
+    }
+
+    if (!found || scanned >= MAX_FRAME_SIZE) {
+        if (scanned >= MAX_FRAME_SIZE) overflow = true;
+        return false;
+    }
+
+    lineLength = scanned;
+    framing = 1;
+    line = view(head, lineLength);
+    return true;
+}
+
+void LineBuffer::dropLine() {
+    if (lineLength == std::string_view::npos) return;
+
+    head += lineLength + framing;
+    scanned = 0;
+    lineLength = std::string_view::npos;
+}
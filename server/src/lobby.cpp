@@ -1,6 +1,13 @@
 #include "../include/lobby.h"
 #include "../include/player.h"
 #include "../include/gameLogic.h"
+#include "../include/global.h"
+#include "../include/lobbyIndex.h"
+#include "../include/lobbyPool.h"
+#include "../include/playerPool.h"
+#include "../include/lobbyDirectory.h"
+#include "../include/binaryProtocol.h"
+#include <algorithm>
 #include <iostream>
 
 #define PLAYER_EMPTY 0
@@ -16,39 +23,27 @@ Lobby::Lobby(int id) {
       this->lobbyId = id;
       this->status = 0;
       this->statusBeforePause = 0;
+      this->stateVersion = 0;
       this->player1 = nullptr;
       this->player2 = nullptr;
 
       this->p1WantsRematch = false;
       this->p2WantsRematch = false;
+      this->indexedSockets[0] = -1;
+      this->indexedSockets[1] = -1;
+      this->inUse = false;
+      this->publishedPlayers = 0;
+      this->publishedState = DIRECTORY_OPEN;
+      this->publishedSize = 0;
       
-      /**for (int i = 0; i < 8; ++i) {
-            for (int j = 0; j < 8; ++j) {
-                  board[i][j] = 0;
-            }
-      }
-
-      board[3][3] = PLAYER_ONE; // Black
-      board[4][4] = PLAYER_ONE; // Black
-      board[3][4] = PLAYER_TWO; // White
-      board[4][3] = PLAYER_TWO; // White*/
-
-      std::string customState = "3123000022212033221122133111112011222122111112112111111111111123";
-
-      for (int i = 0; i < 64; ++i) {
-            int row = i / 8;
-            int col = i % 8;
-            
-            int val = customState[i] - '0';
+      /**loadBoard(board, "");
 
-            if (val == 3) {
-                  board[row][col] = 0;
-            } else {
-                  board[row][col] = val;
-            }
-      }
+      setCell(board, 3, 3, PLAYER_ONE); // Black
+      setCell(board, 4, 4, PLAYER_ONE); // Black
+      setCell(board, 4, 3, PLAYER_TWO); // White
+      setCell(board, 3, 4, PLAYER_TWO); // White*/
 
-      getAvaiableMoves(board, PLAYER_ONE);
+      loadStartState(CUSTOM_START_STATE);
 }
 
 // GETTERS
@@ -102,19 +97,24 @@ std::string Lobby::getPlayer2Username() {
 void Lobby::setStatus(int newStatus) {
       if (newStatus < 0) return;
       this->status = newStatus;
+      publishDirectory();
 }
 
 int Lobby::setPlayer(Player* player) {
-      if (player == nullptr || player->socket < 0 || player->username.empty()) {
+      if (player == nullptr || (player->socket < 0 && !player->isBot) || player->username.empty()) {
             return -1;
       }
       if (player1 == nullptr) {
             std ::cout << "[LOBBY " << lobbyId << "] Player 1 joined with socket " << player->socket << std::endl;
             player1 = player;
+            seatPlayer(player, lobbyId);
+            reindex();
             return 1; // Player 1 joined
       } else if (player2 == nullptr) {
             std ::cout << "[LOBBY " << lobbyId << "] Player 2 joined with socket " << player->socket << std::endl;
             player2 = player;
+            seatPlayer(player, lobbyId);
+            reindex();
             return 2; // Player 2 joined
       } else {
             return 3; // Lobby full
@@ -130,20 +130,68 @@ bool Lobby::isUserConnected(int clientSocket) {
       return false;
 }
 
-int Lobby::reconnectUser(Player new_player) {
-      if (player1 != nullptr && player1->username == new_player.username) {
-            player1->socket = new_player.socket;
-            std::cout << "[LOBBY " << lobbyId << "] Player 1 reconnected with socket " << new_player.socket << std::endl;
-            setStatus(statusBeforePause);
-            return 1;
-      } else if (player2 != nullptr && player2->username == new_player.username) {
-            player2->socket = new_player.socket;
-            std::cout << "[LOBBY " << lobbyId << "] Player 2 reconnected with socket " << new_player.socket << std::endl;
-            setStatus(statusBeforePause);
-            return 2;
+bool Lobby::addSpectator(int clientSocket) {
+      if (clientSocket < 0 || isSpectator(clientSocket)) return false;
+      spectators.push_back(clientSocket);
+      if (spectators.size() == 1) setLobbyWatched(lobbyId, true);
+      std::cout << "[LOBBY " << lobbyId << "] Spectator " << clientSocket << " joined, " << spectators.size() << " watching." << std::endl;
+      return true;
+}
+
+bool Lobby::removeSpectator(int clientSocket) {
+      auto it = std::find(spectators.begin(), spectators.end(), clientSocket);
+      if (it == spectators.end()) return false;
+
+      // Order does not matter, the last one takes the slot
+      *it = spectators.back();
+      spectators.pop_back();
+      if (spectators.empty()) setLobbyWatched(lobbyId, false);
+      std::cout << "[LOBBY " << lobbyId << "] Spectator " << clientSocket << " left, " << spectators.size() << " watching." << std::endl;
+      return true;
+}
+
+bool Lobby::isSpectator(int clientSocket) const {
+      return std::find(spectators.begin(), spectators.end(), clientSocket) != spectators.end();
+}
+
+const std::vector<int>& Lobby::getSpectators() const {
+      return spectators;
+}
+
+std::string Lobby::getSpectatorView() {
+      std::string name1 = getPlayer1Username();
+      std::string name2 = getPlayer2Username();
+      return "REV SPECTATE " + std::to_string(status) + " " + (name1.empty() ? "-" : name1) + " " + (name2.empty() ? "-" : name2)
+             + " " + std::to_string(lobbyId) + " " + std::to_string(getBoardSize()) + "\n"
+             + "REV STATE " + getBoardStateString() + "\n";
+}
+
+// The new connection's Player takes the seat, the paused one goes back to the pool
+int Lobby::reconnectUser(Player& player, std::string_view token) {
+      auto resumes = [&](Player *seated) {
+            return seated != nullptr && !seated->isBot && seated->socket == -1 && seated->username == player.username
+                   && !token.empty() && seated->sessionToken == token;
+      };
+      Player **seat = nullptr;
+      int seatNumber = -1;
+      if (resumes(player1)) {
+            seat = &player1;
+            seatNumber = 1;
+      } else if (resumes(player2)) {
+            seat = &player2;
+            seatNumber = 2;
       }
+      if (seat == nullptr) return -1;
 
-      return -1;
+      Player *paused = *seat;
+      *seat = &player;
+      unseatPlayer(paused);
+      seatPlayer(&player, lobbyId);
+
+      std::cout << "[LOBBY " << lobbyId << "] Player " << seatNumber << " reconnected with socket " << player.socket << std::endl;
+      setStatus(statusBeforePause);
+      reindex();
+      return seatNumber;
 }
 
 void Lobby::removePlayer(int socket) {
@@ -169,40 +217,164 @@ void Lobby::removePlayer(int socket) {
       else if (status == ENDED_STATUS || status == PAUSE_STATUS) {
             
             if (player1 != nullptr && player1->socket == socket) {
-                  player1 = nullptr; // Just detach. If they are offline, socket was -1 anyway.
+                  unseatPlayer(player1);
+                  player1 = nullptr;
                   std::cout << "[LOBBY " << lobbyId << "] Player 1 left the lobby." << std::endl;
             }
             else if (player2 != nullptr && player2->socket == socket) {
+                  unseatPlayer(player2);
                   player2 = nullptr;
                   std::cout << "[LOBBY " << lobbyId << "] Player 2 left the lobby." << std::endl;
             }
 
             // A player is "Gone" if the pointer is null (Empty slot) 
             // OR if the socket is -1 (Zombie/Disconnected player waiting for cleanup)
-            bool p1Gone = (player1 == nullptr || player1->socket == -1);
-            bool p2Gone = (player2 == nullptr || player2->socket == -1);
+            // The computer never leaves on its own, it only counts as company.
+            bool p1Gone = (player1 == nullptr || player1->socket == -1 || player1->isBot);
+            bool p2Gone = (player2 == nullptr || player2->socket == -1 || player2->isBot);
 
             if (p1Gone && p2Gone) {
                   resetLobby();
             }
       }
+      reindex();
+}
+
+// Sockets of connected humans (paused seats are found through their session, playerPool.h)
+void Lobby::reindex() {
+      Player* seats[2] = {player1, player2};
+      for (int seat = 0; seat < 2; seat++) {
+            Player *player = seats[seat];
+            bool human = player != nullptr && !player->isBot;
+
+            int socket = human ? player->socket : -1;
+            if (socket != indexedSockets[seat]) {
+                  if (indexedSockets[seat] >= 0) unindexLobbySocket(indexedSockets[seat], lobbyId);
+                  if (socket >= 0) indexLobbySocket(socket, lobbyId);
+                  indexedSockets[seat] = socket;
+            }
+      }
+
+      // In use from the first player on, released once empty (the computer counts)
+      bool occupied = player1 != nullptr || player2 != nullptr;
+      if (occupied != inUse) {
+            inUse = occupied;
+            if (occupied) markLobbyInUse(lobbyId);
+            else releaseLobby(lobbyId);
+      }
+      publishDirectory();
+}
+
+// Only players, game running or not and the board size are published: moves do not change them
+void Lobby::publishDirectory() {
+      int players = (player1 != nullptr) + (player2 != nullptr);
+      int state = (status == PAUSE_STATUS) ? DIRECTORY_PAUSED : (status == ENDED_STATUS) ? DIRECTORY_OPEN : DIRECTORY_PLAYING;
+      int size = getBoardSize();
+      if (players == 0 && publishedPlayers == 0) return;
+      if (players == publishedPlayers && state == publishedState && size == publishedSize) return;
+
+      publishedPlayers = players;
+      publishedState = state;
+      publishedSize = size;
+      updateLobbyDirectory(lobbyId, players, state, size);
+}
+
+int Lobby::forfeitDisconnected() {
+      if (status != PAUSE_STATUS) return 0;
+
+      int winner = 0;
+      if (player1 != nullptr && !player1->isBot && player1->socket == -1) {
+            unseatPlayer(player1);
+            player1 = nullptr;
+            winner = 2;
+      } else if (player2 != nullptr && !player2->isBot && player2->socket == -1) {
+            unseatPlayer(player2);
+            player2 = nullptr;
+            winner = 1;
+      }
+      if (winner == 0) return 0;
+
+      std::cout << "[LOBBY " << lobbyId << "] Player " << (3 - winner) << " did not reconnect, game forfeited." << std::endl;
+      p1WantsRematch = false;
+      p2WantsRematch = false;
+      status = ENDED_STATUS;
+      statusBeforePause = ENDED_STATUS;
+      stateVersion++;
+
+      // Against the computer nobody is left to see the result
+      bool p1Gone = (player1 == nullptr || player1->isBot);
+      bool p2Gone = (player2 == nullptr || player2->isBot);
+      if (p1Gone && p2Gone) {
+            resetLobby();
+      }
+      reindex();
+      return winner;
 }
 
 
 // GAME LOGIC METHODS
 std::string Lobby::getBoardStateString() {
-      std::string state;
-      for (int i = 0; i < 8; ++i) {
-            for (int j = 0; j < 8; ++j) {
-                  state += std::to_string(board[i][j]);
-            }
+      return std::visit([this](auto& current) {
+            std::string message;
+            message.reserve(current.cells.size() + 12);
+            message += current.cells;
+
+            int score1 = getScoreForPlayer(PLAYER_ONE, current.board);
+            int score2 = getScoreForPlayer(PLAYER_TWO, current.board);
+
+            message += " " + std::to_string(score1) + " " + std::to_string(score2) + " " + std::to_string(status);
+            message += " " + std::to_string(stateVersion);
+            return message;
+      }, state);
+}
+
+// "3,12,40" for the set squares, "-" for none
+template <typename Bits>
+static void appendSquareList(std::string& message, Bits squares) {
+      if (!squares) {
+            message += '-';
+            return;
       }
+      bool first = true;
+      while (squares) {
+            if (!first) message += ',';
+            message += std::to_string(lowestSquare(squares));
+            squares &= squares - 1;
+            first = false;
+      }
+}
 
-      int score1 = getScoreForPlayer(PLAYER_ONE, board);
-      int score2 = getScoreForPlayer(PLAYER_TWO, board);
+std::string Lobby::getDeltaString() {
+      return std::visit([this](auto& current) {
+            std::string message;
+            message.reserve(64);
+            message += std::to_string(stateVersion);
+            message += " " + std::to_string(current.lastSquare) + " ";
+            appendSquareList(message, current.lastFlipped);
+            message += ' ';
+            appendSquareList(message, current.board.hints);
+
+            int score1 = getScoreForPlayer(PLAYER_ONE, current.board);
+            int score2 = getScoreForPlayer(PLAYER_TWO, current.board);
+            message += " " + std::to_string(score1) + " " + std::to_string(score2) + " " + std::to_string(status);
+            return message;
+      }, state);
+}
+
+std::string Lobby::getStateFrame() {
+      return std::visit([this](auto& current) {
+            const auto &board = current.board;
+            return encodeStateFrame(board.discs[0], board.discs[1], board.hints, current.SIZE * current.SIZE,
+                                    getScoreForPlayer(PLAYER_ONE, board), getScoreForPlayer(PLAYER_TWO, board), status, stateVersion);
+      }, state);
+}
 
-      state += " " + std::to_string(score1) + " " + std::to_string(score2) + " " + std::to_string(status);
-      return state;
+std::string Lobby::getDeltaFrame() {
+      return std::visit([this](auto& current) {
+            const auto &board = current.board;
+            return encodeDeltaFrame(stateVersion, current.lastSquare, current.lastFlipped, board.hints,
+                                    getScoreForPlayer(PLAYER_ONE, board), getScoreForPlayer(PLAYER_TWO, board), status);
+      }, state);
 }
 
 int Lobby::canUserPlay(int clientSocket) {
@@ -215,42 +387,150 @@ int Lobby::canUserPlay(int clientSocket) {
 }
 
 bool Lobby::validateAndApplyMove(int x, int y, int player) {
-      if (board[y][x] != 3 && board[y][x] != 0) return false;
+      return std::visit([&](auto& current) {
+            return applyMove(current, x, y, player);
+      }, state);
+}
+
+template <int N>
+bool Lobby::applyMove(LobbyBoard<N>& current, int x, int y, int player) {
+      typedef typename BoardGeometry<N>::Bits Bits;
+      BasicBoard<N> &board = current.board;
+
+      if (x < 0 || x >= N || y < 0 || y >= N) return false;
+      int cell = getCell(board, x, y);
+      if (cell != POSSIBLE_MOVE && cell != PLAYER_EMPTY) return false;
 
-      if (processMove(x, y, board, player, true)) {
+      Bits oldHints = board.hints;
+      Bits flipped = 0;
+
+      if (processMove(x, y, board, player, true, &flipped)) {
             
             int opponent = (player == 1) ? 2 : 1;
             
-            // We calculate hints for the OPPONENT now.
-            if (getAvaiableMoves(board, opponent)) {
+            // Hints are calculated for the OPPONENT, then for us on a pass.
+            int nextPlayer = resolveNextPlayer(board, player, positionCache);
+
+            if (nextPlayer == opponent) {
                   setStatus(opponent);
             } 
-            else {
+            else if (nextPlayer == player) {
                   // Opponent Cannot Play (PASS TURN)
-                  std::cout << "[LOBBY " << lobbyId << "] Opponent " << opponent << " has no moves. Checking original player..." << std::endl;
-
-                  if (getAvaiableMoves(board, player)) {
-                        setStatus(player); 
-                        std::cout << "[LOBBY " << lobbyId << "] Turn passed back to Player " << player << std::endl;
-                  } 
-                  else {
-                        // Neither can play (GAME OVER) ---
-                        std::cout << "[LOBBY " << lobbyId << "] No moves possible for anyone. GAME OVER." << std::endl;
-                        setStatus(ENDED_STATUS);
-                  }
+                  std::cout << "[LOBBY " << lobbyId << "] Opponent " << opponent << " has no moves. Turn passed back to Player " << player << std::endl;
+                  setStatus(player); 
+            } 
+            else {
+                  // Neither can play (GAME OVER) ---
+                  std::cout << "[LOBBY " << lobbyId << "] No moves possible for anyone. GAME OVER." << std::endl;
+                  setStatus(ENDED_STATUS);
             }
+
+            // Only the placed stone, the flips and the moved hints change
+            current.refreshCells(flipped | ((Bits)1 << (y * N + x)) | (oldHints ^ board.hints));
+            current.lastSquare = y * N + x;
+            current.lastFlipped = flipped;
+            moveHistory.push_back((uint8_t)(y * N + x));
+            stateVersion++;
             
             return true;
       }
       return false;
 }
 
+template <int N>
+void LobbyBoard<N>::refreshCells(typename BoardGeometry<N>::Bits changed) {
+      if (cells.size() != N * N) {
+            cells.assign(N * N, '0');
+            changed = BoardGeometry<N>::ALL;
+      }
+
+      while (changed) {
+            int square = lowestSquare(changed);
+            changed &= changed - 1;
+            cells[square] = (char)('0' + getCell(board, square % N, square / N));
+      }
+}
+
+void Lobby::loadStartState(const std::string& start) {
+      std::visit([&](auto& current) {
+            loadBoard(current.board, start);
+            getAvaiableMoves(current.board, PLAYER_ONE, positionCache);
+            current.cells.clear();
+            current.refreshCells(0);
+            current.lastSquare = -1;
+            current.lastFlipped = 0;
+      }, state);
+
+      startState = start;
+      moveHistory.clear();
+}
+
+int Lobby::getBoardSize() const {
+      return std::visit([](const auto& current) {
+            return current.SIZE;
+      }, state);
+}
+
+int Lobby::getEmpties() const {
+      return std::visit([](const auto& current) {
+            return current.board.empties;
+      }, state);
+}
+
+bool Lobby::setBoardSize(int size) {
+      if (size == getBoardSize()) return true;
+
+      if (size == BOARD_SIZE_STANDARD) state.emplace<LobbyBoard<BOARD_SIZE_STANDARD>>();
+      else if (size == BOARD_SIZE_SMALL) state.emplace<LobbyBoard<BOARD_SIZE_SMALL>>();
+      else if (size == BOARD_SIZE_LARGE) state.emplace<LobbyBoard<BOARD_SIZE_LARGE>>();
+      else return false;
+
+      std::cout << "[LOBBY " << lobbyId << "] Board size set to " << size << "x" << size << std::endl;
+      loadStartState(getStandardStartState(size));
+      stateVersion++;
+      return true;
+}
+
+const Board* Lobby::getBoard() const {
+      const LobbyBoard<BOARD_SIZE_STANDARD> *current = std::get_if<LobbyBoard<BOARD_SIZE_STANDARD>>(&state);
+      return current != nullptr ? &current->board : nullptr;
+}
+
+unsigned long Lobby::getStateVersion() const {
+      return stateVersion;
+}
+
+std::string Lobby::getTranscript() const {
+      // Game records feed the 8x8 opening book only
+      if (getBoardSize() != BOARD_SIZE_STANDARD) return "";
+
+      std::string transcript = startState;
+      for (uint8_t square : moveHistory) {
+            transcript += ' ';
+            transcript += (char)('a' + square % 8);
+            transcript += (char)('1' + square / 8);
+      }
+      return transcript;
+}
+
+bool Lobby::hasBot() const {
+      return (player1 != nullptr && player1->isBot) || (player2 != nullptr && player2->isBot);
+}
+
+bool Lobby::isBotTurn() const {
+      if (status == PLAYER_ONE) return player1 != nullptr && player1->isBot;
+      if (status == PLAYER_TWO) return player2 != nullptr && player2->isBot;
+      return false;
+}
+
 int Lobby::calculateWinner() {
       if(status != ENDED_STATUS) {
             return -1;
       }
 
-      return(getWinnerResults(board));
+      return std::visit([](const auto& current) {
+            return getWinnerResults(current.board);
+      }, state);
 }
 
 void Lobby::resetLobby() {
@@ -259,49 +539,39 @@ void Lobby::resetLobby() {
     status = ENDED_STATUS;
     statusBeforePause = ENDED_STATUS;
 
-    // --- MEMORY CLEANUP  ---
+    // --- SEATS ---
+    // The pool frees disconnected players and the computer, connected ones stay with their connection
     if (player1 != nullptr) {
-        // If socket is -1, they are a Zombie (Disconnected). We MUST delete them.
-        if (player1->socket == -1) {
-            delete player1;
-            std::cout << "[LOBBY " << lobbyId << "] Player 1 (Zombie) deleted from memory." << std::endl;
-        } else {
-            std::cout << "[LOBBY " << lobbyId << "] Player 1 detached safely." << std::endl;
-        }
+        unseatPlayer(player1);
+        std::cout << "[LOBBY " << lobbyId << "] Player 1 detached." << std::endl;
         player1 = nullptr;
     }
 
     if (player2 != nullptr) {
-        if (player2->socket == -1) {
-            delete player2;
-            std::cout << "[LOBBY " << lobbyId << "] Player 2 (Zombie) deleted from memory." << std::endl;
-        } else {
-            std::cout << "[LOBBY " << lobbyId << "] Player 2 detached safely." << std::endl;
-        }
+        unseatPlayer(player2);
+        std::cout << "[LOBBY " << lobbyId << "] Player 2 detached." << std::endl;
         player2 = nullptr;
     }
+    std::cout << "[LOBBY " << lobbyId << "] Players: " << formatPlayerPoolStats() << std::endl;
 
-    std::string customState = "3123000022212033221122133111112011222122111112112111111111111123";
-
-    for (int i = 0; i < 64; ++i) {
-        int row = i / 8;
-        int col = i % 8;
-        
-        int val = customState[i] - '0';
-
-        if (val == 3) {
-            board[row][col] = 0;
-        } else {
-            board[row][col] = val;
-        }
-    }
+    reindex();
 
-    getAvaiableMoves(board, PLAYER_ONE);
+    // Back to the default 8x8 board, the next JOIN may pick another size
+    state.emplace<LobbyBoard<BOARD_SIZE_STANDARD>>();
+    loadStartState(CUSTOM_START_STATE);
+    stateVersion++;
 }
 
 void Lobby::setRematch(int playerSocket) {
+    // A forfeited seat stays empty, no rematch without an opponent
+    if (player1 == nullptr || player2 == nullptr) return;
+
     if (playerSocket == player1->socket) p1WantsRematch = true;
     if (playerSocket == player2->socket) p2WantsRematch = true;
+
+    // The computer always accepts a rematch
+    if (player1->isBot) p1WantsRematch = true;
+    if (player2->isBot) p2WantsRematch = true;
 }
 
 void Lobby::restartGame() {
@@ -310,19 +580,9 @@ void Lobby::restartGame() {
     p1WantsRematch = false;
     p2WantsRematch = false;
     status = 1; // Set back to Active Game
+    publishDirectory();
 
-    // Clear Board
-    for (int i = 0; i < 8; ++i) {
-        for (int j = 0; j < 8; ++j) {
-            board[i][j] = 0;
-        }
-    }
-
-    // Re-initialize Pieces (Standard or Custom State)
-    board[3][3] = PLAYER_ONE;
-    board[4][4] = PLAYER_ONE;
-    board[3][4] = PLAYER_TWO;
-    board[4][3] = PLAYER_TWO;
-
-    getAvaiableMoves(board, PLAYER_ONE);
+    // Re-initialize Pieces (Standard start of the lobby's board size)
+    loadStartState(getStandardStartState(getBoardSize()));
+    stateVersion++;
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "../include/lobbyDirectory.h"
+#include "../include/lobbyPool.h"
+#include "../include/sender.h"
+#include "../include/binaryProtocol.h"
+#include "../include/shard.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct DirectoryEntry {
+    int players;
+    int state;
+    int boardSize;
+};
+
+struct DirectoryChange {
+    uint64_t version;
+    std::string text;
+};
+
+struct Subscriber {
+    bool binary;
+    uint64_t snapshotVersion;   // Changes up to this one came with the snapshot
+};
+
+// Entries, version and recorded changes; held briefly, also under lobby locks
+static std::mutex directoryMutex;
+static std::map<int, DirectoryEntry> directoryEntries;   // Occupied lobbies, by id
+static uint64_t directoryVersion = 0;
+static std::vector<DirectoryChange> pendingChanges;
+static bool delivering = false;                          // A thread is sending pendingChanges
+
+// Subscribers, held while changes or a snapshot are sent (before directoryMutex)
+static std::mutex deliveryMutex;
+static std::unordered_map<int, Subscriber> subscribers;  // By socket
+static int binarySubscribers = 0;
+
+// Built on demand, for the version it was built at (guarded by deliveryMutex).
+// Every line of the snapshot in one shared buffer, handed to each subscriber as it is.
+static uint64_t snapshotVersion = UINT64_MAX;
+static SharedMessage snapshotText;
+static SharedMessage snapshotFrames;   // Built for the first binary subscriber of a version
+
+// Called with deliveryMutex held. Only the entries are copied under
+// directoryMutex, the lines are built without holding up the lobbies.
+static uint64_t buildSnapshot(bool frames) {
+    std::vector<std::pair<int, DirectoryEntry>> entries;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(directoryMutex);
+        version = directoryVersion;
+        if (version != snapshotVersion) entries.assign(directoryEntries.begin(), directoryEntries.end());
+    }
+
+    if (version != snapshotVersion) {
+        std::string text;
+        std::string versionText = std::to_string(version);
+        size_t next = 0;
+        do {
+            std::string line;
+            for (int count = 0; count < DIRECTORY_CHUNK_ENTRIES && next < entries.size(); count++, next++) {
+                const auto &entry = entries[next];
+                line += ' ' + std::to_string(entry.first) + ':' + std::to_string(entry.second.players) + ':'
+                        + std::to_string(entry.second.state) + ':' + std::to_string(entry.second.boardSize);
+            }
+            bool more = next < entries.size();
+            text += "REV DIRECTORY " + versionText + (more ? " 1" : " 0") + line + "\n";
+        } while (next < entries.size());
+
+        snapshotText = std::make_shared<const std::string>(std::move(text));
+        snapshotFrames.reset();
+        snapshotVersion = version;
+    }
+
+    // One frame per line
+    if (frames && snapshotFrames == nullptr) {
+        const std::string &text = *snapshotText;
+        std::string encoded;
+        size_t start = 0;
+        while (start < text.size()) {
+            size_t end = text.find('\n', start) + 1;
+            encoded += encodeBinaryMessage(text.substr(start, end - start));
+            start = end;
+        }
+        snapshotFrames = std::make_shared<const std::string>(std::move(encoded));
+    }
+    return version;
+}
+
+// False if the entry did not change
+static bool recordChange(int lobbyId, int players, int state, int boardSize) {
+    std::lock_guard<std::mutex> lock(directoryMutex);
+
+    auto it = directoryEntries.find(lobbyId);
+    if (players == 0) {
+        if (it == directoryEntries.end()) return false;
+        directoryEntries.erase(it);
+        state = DIRECTORY_OPEN;
+        boardSize = 0;
+    } else {
+        DirectoryEntry entry = { players, state, boardSize };
+        if (it != directoryEntries.end() && it->second.players == players && it->second.state == state
+            && it->second.boardSize == boardSize) {
+            return false;
+        }
+        directoryEntries[lobbyId] = entry;
+    }
+    directoryVersion++;
+    std::string text = "REV LOBBYDIFF " + std::to_string(directoryVersion) + ' ' + std::to_string(lobbyId) + ' '
+                       + std::to_string(players) + ' ' + std::to_string(state) + ' ' + std::to_string(boardSize) + "\n";
+    pendingChanges.push_back({ directoryVersion, std::move(text) });
+    return true;
+}
+
+void updateLobbyDirectory(int lobbyId, int players, int state, int boardSize) {
+    if (recordChange(lobbyId, players, state, boardSize) && !holdsLobbyLock()) flushLobbyDirectory();
+}
+
+void flushLobbyDirectory() {
+    {
+        std::lock_guard<std::mutex> lock(directoryMutex);
+        if (delivering || pendingChanges.empty()) return;
+        delivering = true;
+    }
+
+    std::vector<DirectoryChange> changes;
+    while (true) {
+        {
+            // Emptiness and the end of delivering are decided together, nothing recorded is left behind
+            std::lock_guard<std::mutex> lock(directoryMutex);
+            if (pendingChanges.empty()) {
+                delivering = false;
+                return;
+            }
+            changes.swap(pendingChanges);
+        }
+
+        // One text line and one frame per change, shared by every subscriber
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        for (DirectoryChange &change : changes) {
+            SharedMessage frame = binarySubscribers > 0 ? std::make_shared<const std::string>(encodeBinaryMessage(change.text))
+                                                        : SharedMessage();
+            SharedMessage text = std::make_shared<const std::string>(std::move(change.text));
+            for (const auto &subscriber : subscribers) {
+                if (change.version <= subscriber.second.snapshotVersion) continue;
+                deliverSharedMessage(subscriber.first, subscriber.second.binary ? frame : text);
+            }
+        }
+        changes.clear();
+    }
+}
+
+int subscribeLobbyDirectory(int clientSocket) {
+    if (clientSocket < 0) return -1;
+    bool binary = isBinaryClient(clientSocket);
+
+    // Written past the batch, so what the batch holds for the client (its SESSION) goes first
+    flushBatch();
+
+    std::lock_guard<std::mutex> delivery(deliveryMutex);
+    auto it = subscribers.find(clientSocket);
+    if (it == subscribers.end()) {
+        it = subscribers.emplace(clientSocket, Subscriber{ binary, 0 }).first;
+        if (binary) binarySubscribers++;
+    }
+    // Changes still waiting to be sent are in the snapshot already
+    it->second.snapshotVersion = buildSnapshot(binary);
+
+    // The lobby count, then the snapshot as it is shared by every subscriber of this version
+    std::string count = "REV LOBBY " + std::to_string(getListedLobbyCount()) + "\n";
+    if (binary) count = encodeBinaryMessage(count);
+    if (deliverMessages(clientSocket, &count, 1) < 0) return -1;
+    return deliverSharedMessage(clientSocket, binary ? snapshotFrames : snapshotText);
+}
+
+void unsubscribeLobbyDirectory(int clientSocket) {
+    std::lock_guard<std::mutex> lock(deliveryMutex);
+    auto it = subscribers.find(clientSocket);
+    if (it == subscribers.end()) return;
+    if (it->second.binary) binarySubscribers--;
+    subscribers.erase(it);
+}
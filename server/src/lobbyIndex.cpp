@@ -0,0 +1,24 @@
+#include "../include/lobbyIndex.h"
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+static std::shared_mutex lobbyIndexMutex;
+static std::unordered_map<int, int> lobbyBySocket;
+
+void indexLobbySocket(int clientSocket, int lobbyId) {
+    std::unique_lock<std::shared_mutex> lock(lobbyIndexMutex);
+    lobbyBySocket[clientSocket] = lobbyId;
+}
+
+void unindexLobbySocket(int clientSocket, int lobbyId) {
+    std::unique_lock<std::shared_mutex> lock(lobbyIndexMutex);
+    auto it = lobbyBySocket.find(clientSocket);
+    if (it != lobbyBySocket.end() && it->second == lobbyId) lobbyBySocket.erase(it);
+}
+
+int findLobbyBySocket(int clientSocket) {
+    std::shared_lock<std::shared_mutex> lock(lobbyIndexMutex);
+    auto it = lobbyBySocket.find(clientSocket);
+    return it != lobbyBySocket.end() ? it->second : -1;
+}
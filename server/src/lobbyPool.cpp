@@ -0,0 +1,233 @@
+#include "../include/lobbyPool.h"
+#include "../include/lobby.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+#define BITS_PER_WORD 64
+
+struct LobbySlab {
+    Lobby *lobbies;   // LOBBY_SLAB_SIZE lobbies, constructed in place and never destroyed
+    std::atomic<uint32_t> generations[LOBBY_SLAB_SIZE];
+};
+
+static std::mutex poolMutex;
+static std::atomic<LobbySlab*> slabs[MAX_LOBBY_SLABS];
+static std::atomic<int> slabCount(0);
+
+// Guarded by poolMutex
+static uint64_t inUse[MAX_LOBBIES / BITS_PER_WORD];
+static int inUseCount = 0;
+static int highestInUse = -1;
+static std::atomic<int> listedCount(MIN_LISTED_LOBBIES);
+static int slabUsers[MAX_LOBBY_SLABS];              // Lobbies in use or watched, per slab
+static int idleSweeps[MAX_LOBBY_SLABS];
+static LobbySlab *retiredSlabs[MAX_LOBBY_SLABS];    // Out of the pool, kept for the next open
+static int retiredSlabCount = 0;
+
+static bool isInUse(int lobbyId) {
+    return (inUse[lobbyId / BITS_PER_WORD] >> (lobbyId % BITS_PER_WORD)) & 1;
+}
+
+static void updateListedCount() {
+    int count = highestInUse + 2;
+    if (count < MIN_LISTED_LOBBIES) count = MIN_LISTED_LOBBIES;
+    if (count > MAX_LOBBIES) count = MAX_LOBBIES;
+    listedCount.store(count, std::memory_order_relaxed);
+}
+
+// Called with poolMutex held: the slab is published, a retired one is taken back as it is
+static LobbySlab* openSlab(int slabIndex) {
+    idleSweeps[slabIndex] = 0;
+    LobbySlab *slab = slabs[slabIndex].load(std::memory_order_relaxed);
+    if (slab != nullptr) return slab;
+
+    slab = retiredSlabs[slabIndex];
+    if (slab != nullptr) {
+        retiredSlabs[slabIndex] = nullptr;
+        retiredSlabCount--;
+    } else {
+        slab = new LobbySlab;
+        slab->lobbies = static_cast<Lobby*>(::operator new(sizeof(Lobby) * LOBBY_SLAB_SIZE));
+        for (int i = 0; i < LOBBY_SLAB_SIZE; i++) {
+            new (&slab->lobbies[i]) Lobby(slabIndex * LOBBY_SLAB_SIZE + i);
+            slab->generations[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Published last, findLobby never sees a half-built slab
+    slabs[slabIndex].store(slab, std::memory_order_release);
+    slabCount++;
+    return slab;
+}
+
+// Takes the slabs idle long enough out of the pool. Their memory is kept: a
+// Lobby* handed out before (a JOIN about to mark it in use, a thread waiting
+// on its lock) stays valid, and a later open reuses the slab as it is.
+static void trimIdleSlabs() {
+    int retired = 0;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (int slabIndex = 1; slabIndex < MAX_LOBBY_SLABS; slabIndex++) {
+            LobbySlab *slab = slabs[slabIndex].load(std::memory_order_relaxed);
+            if (slab == nullptr) continue;
+            if (slabUsers[slabIndex] > 0) {
+                idleSweeps[slabIndex] = 0;
+                continue;
+            }
+            if (++idleSweeps[slabIndex] < LOBBY_TRIM_IDLE_SWEEPS) continue;
+
+            // Handles taken before never match again, even once the slab is back
+            slabs[slabIndex].store(nullptr, std::memory_order_release);
+            for (int i = 0; i < LOBBY_SLAB_SIZE; i++) slab->generations[i].fetch_add(1, std::memory_order_release);
+            retiredSlabs[slabIndex] = slab;
+            retiredSlabCount++;
+            slabCount--;
+            retired++;
+        }
+    }
+
+    if (retired > 0) {
+        std::cout << "[LOBBY] Retired " << retired << " idle slab(s): " << formatLobbyPoolStats() << std::endl;
+    }
+}
+
+static void runLobbyTrimmer() {
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(LOBBY_TRIM_INTERVAL_MS));
+        trimIdleSlabs();
+    }
+}
+
+void initLobbyPool() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        openSlab(0);
+        updateListedCount();
+    }
+    std::thread(runLobbyTrimmer).detach();
+}
+
+bool isValidLobbyId(int lobbyId) {
+    return lobbyId >= 0 && lobbyId < MAX_LOBBIES;
+}
+
+bool isOpenableLobbyId(int lobbyId) {
+    return isValidLobbyId(lobbyId) && lobbyId < listedCount.load(std::memory_order_relaxed) + LOBBY_OPEN_MARGIN;
+}
+
+Lobby* findLobby(int lobbyId) {
+    if (!isValidLobbyId(lobbyId)) return nullptr;
+
+    LobbySlab *slab = slabs[lobbyId / LOBBY_SLAB_SIZE].load(std::memory_order_acquire);
+    return slab != nullptr ? &slab->lobbies[lobbyId % LOBBY_SLAB_SIZE] : nullptr;
+}
+
+Lobby* openLobby(int lobbyId) {
+    Lobby *lobby = findLobby(lobbyId);
+    if (lobby != nullptr || !isValidLobbyId(lobbyId)) return lobby;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    LobbySlab *slab = openSlab(lobbyId / LOBBY_SLAB_SIZE);
+    return &slab->lobbies[lobbyId % LOBBY_SLAB_SIZE];
+}
+
+int findIdleLobby(int first, int stride, int offset) {
+    if (stride < 1) stride = 1;
+    if (first < 0) first = 0;
+    int lobbyId = first + ((offset - first % stride) % stride + stride) % stride;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    while (lobbyId < MAX_LOBBIES) {
+        // Whole words in use are skipped at once
+        if (stride == 1 && lobbyId % BITS_PER_WORD == 0 && inUse[lobbyId / BITS_PER_WORD] == ~0ULL) {
+            lobbyId += BITS_PER_WORD;
+            continue;
+        }
+        if (!isInUse(lobbyId)) return lobbyId;
+        lobbyId += stride;
+    }
+    return -1;
+}
+
+void markLobbyInUse(int lobbyId) {
+    if (!isValidLobbyId(lobbyId)) return;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (isInUse(lobbyId)) return;
+    openSlab(lobbyId / LOBBY_SLAB_SIZE);
+    slabUsers[lobbyId / LOBBY_SLAB_SIZE]++;
+    inUse[lobbyId / BITS_PER_WORD] |= 1ULL << (lobbyId % BITS_PER_WORD);
+    inUseCount++;
+    if (lobbyId > highestInUse) {
+        highestInUse = lobbyId;
+        updateListedCount();
+    }
+}
+
+void releaseLobby(int lobbyId) {
+    if (!isValidLobbyId(lobbyId)) return;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (!isInUse(lobbyId)) return;
+    // A slab with a lobby in use is never taken out
+    LobbySlab *slab = slabs[lobbyId / LOBBY_SLAB_SIZE].load(std::memory_order_relaxed);
+    slabUsers[lobbyId / LOBBY_SLAB_SIZE]--;
+    inUse[lobbyId / BITS_PER_WORD] &= ~(1ULL << (lobbyId % BITS_PER_WORD));
+    inUseCount--;
+    slab->generations[lobbyId % LOBBY_SLAB_SIZE].fetch_add(1, std::memory_order_release);
+
+    // The list shrinks back once the top lobbies are idle
+    if (lobbyId == highestInUse) {
+        int word = lobbyId / BITS_PER_WORD;
+        while (word >= 0 && inUse[word] == 0) word--;
+        highestInUse = word < 0 ? -1 : word * BITS_PER_WORD + (BITS_PER_WORD - 1 - __builtin_clzll(inUse[word]));
+        updateListedCount();
+    }
+}
+
+void setLobbyWatched(int lobbyId, bool watched) {
+    if (!isValidLobbyId(lobbyId)) return;
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (watched) {
+        openSlab(lobbyId / LOBBY_SLAB_SIZE);
+        slabUsers[lobbyId / LOBBY_SLAB_SIZE]++;
+    } else {
+        slabUsers[lobbyId / LOBBY_SLAB_SIZE]--;
+    }
+}
+
+int getListedLobbyCount() {
+    return listedCount.load(std::memory_order_relaxed);
+}
+
+LobbyHandle getLobbyHandle(int lobbyId) {
+    LobbyHandle handle = {lobbyId, 0};
+    LobbySlab *slab = isValidLobbyId(lobbyId) ? slabs[lobbyId / LOBBY_SLAB_SIZE].load(std::memory_order_acquire) : nullptr;
+    if (slab != nullptr) handle.generation = slab->generations[lobbyId % LOBBY_SLAB_SIZE].load(std::memory_order_acquire);
+    return handle;
+}
+
+bool isLobbyHandleCurrent(LobbyHandle handle) {
+    LobbyHandle current = getLobbyHandle(handle.id);
+    return findLobby(handle.id) != nullptr && current.generation == handle.generation;
+}
+
+std::string formatLobbyPoolStats() {
+    int inUseNow, retiredNow;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        inUseNow = inUseCount;
+        retiredNow = retiredSlabCount;
+    }
+    int slabsNow = slabCount.load();
+    return std::to_string(inUseNow) + "/" + std::to_string(slabsNow * LOBBY_SLAB_SIZE) + " lobbies in use ("
+           + std::to_string(slabsNow) + " slab(s) of " + std::to_string(LOBBY_SLAB_SIZE) + ", up to "
+           + std::to_string(MAX_LOBBIES) + ", " + std::to_string(retiredNow) + " retired), " + std::to_string(sizeof(Lobby))
+           + " bytes per lobby";
+}
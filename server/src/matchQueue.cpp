@@ -0,0 +1,228 @@
+#include "../include/matchQueue.h"
+#include "../include/handler.h"
+#include "../include/shard.h"
+#include "../include/boardGeometry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define QUEUE_BOARD_SIZES 3
+#define QUEUE_BANDS (QUEUE_MAX_RATING / QUEUE_RATING_BAND + 1)
+
+struct QueuedPlayer {
+    Player *player;
+    std::chrono::steady_clock::time_point since;
+};
+
+typedef std::list<QueuedPlayer> QueueBucket;
+
+struct QueuePosition {
+    int shard;
+    QueueBucket *bucket;
+    QueueBucket::iterator entry;
+};
+
+static const int queueBoardSizes[QUEUE_BOARD_SIZES] = { BOARD_SIZE_SMALL, BOARD_SIZE_STANDARD, BOARD_SIZE_LARGE };
+
+static std::mutex matchQueueMutex;
+// (shard, board size, band) -> players in arrival order
+static std::vector<QueueBucket> queueBuckets;
+static std::vector<int> queuedPerShard;
+static std::unordered_map<const Player*, QueuePosition> queuedPlayers;
+
+// Time to match, counted per player
+static uint64_t matchedPlayers = 0;
+static uint64_t totalWaitMs = 0;
+static uint64_t longestWaitMs = 0;
+
+static int boardSizeIndex(int boardSize) {
+    for (int i = 0; i < QUEUE_BOARD_SIZES; i++) {
+        if (queueBoardSizes[i] == boardSize) return i;
+    }
+    return -1;
+}
+
+static int queueShard() {
+    return lobbiesSharded() ? std::max(getCurrentShard(), 0) : 0;
+}
+
+static QueueBucket& bucketAt(int shard, int sizeIndex, int band) {
+    return queueBuckets[(shard * QUEUE_BOARD_SIZES + sizeIndex) * QUEUE_BANDS + band];
+}
+
+// The rest is called with matchQueueMutex held
+static void recordMatch(std::chrono::steady_clock::time_point since, std::chrono::steady_clock::time_point now) {
+    uint64_t waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - since).count();
+    matchedPlayers++;
+    totalWaitMs += waited;
+    longestWaitMs = std::max(longestWaitMs, waited);
+}
+
+static void removeQueued(const Player* player) {
+    auto it = queuedPlayers.find(player);
+    if (it == queuedPlayers.end()) return;
+    queuedPerShard[it->second.shard]--;
+    it->second.bucket->erase(it->second.entry);
+    queuedPlayers.erase(it);
+}
+
+// Seats the pair, the one waiting longer as player 1
+static int matchPair(QueuedPlayer first, QueuedPlayer second, int boardSize, std::chrono::steady_clock::time_point now) {
+    int lobbyId = seatMatchedPlayers(*first.player, *second.player, boardSize);
+    if (lobbyId < 0) return -1;
+
+    removeQueued(first.player);
+    removeQueued(second.player);
+    recordMatch(first.since, now);
+    recordMatch(second.since, now);
+    std::cout << "[QUEUE] Lobby " << lobbyId << ": " << first.player->username << " vs " << second.player->username
+              << " (" << boardSize << "x" << boardSize << "), " << matchedPlayers << " matched, "
+              << queuedPlayers.size() << " waiting" << std::endl;
+    return lobbyId;
+}
+
+// Pairs the oldest player of every bucket of the shard within its widened band
+static void matchWaitingPlayers(int shard) {
+    std::vector<int> lobbies;
+    {
+        std::lock_guard<std::mutex> lock(matchQueueMutex);
+        auto now = std::chrono::steady_clock::now();
+        bool lobbiesFree = true;
+
+        for (int sizeIndex = 0; sizeIndex < QUEUE_BOARD_SIZES && lobbiesFree && queuedPerShard[shard] > 1; sizeIndex++) {
+            for (int band = 0; band < QUEUE_BANDS && lobbiesFree; band++) {
+                QueueBucket &bucket = bucketAt(shard, sizeIndex, band);
+                if (bucket.empty()) continue;
+
+                // The oldest player of a bucket has the widest band. Two players
+                // in one bucket only wait together when no lobby was free.
+                QueuedPlayer oldest = bucket.front();
+                long waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - oldest.since).count();
+                int reach = (int)std::min<long>(waited / QUEUE_WIDEN_MS, QUEUE_BANDS);
+
+                // Nearest band first, below before above
+                const QueuedPlayer *partner = nullptr;
+                if (bucket.size() > 1) partner = &*std::next(bucket.begin());
+                for (int distance = 1; partner == nullptr && distance <= reach; distance++) {
+                    if (band - distance >= 0 && !bucketAt(shard, sizeIndex, band - distance).empty()) {
+                        partner = &bucketAt(shard, sizeIndex, band - distance).front();
+                    } else if (band + distance < QUEUE_BANDS && !bucketAt(shard, sizeIndex, band + distance).empty()) {
+                        partner = &bucketAt(shard, sizeIndex, band + distance).front();
+                    }
+                }
+                if (partner == nullptr) continue;
+
+                int lobbyId = matchPair(oldest, *partner, queueBoardSizes[sizeIndex], now);
+                if (lobbyId >= 0) lobbies.push_back(lobbyId);
+                else lobbiesFree = false;   // Next round
+            }
+        }
+    }
+
+    for (int lobbyId : lobbies) startMatchedGame(lobbyId);
+}
+
+static void runMatchQueue() {
+    int shards = getShardCount();
+    std::vector<int> waiting(shards);
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(QUEUE_MATCH_INTERVAL_MS));
+        {
+            std::lock_guard<std::mutex> lock(matchQueueMutex);
+            waiting = queuedPerShard;
+        }
+
+        // Shards pair their own players, on their own thread
+        for (int shard = 0; shard < shards; shard++) {
+            if (waiting[shard] < 2) continue;
+            if (lobbiesSharded()) postToShard(shard, [shard] { matchWaitingPlayers(shard); });
+            else matchWaitingPlayers(shard);
+        }
+    }
+}
+
+void startMatchQueue() {
+    {
+        std::lock_guard<std::mutex> lock(matchQueueMutex);
+        queueBuckets.resize((size_t)getShardCount() * QUEUE_BOARD_SIZES * QUEUE_BANDS);
+        queuedPerShard.assign(getShardCount(), 0);
+    }
+    std::thread(runMatchQueue).detach();
+}
+
+int joinMatchQueue(Player& player, int boardSize, int rating) {
+    int sizeIndex = boardSizeIndex(boardSize);
+    if (sizeIndex < 0 || rating < 0 || rating > QUEUE_MAX_RATING) return -2;
+
+    int lobbyId;
+    {
+        std::lock_guard<std::mutex> lock(matchQueueMutex);
+        if (queuedPlayers.count(&player)) return -1;
+
+        int shard = queueShard();
+        QueueBucket &bucket = bucketAt(shard, sizeIndex, rating / QUEUE_RATING_BAND);
+        auto now = std::chrono::steady_clock::now();
+        QueuedPlayer arrival = { &player, now };
+
+        lobbyId = bucket.empty() ? -1 : matchPair(bucket.front(), arrival, boardSize, now);
+
+        // Without a partner or a free lobby the player waits, the timer pairs it later
+        if (lobbyId < 0) {
+            bucket.push_back(arrival);
+            queuedPlayers[&player] = { shard, &bucket, std::prev(bucket.end()) };
+            queuedPerShard[shard]++;
+        }
+    }
+    return lobbyId;
+}
+
+bool leaveMatchQueue(const Player& player) {
+    std::lock_guard<std::mutex> lock(matchQueueMutex);
+    if (!queuedPlayers.count(&player)) return false;
+    removeQueued(&player);
+    return true;
+}
+
+int getMatchQueueDepth() {
+    std::lock_guard<std::mutex> lock(matchQueueMutex);
+    return (int)queuedPlayers.size();
+}
+
+int findMatchQueueShard(int boardSize, int rating) {
+    int sizeIndex = boardSizeIndex(boardSize);
+    if (sizeIndex < 0 || rating < 0 || rating > QUEUE_MAX_RATING) return -1;
+
+    std::lock_guard<std::mutex> lock(matchQueueMutex);
+    int shards = (int)queuedPerShard.size();
+    int current = queueShard();
+    int band = rating / QUEUE_RATING_BAND;
+
+    // A partner of the same band, else any player of the board size: the
+    // widened bands only pair players waiting on the same shard
+    int nearest = -1, nearestDistance = QUEUE_BANDS;
+    for (int i = 0; i < shards; i++) {
+        int shard = (current + i) % shards;
+        for (int other = 0; other < QUEUE_BANDS; other++) {
+            int distance = std::abs(other - band);
+            if (distance < nearestDistance && !bucketAt(shard, sizeIndex, other).empty()) {
+                nearest = shard;
+                nearestDistance = distance;
+            }
+        }
+    }
+    return nearest;
+}
+
+std::string formatMatchQueueStats() {
+    std::lock_guard<std::mutex> lock(matchQueueMutex);
+    uint64_t averageMs = matchedPlayers ? totalWaitMs / matchedPlayers : 0;
+    return std::to_string(queuedPlayers.size()) + " waiting, " + std::to_string(matchedPlayers) + " matched, time to match "
+           + std::to_string(averageMs) + " ms average, " + std::to_string(longestWaitMs) + " ms longest";
+}
@@ -0,0 +1,112 @@
+#include "../include/messageParser.h"
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <sstream>
+
+// Same separators as the istream tokenizer
+static inline bool isSeparator(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+CommandId lookupCommand(std::string_view name) {
+    switch (name.size()) {
+        case 3:
+            return name == "BOT" ? CMD_BOT : CMD_UNKNOWN;
+        case 4:
+            switch (name[0]) {
+                case 'M': return name == "MOVE" ? CMD_MOVE : CMD_UNKNOWN;
+                case 'J': return name == "JOIN" ? CMD_JOIN : CMD_UNKNOWN;
+                case 'E': return name == "EXIT" ? CMD_EXIT : CMD_UNKNOWN;
+                default: return CMD_UNKNOWN;
+            }
+        case 5:
+            switch (name[0]) {
+                case 'Q': return name == "QUEUE" ? CMD_QUEUE : CMD_UNKNOWN;
+                case 'W': return name == "WATCH" ? CMD_WATCH : CMD_UNKNOWN;
+                default: return CMD_UNKNOWN;
+            }
+        case 6:
+            switch (name[0]) {
+                case 'C': return name == "CREATE" ? CMD_CREATE : CMD_UNKNOWN;
+                case 'R': return name == "RESYNC" ? CMD_RESYNC : CMD_UNKNOWN;
+                default: return CMD_UNKNOWN;
+            }
+        case 7:
+            return name == "REMATCH" ? CMD_REMATCH : CMD_UNKNOWN;
+        case 9:
+            return name == "HEARTBEAT" ? CMD_HEARTBEAT : CMD_UNKNOWN;
+        default:
+            return CMD_UNKNOWN;
+    }
+}
+
+void parseMessage(std::string_view line, ParsedMessage& message) {
+    message.tokenCount = 0;
+
+    size_t position = 0;
+    size_t length = line.size();
+    while (true) {
+        while (position < length && isSeparator(line[position])) position++;
+        if (position == length) break;
+
+        size_t start = position;
+        while (position < length && !isSeparator(line[position])) position++;
+
+        if (message.tokenCount < MAX_MESSAGE_TOKENS) {
+            message.tokens[message.tokenCount] = line.substr(start, position - start);
+        }
+        message.tokenCount++;
+    }
+
+    message.command = lookupCommand(message.arg(1));
+}
+
+bool decodeTextMessage(std::string_view line, ClientCommand& command) {
+    ParsedMessage parsed;
+    parseMessage(line, parsed);
+    if (parsed.tokenCount == 0 || parsed.arg(0) != "REV") return false;
+
+    // A bare prefix gives an empty name and no arguments
+    command.command = parsed.command;
+    command.name = parsed.arg(1);
+    command.argCount = std::max(parsed.tokenCount - 2, 0);
+    command.numericCount = 0;
+
+    int kept = std::min(command.argCount, MAX_COMMAND_ARGS);
+    bool numeric = true;
+    for (int i = 0; i < kept; i++) {
+        command.text[i] = parsed.arg(i + 2);
+        numeric = numeric && parseInt(command.text[i], command.args[i]);
+        if (numeric) command.numericCount++;
+    }
+    return true;
+}
+
+const char* commandName(CommandId command) {
+    switch (command) {
+        case CMD_HEARTBEAT: return "HEARTBEAT";
+        case CMD_CREATE: return "CREATE";
+        case CMD_JOIN: return "JOIN";
+        case CMD_BOT: return "BOT";
+        case CMD_EXIT: return "EXIT";
+        case CMD_MOVE: return "MOVE";
+        case CMD_REMATCH: return "REMATCH";
+        case CMD_RESYNC: return "RESYNC";
+        case CMD_QUEUE: return "QUEUE";
+        case CMD_WATCH: return "WATCH";
+        default: return "";
+    }
+}
+
+bool parseInt(std::string_view token, int& value) {
+    const char *end = token.data() + token.size();
+    std::from_chars_result result = std::from_chars(token.data(), end, value);
+    return !token.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+std::vector<std::string> splitMessage(const std::string &s) {
+    std::istringstream iss(s);
+    return std::vector<std::string>{std::istream_iterator<std::string>{iss},
+                                    std::istream_iterator<std::string>{}};
+}
@@ -0,0 +1,185 @@
+#include "../include/openingBook.h"
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline uint64_t mirrorColumns(uint64_t x) {
+      const uint64_t k1 = 0x5555555555555555ULL;
+      const uint64_t k2 = 0x3333333333333333ULL;
+      const uint64_t k4 = 0x0f0f0f0f0f0f0f0fULL;
+      x = ((x >> 1) & k1) | ((x & k1) << 1);
+      x = ((x >> 2) & k2) | ((x & k2) << 2);
+      x = ((x >> 4) & k4) | ((x & k4) << 4);
+      return x;
+}
+
+// (x, y) -> (y, x)
+static inline uint64_t transpose(uint64_t x) {
+      const uint64_t k1 = 0x5500550055005500ULL;
+      const uint64_t k2 = 0x3333000033330000ULL;
+      const uint64_t k4 = 0x0f0f0f0f00000000ULL;
+      uint64_t t;
+      t = k4 & (x ^ (x << 28));
+      x ^= t ^ (t >> 28);
+      t = k2 & (x ^ (x << 14));
+      x ^= t ^ (t >> 14);
+      t = k1 & (x ^ (x << 7));
+      x ^= t ^ (t >> 7);
+      return x;
+}
+
+uint64_t transformBitboard(uint64_t bits, int symmetry) {
+      if (symmetry & 4) bits = transpose(bits);
+      if (symmetry & 1) bits = mirrorColumns(bits);
+      if (symmetry & 2) bits = __builtin_bswap64(bits);
+      return bits;
+}
+
+int canonicalizePosition(uint64_t &own, uint64_t &opp) {
+      uint64_t bestOwn = own;
+      uint64_t bestOpp = opp;
+      int bestSymmetry = 0;
+
+      for (int symmetry = 1; symmetry < 8; symmetry++) {
+            uint64_t o = transformBitboard(own, symmetry);
+            uint64_t p = transformBitboard(opp, symmetry);
+            if (o < bestOwn || (o == bestOwn && p < bestOpp)) {
+                  bestOwn = o;
+                  bestOpp = p;
+                  bestSymmetry = symmetry;
+            }
+      }
+
+      own = bestOwn;
+      opp = bestOpp;
+      return bestSymmetry;
+}
+
+OpeningBook::OpeningBook() : mapping(nullptr), mappingSize(0), entries(nullptr), count(0) {}
+
+OpeningBook::~OpeningBook() {
+      close();
+}
+
+bool OpeningBook::open(const std::string& path) {
+      close();
+
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+
+      struct stat info;
+      if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(BookHeader)) {
+            ::close(fd);
+            return false;
+      }
+
+      size_t size = (size_t)info.st_size;
+      void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd); // The mapping keeps the file alive
+      if (data == MAP_FAILED) return false;
+
+      // Only the header is checked, the records are used as they are
+      const BookHeader *header = (const BookHeader *)data;
+      if (memcmp(header->magic, BOOK_MAGIC, sizeof(header->magic)) != 0
+          || header->count > (size - sizeof(BookHeader)) / sizeof(BookRecord)) {
+            munmap(data, size);
+            return false;
+      }
+
+      // Lookups touch a handful of pages, read-ahead would only waste I/O
+      madvise(data, size, MADV_RANDOM);
+
+      mapping = data;
+      mappingSize = size;
+      entries = (const BookRecord *)((const char *)data + sizeof(BookHeader));
+      count = header->count;
+      return true;
+}
+
+void OpeningBook::close() {
+      if (mapping != nullptr) munmap(mapping, mappingSize);
+      mapping = nullptr;
+      mappingSize = 0;
+      entries = nullptr;
+      count = 0;
+}
+
+size_t OpeningBook::size() const {
+      return count;
+}
+
+const BookRecord* OpeningBook::records() const {
+      return entries;
+}
+
+const BookRecord* OpeningBook::findPosition(uint64_t own, uint64_t opp, size_t &found) const {
+      found = 0;
+
+      // Lower bound of (own, opp)
+      size_t low = 0, high = count;
+      while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            const BookRecord &record = entries[mid];
+            if (record.own < own || (record.own == own && record.opp < opp)) low = mid + 1;
+            else high = mid;
+      }
+
+      size_t end = low;
+      while (end < count && entries[end].own == own && entries[end].opp == opp) end++;
+      if (end == low) return nullptr;
+
+      found = end - low;
+      return &entries[low];
+}
+
+int OpeningBook::lookup(const Board& board, int player, unsigned minGames) const {
+      if (count == 0 || (player != 1 && player != 2)) return -1;
+
+      uint64_t own = board.discs[player - 1];
+      uint64_t opp = board.discs[2 - player];
+      uint64_t legal = getMoveMask(own, opp);
+
+      uint64_t canonicalOwn = own, canonicalOpp = opp;
+      int symmetry = canonicalizePosition(canonicalOwn, canonicalOpp);
+
+      size_t found;
+      const BookRecord *first = findPosition(canonicalOwn, canonicalOpp, found);
+      if (first == nullptr) return -1;
+
+      // Smoothed average result, rarely played moves do not look perfect
+      const BookRecord *best = nullptr;
+      double bestValue = -1.0;
+      for (size_t i = 0; i < found; i++) {
+            const BookRecord &record = first[i];
+            if (record.games < minGames) continue;
+            double value = (record.points + 1.0) / (2.0 * record.games + 2.0);
+            if (value > bestValue || (value == bestValue && record.games > best->games)) {
+                  bestValue = value;
+                  best = &record;
+            }
+      }
+      if (best == nullptr) return -1;
+
+      // Map the canonical move back to the board's orientation
+      uint64_t target = 1ULL << best->square;
+      for (uint64_t bits = legal; bits; bits &= bits - 1) {
+            int square = __builtin_ctzll(bits);
+            if (transformBitboard(1ULL << square, symmetry) == target) return square;
+      }
+      return -1;
+}
+
+static std::mutex recordMutex;
+
+bool appendGameRecord(const std::string& path, const std::string& transcript) {
+      std::lock_guard<std::mutex> lock(recordMutex);
+
+      std::ofstream out(path, std::ios::app);
+      if (!out) return false;
+      out << transcript << "\n";
+      return (bool)out;
+}
@@ -0,0 +1,316 @@
+#include "../include/outbox.h"
+#include "../include/sender.h"
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define FLUSHER_MAX_EVENTS 64
+
+// A queued message, shared with the other recipients of a broadcast
+struct OutboxChunk {
+    SharedMessage data;
+    size_t offset;     // Bytes already written
+    bool skippable;    // Replaced by a newer skippable message while nothing of it is written
+};
+
+struct Outbox {
+    std::mutex mutex;
+    std::deque<OutboxChunk> pending;   // What the socket did not take yet, in order
+    size_t pendingBytes = 0;
+    bool closed = false;   // Closed or shut down, nothing is written anymore
+};
+
+static std::shared_mutex outboxesMutex;
+static std::unordered_map<int, std::shared_ptr<Outbox>> outboxes;
+static int flusherEpoll = -1;
+
+// Messages of the open batches, per thread
+static thread_local int batchDepth = 0;
+static thread_local std::vector<std::pair<int, std::string>> batchMessages;
+static thread_local std::vector<std::function<void()>> batchTasks;   // Run once the batch is written
+
+static std::shared_ptr<Outbox> findOutbox(int clientSocket) {
+    std::shared_lock<std::shared_mutex> lock(outboxesMutex);
+    auto it = outboxes.find(clientSocket);
+    return it == outboxes.end() ? nullptr : it->second;
+}
+
+// Wakes the flusher once the socket can take more (one-shot, re-armed per backlog)
+static void armFlusher(int clientSocket) {
+    struct epoll_event event = {};
+    event.events = EPOLLOUT | EPOLLONESHOT;
+    event.data.fd = clientSocket;
+    if (epoll_ctl(flusherEpoll, EPOLL_CTL_MOD, clientSocket, &event) < 0 && errno == ENOENT) {
+        epoll_ctl(flusherEpoll, EPOLL_CTL_ADD, clientSocket, &event);
+    }
+}
+
+// The rest is called with the outbox locked
+static void queueChunk(Outbox &outbox, SharedMessage data, size_t offset, bool skippable) {
+    outbox.pendingBytes += data->size() - offset;
+    outbox.pending.push_back({ std::move(data), offset, skippable });
+}
+
+static void clearPending(Outbox &outbox) {
+    outbox.pending.clear();
+    outbox.pendingBytes = 0;
+}
+
+// Drops the written bytes from the front
+static void consumePending(Outbox &outbox, size_t written) {
+    outbox.pendingBytes -= written;
+    while (written > 0) {
+        OutboxChunk &chunk = outbox.pending.front();
+        size_t left = chunk.data->size() - chunk.offset;
+        if (written < left) {
+            chunk.offset += written;
+            return;
+        }
+        written -= left;
+        outbox.pending.pop_front();
+    }
+}
+
+// After the backlog grew
+static void checkBacklog(int clientSocket, Outbox &outbox) {
+    if (outbox.pending.empty()) return;
+
+    if (outbox.pendingBytes > OUTBOX_HIGH_WATER) {
+        std::cout << "[OUTBOX] Client " << clientSocket << " fell " << outbox.pendingBytes
+                  << " bytes behind, disconnecting." << std::endl;
+        outbox.closed = true;
+        clearPending(outbox);
+        shutdown(clientSocket, SHUT_RDWR);
+        return;
+    }
+    armFlusher(clientSocket);
+}
+
+static void flushOutbox(int clientSocket) {
+    std::shared_ptr<Outbox> outbox = findOutbox(clientSocket);
+    if (outbox == nullptr) return;
+
+    std::lock_guard<std::mutex> lock(outbox->mutex);
+    if (outbox->closed || outbox->pending.empty()) return;
+
+    struct iovec vectors[OUTBOX_MAX_IOVECS];
+    int count = 0;
+    for (auto it = outbox->pending.begin(); it != outbox->pending.end() && count < OUTBOX_MAX_IOVECS; ++it, count++) {
+        vectors[count].iov_base = (void*)(it->data->data() + it->offset);
+        vectors[count].iov_len = it->data->size() - it->offset;
+    }
+    struct msghdr header = {};
+    header.msg_iov = vectors;
+    header.msg_iovlen = count;
+
+    ssize_t written = sendmsg(clientSocket, &header, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (written < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            outbox->closed = true;   // The reader notices the broken connection
+            clearPending(*outbox);
+            return;
+        }
+        written = 0;
+    }
+
+    consumePending(*outbox, written);
+    if (!outbox->pending.empty()) armFlusher(clientSocket);
+}
+
+static void runFlusher() {
+    struct epoll_event events[FLUSHER_MAX_EVENTS];
+    while (true) {
+        int count = epoll_wait(flusherEpoll, events, FLUSHER_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            return;
+        }
+        for (int i = 0; i < count; i++) flushOutbox(events[i].data.fd);
+    }
+}
+
+void startOutboxFlusher() {
+    flusherEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (flusherEpoll < 0) {
+        perror("epoll_create1");
+        return;
+    }
+    std::thread(runFlusher).detach();
+}
+
+void openOutbox(int clientSocket) {
+    std::unique_lock<std::shared_mutex> lock(outboxesMutex);
+    outboxes[clientSocket] = std::make_shared<Outbox>();
+}
+
+void closeOutbox(int clientSocket) {
+    std::shared_ptr<Outbox> outbox;
+    {
+        std::unique_lock<std::shared_mutex> lock(outboxesMutex);
+        auto it = outboxes.find(clientSocket);
+        if (it == outboxes.end()) return;
+        outbox = std::move(it->second);
+        outboxes.erase(it);
+    }
+
+    // Writers still holding it must not touch the descriptor number once it is reused
+    std::lock_guard<std::mutex> lock(outbox->mutex);
+    outbox->closed = true;
+    clearPending(*outbox);
+    if (flusherEpoll >= 0) epoll_ctl(flusherEpoll, EPOLL_CTL_DEL, clientSocket, nullptr);
+}
+
+int writeToOutbox(int clientSocket, const std::string* messages, int count) {
+    if (count > OUTBOX_MAX_IOVECS) {
+        std::string joined;
+        for (int i = 0; i < count; i++) joined += messages[i];
+        return writeToOutbox(clientSocket, &joined, 1);
+    }
+
+    // No outbox: the client is gone (or was never registered), the number may belong to another descriptor
+    std::shared_ptr<Outbox> outbox = findOutbox(clientSocket);
+    if (outbox == nullptr) return -1;
+
+    std::lock_guard<std::mutex> lock(outbox->mutex);
+    if (outbox->closed) return -1;
+
+    // Earlier bytes are still queued, these go behind them
+    if (!outbox->pending.empty()) {
+        for (int i = 0; i < count; i++) queueChunk(*outbox, std::make_shared<const std::string>(messages[i]), 0, false);
+        checkBacklog(clientSocket, *outbox);
+        return 0;
+    }
+
+    struct iovec vectors[OUTBOX_MAX_IOVECS];
+    for (int i = 0; i < count; i++) {
+        vectors[i].iov_base = (void*)messages[i].data();
+        vectors[i].iov_len = messages[i].size();
+    }
+    struct msghdr header = {};
+    header.msg_iov = vectors;
+    header.msg_iovlen = count;
+
+    ssize_t written = sendmsg(clientSocket, &header, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (written < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return -1;
+        written = 0;
+    }
+
+    // Keep the part of the batch the socket did not take
+    for (int i = 0; i < count; i++) {
+        size_t length = messages[i].size();
+        if ((size_t)written >= length) {
+            written -= length;
+            continue;
+        }
+        queueChunk(*outbox, std::make_shared<const std::string>(messages[i], written), 0, false);
+        written = 0;
+    }
+    checkBacklog(clientSocket, *outbox);
+    return 0;
+}
+
+int writeSharedToOutbox(int clientSocket, const SharedMessage& message, bool skippable) {
+    std::shared_ptr<Outbox> outbox = findOutbox(clientSocket);
+    if (outbox == nullptr) return -1;
+
+    std::lock_guard<std::mutex> lock(outbox->mutex);
+    if (outbox->closed) return -1;
+
+    // Behind a backlog: skip forward, unsent skippable messages are replaced by this one
+    if (!outbox->pending.empty()) {
+        if (skippable) {
+            for (auto it = outbox->pending.begin(); it != outbox->pending.end();) {
+                if (it->skippable && it->offset == 0) {
+                    outbox->pendingBytes -= it->data->size();
+                    it = outbox->pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        queueChunk(*outbox, message, 0, skippable);
+        checkBacklog(clientSocket, *outbox);
+        return 0;
+    }
+
+    ssize_t written = send(clientSocket, message->data(), message->size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (written < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return -1;
+        written = 0;
+    }
+
+    // The rest stays in the shared buffer, nothing is copied
+    if ((size_t)written < message->size()) queueChunk(*outbox, message, written, skippable);
+    checkBacklog(clientSocket, *outbox);
+    return 0;
+}
+
+MessageBatch::MessageBatch() {
+    batchDepth++;
+}
+
+// One write per client, the clients in order of their first message
+static void writeBatch() {
+    std::vector<std::pair<int, std::string>> messages;
+    messages.swap(batchMessages);
+
+    std::vector<std::string> group;
+    for (size_t i = 0; i < messages.size(); i++) {
+        int clientSocket = messages[i].first;
+        if (clientSocket < 0) continue;
+
+        group.clear();
+        for (size_t j = i; j < messages.size(); j++) {
+            if (messages[j].first != clientSocket) continue;
+            group.push_back(std::move(messages[j].second));
+            if (j > i) messages[j].first = -1;
+        }
+        deliverMessages(clientSocket, group.data(), (int)group.size());
+    }
+
+    // Keep the capacity for the next batch of this thread
+    messages.clear();
+    if (batchMessages.empty()) batchMessages.swap(messages);
+}
+
+MessageBatch::~MessageBatch() {
+    if (--batchDepth > 0) return;
+    writeBatch();
+
+    // A task may open a batch of its own, its tasks then run when that one ends
+    std::vector<std::function<void()>> tasks;
+    tasks.swap(batchTasks);
+    for (auto &task : tasks) task();
+}
+
+bool addToBatch(int clientSocket, const std::string& message) {
+    if (batchDepth == 0) return false;
+    batchMessages.emplace_back(clientSocket, message);
+    return true;
+}
+
+void flushBatch() {
+    if (batchDepth > 0) writeBatch();
+}
+
+void runAfterBatch(std::function<void()> task) {
+    if (batchDepth == 0) {
+        task();
+        return;
+    }
+    batchTasks.push_back(std::move(task));
+}
@@ -0,0 +1,112 @@
+#include "../include/playerPool.h"
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+static std::mutex playerPoolMutex;
+static std::vector<Player*> freePlayers;
+static std::unordered_map<std::string, Player*> sessions;   // Paused seats by session token
+static std::mt19937_64 tokenGenerator(std::random_device{}());
+static int playersInUse = 0;
+
+// Called with playerPoolMutex held
+static Player* takePlayer(int socket) {
+    Player *player;
+    if (!freePlayers.empty()) {
+        player = freePlayers.back();
+        freePlayers.pop_back();
+    } else {
+        player = new Player(socket);
+    }
+
+    // Field by field, the name keeps its capacity
+    player->socket = socket;
+    player->username.clear();
+    player->tolerance = 0;
+    player->isBot = false;
+    player->binaryProtocol = false;
+    player->deltaUpdates = false;
+    player->sessionToken.clear();
+    player->state = STATE_LOGIN;
+    player->connected = false;
+    player->seatLobby = -1;
+    player->watchLobby = -1;
+    playersInUse++;
+    return player;
+}
+
+static void endSession(Player* player) {
+    if (player->sessionToken.empty()) return;
+    auto it = sessions.find(player->sessionToken);
+    if (it != sessions.end() && it->second == player) sessions.erase(it);
+}
+
+static void recyclePlayer(Player* player) {
+    endSession(player);
+    freePlayers.push_back(player);
+    playersInUse--;
+}
+
+Player* acquirePlayer(int clientSocket) {
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    Player *player = takePlayer(clientSocket);
+    player->connected = true;
+    return player;
+}
+
+Player* acquireBotPlayer() {
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    Player *bot = takePlayer(BOT_SOCKET);
+    bot->isBot = true;
+    bot->username = BOT_USERNAME;
+    bot->state = STATE_PLAYING;
+    return bot;
+}
+
+const std::string& issueSessionToken(Player* player) {
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    endSession(player);
+    char token[17];
+    snprintf(token, sizeof(token), "%016llx", (unsigned long long)tokenGenerator());
+    player->sessionToken = token;
+    return player->sessionToken;
+}
+
+void seatPlayer(Player* player, int lobbyId) {
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    endSession(player);
+    player->seatLobby = lobbyId;
+}
+
+void unseatPlayer(Player* player) {
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    endSession(player);
+    player->seatLobby = -1;
+    if (!player->connected) recyclePlayer(player);
+}
+
+void releaseConnection(Player* player) {
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    player->connected = false;
+    if (player->seatLobby >= 0 && !player->isBot && !player->sessionToken.empty()) {
+        sessions[player->sessionToken] = player;
+    } else if (player->seatLobby < 0) {
+        recyclePlayer(player);
+    }
+}
+
+int findSession(std::string_view username, std::string_view token) {
+    if (token.empty()) return -1;
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    auto it = sessions.find(std::string(token));
+    if (it == sessions.end() || it->second->username != username) return -1;
+    return it->second->seatLobby;
+}
+
+std::string formatPlayerPoolStats() {
+    std::lock_guard<std::mutex> lock(playerPoolMutex);
+    return std::to_string(playersInUse) + " players in use, " + std::to_string(freePlayers.size()) + " pooled, "
+           + std::to_string(sessions.size()) + " paused session(s)";
+}
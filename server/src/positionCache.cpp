@@ -0,0 +1,177 @@
+#include "../include/positionCache.h"
+#include <sstream>
+#include <iomanip>
+
+PositionCache::PositionCache(size_t requested) {
+      size_t setsPerShard = 1;
+      while (setsPerShard * POSITION_CACHE_WAYS * POSITION_CACHE_SHARDS < requested) setsPerShard <<= 1;
+
+      setMask = setsPerShard - 1;
+      capacity = setsPerShard * POSITION_CACHE_WAYS * POSITION_CACHE_SHARDS;
+
+      shards.reset(new Shard[POSITION_CACHE_SHARDS]);
+      for (int i = 0; i < POSITION_CACHE_SHARDS; i++) {
+            Shard &shard = shards[i];
+            shard.entries.reset(new Entry[setsPerShard * POSITION_CACHE_WAYS]());
+            shard.clock = 0;
+            shard.used = 0;
+            for (int kind = 0; kind < CACHE_KIND_COUNT; kind++) {
+                  shard.lookups[kind] = 0;
+                  shard.hits[kind] = 0;
+            }
+      }
+}
+
+PositionCache::Shard& PositionCache::shardFor(uint64_t key) {
+      // Top bits pick the shard, low bits the set inside it
+      return shards[key >> 60 & (POSITION_CACHE_SHARDS - 1)];
+}
+
+PositionCache::Entry* PositionCache::findLocked(Shard& shard, uint64_t key, const Board& board, int player) {
+      Entry *set = &shard.entries[(key & setMask) * POSITION_CACHE_WAYS];
+      for (int way = 0; way < POSITION_CACHE_WAYS; way++) {
+            Entry &entry = set[way];
+            if (entry.player == player && entry.key == key
+                && entry.discs[0] == board.discs[0] && entry.discs[1] == board.discs[1]) {
+                  entry.lastUse = ++shard.clock;
+                  return &entry;
+            }
+      }
+      return nullptr;
+}
+
+PositionCache::Entry& PositionCache::insertLocked(Shard& shard, uint64_t key, const Board& board, int player) {
+      Entry *found = findLocked(shard, key, board, player);
+      if (found != nullptr) return *found;
+
+      // Free slot first, otherwise the least recently used one of the set
+      Entry *set = &shard.entries[(key & setMask) * POSITION_CACHE_WAYS];
+      Entry *victim = &set[0];
+      for (int way = 0; way < POSITION_CACHE_WAYS; way++) {
+            Entry &entry = set[way];
+            if (entry.player == 0) {
+                  victim = &entry;
+                  shard.used++;
+                  break;
+            }
+            if ((int32_t)(entry.lastUse - victim->lastUse) < 0) victim = &entry;
+      }
+
+      victim->key = key;
+      victim->discs[0] = board.discs[0];
+      victim->discs[1] = board.discs[1];
+      victim->player = (uint8_t)player;
+      victim->flags = 0;
+      victim->lastUse = ++shard.clock;
+      return *victim;
+}
+
+uint64_t PositionCache::getMoveMask(const Board& board, int player) {
+      uint64_t key = getPositionKey(board, player);
+      Shard &shard = shardFor(key);
+      {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.lookups[CACHE_LEGAL_MOVES]++;
+            Entry *entry = findLocked(shard, key, board, player);
+            if (entry != nullptr && (entry->flags & (1 << CACHE_LEGAL_MOVES))) {
+                  shard.hits[CACHE_LEGAL_MOVES]++;
+                  return entry->legal;
+            }
+      }
+
+      // Computed without the lock, another thread may store the same mask
+      uint64_t legal = ::getMoveMask(board.discs[player - 1], board.discs[2 - player]);
+
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      Entry &entry = insertLocked(shard, key, board, player);
+      entry.legal = legal;
+      entry.flags |= 1 << CACHE_LEGAL_MOVES;
+      return legal;
+}
+
+bool PositionCache::getEvaluation(const Board& board, int player, CachedEvaluation& evaluation) {
+      uint64_t key = getPositionKey(board, player);
+      Shard &shard = shardFor(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      shard.lookups[CACHE_EVALUATION]++;
+      Entry *entry = findLocked(shard, key, board, player);
+      if (entry == nullptr || !(entry->flags & (1 << CACHE_EVALUATION))) return false;
+
+      shard.hits[CACHE_EVALUATION]++;
+      evaluation.square = entry->evalMove;
+      evaluation.score = entry->evalScore;
+      evaluation.depth = entry->evalDepth;
+      return true;
+}
+
+void PositionCache::storeEvaluation(const Board& board, int player, const CachedEvaluation& evaluation) {
+      uint64_t key = getPositionKey(board, player);
+      Shard &shard = shardFor(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      Entry &entry = insertLocked(shard, key, board, player);
+      // Keep the deeper of two results for the same position
+      if ((entry.flags & (1 << CACHE_EVALUATION)) && entry.evalDepth > evaluation.depth) return;
+
+      entry.evalMove = (int8_t)evaluation.square;
+      entry.evalScore = (int16_t)evaluation.score;
+      entry.evalDepth = (int8_t)evaluation.depth;
+      entry.flags |= 1 << CACHE_EVALUATION;
+}
+
+bool PositionCache::getSolved(const Board& board, int player, CachedSolve& solve) {
+      uint64_t key = getPositionKey(board, player);
+      Shard &shard = shardFor(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      shard.lookups[CACHE_SOLVED]++;
+      Entry *entry = findLocked(shard, key, board, player);
+      if (entry == nullptr || !(entry->flags & (1 << CACHE_SOLVED))) return false;
+
+      shard.hits[CACHE_SOLVED]++;
+      solve.square = entry->solvedMove;
+      solve.score = entry->solvedScore;
+      return true;
+}
+
+void PositionCache::storeSolved(const Board& board, int player, const CachedSolve& solve) {
+      uint64_t key = getPositionKey(board, player);
+      Shard &shard = shardFor(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      Entry &entry = insertLocked(shard, key, board, player);
+      entry.solvedMove = (int8_t)solve.square;
+      entry.solvedScore = (int8_t)solve.score;
+      entry.flags |= 1 << CACHE_SOLVED;
+}
+
+PositionCacheStats PositionCache::getStats() const {
+      PositionCacheStats stats = {};
+      stats.capacity = capacity;
+
+      for (int i = 0; i < POSITION_CACHE_SHARDS; i++) {
+            const Shard &shard = shards[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.used += shard.used;
+            for (int kind = 0; kind < CACHE_KIND_COUNT; kind++) {
+                  stats.lookups[kind] += shard.lookups[kind];
+                  stats.hits[kind] += shard.hits[kind];
+            }
+      }
+      return stats;
+}
+
+std::string PositionCache::formatStats() const {
+      static const char *KIND_NAMES[CACHE_KIND_COUNT] = {"legal", "eval", "solved"};
+      PositionCacheStats stats = getStats();
+
+      std::ostringstream out;
+      out << stats.used << "/" << stats.capacity << " entries";
+      for (int kind = 0; kind < CACHE_KIND_COUNT; kind++) {
+            double rate = stats.lookups[kind] > 0 ? 100.0 * stats.hits[kind] / stats.lookups[kind] : 0.0;
+            out << ", " << KIND_NAMES[kind] << " " << stats.hits[kind] << "/" << stats.lookups[kind]
+                << " (" << std::fixed << std::setprecision(1) << rate << "%)";
+      }
+      return out.str();
+}
@@ -0,0 +1,335 @@
+#include "../include/reactor.h"
+#include "../include/server.h"
+#include "../include/handler.h"
+#include "../include/global.h"
+#include "../include/shard.h"
+#include "../include/playerPool.h"
+#include <iostream>
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+enum ReadResult {
+    READ_OPEN,
+    READ_CLOSED,
+    READ_MOVED      // Handed over to another shard, no longer ours
+};
+
+// One reactor thread with its own listener, epoll instance and clients
+struct ReactorShard {
+    int index;
+    int epollFd;
+    int listenSocket;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    TimerWheel wheel;    // Idle deadlines of the connections
+};
+
+static std::vector<std::unique_ptr<ReactorShard>> shards;
+static thread_local ReactorShard *currentShard = nullptr;
+
+// epoll tags: the listener is nullptr, the mailbox eventfd this address, clients their Connection
+static char mailboxTag;
+
+// Lets the process use every descriptor it is allowed to (connections are only fd-bound now)
+static void raiseDescriptorLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return;
+    if (limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    getrlimit(RLIMIT_NOFILE, &limit);
+    std::cout << "[REACTOR] Descriptor limit: " << limit.rlim_cur << std::endl;
+}
+
+static bool setNonBlocking(int socket) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool watchConnection(ReactorShard &shard, Connection *connection) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = connection;
+    if (epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, connection->socket, &event) < 0) {
+        perror("epoll_ctl");
+        return false;
+    }
+    return true;
+}
+
+static void closeConnection(ReactorShard &shard, Connection *connection) {
+    int clientSocket = connection->socket;
+
+    epoll_ctl(shard.epollFd, EPOLL_CTL_DEL, clientSocket, nullptr);
+    releaseClient(clientSocket, connection->player);
+    unregisterClient(clientSocket);
+    close(clientSocket);
+
+    shard.connections.erase(clientSocket);
+}
+
+// Activity only moves lastActivity, the timer re-arms itself for the rest when it fires early
+static void onIdleTimer(void *context) {
+    Connection *connection = (Connection*)context;
+    auto idleFor = std::chrono::steady_clock::now() - connection->lastActivity;
+    auto remaining = std::chrono::seconds(CLIENT_TIMEOUT_SEC) - idleFor;
+
+    if (remaining > std::chrono::milliseconds(0)) {
+        long remainingMs = (long)std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count();
+        currentShard->wheel.schedule(connection->idleTimer, remainingMs);
+        return;
+    }
+    std::cout << "[REACTOR] Client " << connection->socket << " timed out" << std::endl;
+    closeConnection(*currentShard, connection);
+}
+
+static void armIdleTimer(ReactorShard &shard, Connection *connection) {
+    auto deadline = connection->lastActivity + std::chrono::seconds(CLIENT_TIMEOUT_SEC);
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    long remainingMs = (long)std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count();
+
+    connection->idleTimer.setCallback(onIdleTimer, connection);
+    shard.wheel.schedule(connection->idleTimer, remainingMs);
+}
+
+static void acceptConnections(ReactorShard &shard) {
+    while (true) {
+        int clientSocket = accept4(shard.listenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientSocket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE) {
+                std::cout << "[REACTOR] Out of file descriptors, " << shard.connections.size() << " clients connected." << std::endl;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept failed");
+            }
+            return;
+        }
+
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->socket = clientSocket;
+        connection->player = nullptr;
+        connection->hops = 0;
+        connection->lastActivity = std::chrono::steady_clock::now();
+
+        if (!watchConnection(shard, connection.get())) {
+            close(clientSocket);
+            continue;
+        }
+
+        registerClient(clientSocket);
+        armIdleTimer(shard, connection.get());
+        shard.connections[clientSocket] = std::move(connection);
+    }
+}
+
+static ReadResult processLines(ReactorShard &shard, Connection *connection);
+
+// Runs on the target shard: takes the connection over and handles what it has buffered
+static void adoptConnection(ReactorShard &shard, Connection *connection) {
+    shard.connections[connection->socket].reset(connection);
+    armIdleTimer(shard, connection);
+
+    // Bytes that arrived during the move make the fd ready right away (edge-triggered add)
+    if (!watchConnection(shard, connection) || processLines(shard, connection) == READ_CLOSED) {
+        closeConnection(shard, connection);
+    }
+}
+
+// Hands the connection to another shard, its unhandled lines travel in the buffer
+static void moveConnection(ReactorShard &shard, Connection *connection, int target) {
+    epoll_ctl(shard.epollFd, EPOLL_CTL_DEL, connection->socket, nullptr);
+    connection->idleTimer.cancel();   // Wheels are per shard, the target arms it again
+
+    auto it = shard.connections.find(connection->socket);
+    it->second.release();
+    shard.connections.erase(it);
+
+    connection->hops++;
+    ReactorShard *targetShard = shards[target].get();
+    postToShard(target, [targetShard, connection] { adoptConnection(*targetShard, connection); });
+}
+
+// Handles the complete lines received so far
+static ReadResult processLines(ReactorShard &shard, Connection *connection) {
+    std::string_view message;
+    while (connection->lines.frontLine(message, connection->player->binaryProtocol)) {
+
+        // Lobby commands are handled by the shard owning the lobby
+        if (lobbiesSharded()) {
+            int target = selectMessageShard(message, *connection->player, connection->hops);
+            if (target == SHARD_REJECT) {
+                std::cout << "[SECURITY] Client " << connection->socket << " named a lobby of another shard." << std::endl;
+                connection->lines.dropLine();
+                continue;
+            }
+            if (target != SHARD_LOCAL && target != shard.index) {
+                moveConnection(shard, connection, target);
+                return READ_MOVED;
+            }
+            connection->hops = 0;
+        }
+
+        handleMessage(connection->socket, message, *connection->player);
+        connection->lines.dropLine();
+    }
+
+    if (connection->lines.overflowed()) {
+        std::cout << "[SECURITY] Client " << connection->socket << " exceeded " << MAX_FRAME_SIZE << " bytes per message." << std::endl;
+        return READ_CLOSED;
+    }
+
+    // Too many malformed messages
+    return connection->player->tolerance > 3 ? READ_CLOSED : READ_OPEN;
+}
+
+// Drains the socket (edge-triggered)
+static ReadResult readConnection(ReactorShard &shard, Connection *connection) {
+    while (true) {
+        // Straight into the free part of the ring
+        struct iovec vectors[2];
+        int vectorCount = connection->lines.writeVectors(vectors);
+        ssize_t received = readv(connection->socket, vectors, vectorCount);
+        if (received == 0) return READ_CLOSED;
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? READ_OPEN : READ_CLOSED;
+        }
+
+        if (connection->player == nullptr) {
+            connection->player = acquirePlayer(connection->socket);
+        }
+        connection->lastActivity = std::chrono::steady_clock::now();
+
+        connection->lines.commit(received);
+        ReadResult result = processLines(shard, connection);
+        if (result != READ_OPEN) return result;
+    }
+}
+
+static void pinToCpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0) std::cout << "[REACTOR] Could not pin to CPU " << cpu << ": " << strerror(error) << std::endl;
+}
+
+static void runShard(ReactorShard &shard, int cpu) {
+    setCurrentShard(shard.index);
+    currentShard = &shard;
+    if (cpu >= 0) pinToCpu(cpu);
+
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    // The epoll_wait timeout is the wheel tick, so timers fire even when no client talks
+    while (true) {
+        int count = epoll_wait(shard.epollFd, events, REACTOR_MAX_EVENTS, TIMER_TICK_MS);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == nullptr) {
+                acceptConnections(shard);
+                continue;
+            }
+            if (events[i].data.ptr == &mailboxTag) {
+                runShardMailbox(shard.index);
+                continue;
+            }
+
+            // Data queued before a hang-up is still handled, readConnection then sees EOF
+            Connection *connection = (Connection*)events[i].data.ptr;
+            ReadResult result = READ_OPEN;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                result = readConnection(shard, connection);
+            }
+            if (result == READ_MOVED) continue;
+            if (result == READ_CLOSED || (events[i].events & (EPOLLHUP | EPOLLERR))) {
+                closeConnection(shard, connection);
+            }
+        }
+
+        shard.wheel.advance(std::chrono::steady_clock::now());
+    }
+
+    close(shard.epollFd);
+}
+
+static bool setupShard(ReactorShard &shard, int index, int listenSocket) {
+    shard.index = index;
+    shard.listenSocket = listenSocket;
+    shard.epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (shard.epollFd < 0 || !setNonBlocking(listenSocket)) {
+        perror("epoll setup failed");
+        return false;
+    }
+
+    struct epoll_event listenEvent = {};
+    listenEvent.events = EPOLLIN | EPOLLET;
+    listenEvent.data.ptr = nullptr;
+
+    struct epoll_event mailboxEvent = {};
+    mailboxEvent.events = EPOLLIN | EPOLLET;
+    mailboxEvent.data.ptr = &mailboxTag;
+
+    if (epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, listenSocket, &listenEvent) < 0
+        || epoll_ctl(shard.epollFd, EPOLL_CTL_ADD, getShardWakeFd(index), &mailboxEvent) < 0) {
+        perror("epoll_ctl");
+        close(shard.epollFd);
+        return false;
+    }
+    return true;
+}
+
+void runEpollServer(int serverSocket) {
+    runShardedEpollServer(std::vector<int>{serverSocket});
+}
+
+void runShardedEpollServer(const std::vector<int>& listenSockets) {
+    raiseDescriptorLimit();
+
+    int count = (int)listenSockets.size();
+    for (int i = 0; i < count; i++) {
+        shards.emplace_back(new ReactorShard());
+        if (!setupShard(*shards[i], i, listenSockets[i])) return;
+    }
+
+    if (count == 1) {
+        std::cout << "[REACTOR] Serving clients with epoll." << std::endl;
+        runShard(*shards[0], -1);
+        return;
+    }
+
+    // Shard i is pinned to the i-th CPU this process may run on (wrapping around)
+    std::vector<int> cpus;
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+    }
+
+    std::cout << "[REACTOR] Serving clients with " << count << " epoll reactors, lobby i on reactor i % "
+              << count << "." << std::endl;
+
+    for (int i = 1; i < count; i++) {
+        int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        std::thread(runShard, std::ref(*shards[i]), cpu).detach();
+    }
+    runShard(*shards[0], cpus.empty() ? -1 : cpus[0]);
+}
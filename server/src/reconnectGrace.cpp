@@ -0,0 +1,69 @@
+#include "../include/reconnectGrace.h"
+#include "../include/timerWheel.h"
+#include "../include/handler.h"
+#include "../include/global.h"
+#include "../include/shard.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// The lobby may be released and reused while the timer runs, the handle tells
+struct GraceTimer {
+    Timer timer;
+    LobbyHandle lobby;
+};
+
+static std::mutex graceMutex;
+static TimerWheel graceWheel;
+static std::unordered_map<int, GraceTimer> graceTimers;   // Paused lobbies only, by id
+static std::vector<LobbyHandle> expiredLobbies;   // Collected under graceMutex, forfeited after it
+
+static void onGraceExpired(void *context) {
+    auto it = graceTimers.find((int)(intptr_t)context);
+    if (it == graceTimers.end()) return;
+    expiredLobbies.push_back(it->second.lobby);
+    graceTimers.erase(it);
+}
+
+static void runGraceTimers() {
+    std::vector<LobbyHandle> expired;
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(TIMER_TICK_MS));
+        {
+            std::lock_guard<std::mutex> lock(graceMutex);
+            graceWheel.advance(std::chrono::steady_clock::now());
+            expired.swap(expiredLobbies);
+        }
+
+        // The forfeit takes the lobby lock, never while holding graceMutex
+        for (LobbyHandle lobby : expired) {
+            runOnLobbyOwner(lobby.id, [lobby] { handleReconnectTimeout(lobby); });
+        }
+        expired.clear();
+    }
+}
+
+void startReconnectGrace() {
+    if (serverConfig.reconnectGraceSec <= 0) return;
+    std::thread(runGraceTimers).detach();
+}
+
+void armReconnectGrace(int lobbyId) {
+    if (serverConfig.reconnectGraceSec <= 0 || !isValidLobbyId(lobbyId)) return;
+
+    std::lock_guard<std::mutex> lock(graceMutex);
+    GraceTimer &grace = graceTimers[lobbyId];
+    grace.lobby = getLobbyHandle(lobbyId);
+    grace.timer.setCallback(onGraceExpired, (void*)(intptr_t)lobbyId);
+    graceWheel.schedule(grace.timer, serverConfig.reconnectGraceSec * 1000L);
+}
+
+void cancelReconnectGrace(int lobbyId) {
+    if (!isValidLobbyId(lobbyId)) return;
+
+    std::lock_guard<std::mutex> lock(graceMutex);
+    graceTimers.erase(lobbyId);   // The timer unlinks itself
+}
@@ -1,14 +1,119 @@
 #include "../include/sender.h"
 #include "../include/global.h"
+#include "../include/outbox.h"
+#include "../include/binaryProtocol.h"
+#include "../include/lobbyDirectory.h"
 #include <iostream>
 #include <sys/socket.h>
 #include <string>
 
+static TransmitFunction transmitFunction = nullptr;
+
+int sendMessage(int clientSocket, const std::string& message) {
+    if (clientSocket < 0) {
+        return -1;
+    }
+
+    // Clients of the binary protocol get every message as a frame
+    if (isBinaryClient(clientSocket)) {
+        std::string frame = encodeBinaryMessage(message);
+        if (addToBatch(clientSocket, frame)) {
+            return 0;
+        }
+        return deliverMessages(clientSocket, &frame, 1);
+    }
+
+    if (addToBatch(clientSocket, message)) {
+        return 0;
+    }
+    return deliverMessages(clientSocket, &message, 1);
+}
+
+int sendPreparedMessage(int clientSocket, const std::string& message, const std::string& frame) {
+    if (clientSocket < 0) {
+        return -1;
+    }
+
+    const std::string &encoded = isBinaryClient(clientSocket) ? frame : message;
+    if (addToBatch(clientSocket, encoded)) {
+        return 0;
+    }
+    return deliverMessages(clientSocket, &encoded, 1);
+}
+
+int deliverMessages(int clientSocket, const std::string* messages, int count) {
+    if (transmitFunction != nullptr) {
+        for (int i = 0; i < count; i++) transmitFunction(clientSocket, messages[i]);
+        return 0;
+    }
+
+    return writeToOutbox(clientSocket, messages, count);
+}
+
+int deliverSharedMessage(int clientSocket, const SharedMessage& message) {
+    if (transmitFunction != nullptr) {
+        transmitFunction(clientSocket, *message);
+        return 0;
+    }
+
+    return writeSharedToOutbox(clientSocket, message, false);
+}
+
+void setTransmitFunction(TransmitFunction function) {
+    transmitFunction = function;
+}
+
+int broadcastMessage(const std::vector<int>& clientSockets, const std::string& message, bool skippable) {
+    if (message.empty()) return -1;
+
+    SharedMessage text = std::make_shared<const std::string>(message);
+    SharedMessage frames;   // Built for the first binary recipient
+
+    for (int clientSocket : clientSockets) {
+        if (clientSocket < 0) continue;
+
+        const SharedMessage *shared = &text;
+        if (isBinaryClient(clientSocket)) {
+            if (frames == nullptr) {
+                // One frame per line
+                std::string encoded;
+                size_t start = 0;
+                while (start < message.size()) {
+                    size_t end = message.find('\n', start);
+                    end = (end == std::string::npos) ? message.size() : end + 1;
+                    encoded += encodeBinaryMessage(message.substr(start, end - start));
+                    start = end;
+                }
+                frames = std::make_shared<const std::string>(std::move(encoded));
+            }
+            shared = &frames;
+        }
+
+        if (transmitFunction != nullptr) transmitFunction(clientSocket, **shared);
+        else writeSharedToOutbox(clientSocket, *shared, skippable);
+    }
+    return 0;
+}
+
 int sendConnectInfo(int clientSocket, int playerNumber) {
+    if (clientSocket < 0) {
+        return -1;
+    }
+
     std::string prefix(PREFIX_GAME);
     std::string message = prefix + " CONNECT " + std::to_string(playerNumber) + "\n";
     
-    send(clientSocket, message.c_str(), message.size(), 0);
+    sendMessage(clientSocket, message);
+    return 0;
+}
+
+int sendQueueInfo(int clientSocket, int depth) {
+    if (clientSocket < 0) {
+        return -1;
+    }
+
+    std::string prefix(PREFIX_GAME);
+    sendMessage(clientSocket, prefix + " QUEUED " + std::to_string(depth) + "\n");
     return 0;
 }
 
@@ -20,7 +125,7 @@ int sendDisconnectInfo(int clientSocket, int disconnectedUser) {
     std::string prefix(PREFIX_GAME);
     std::string message = prefix + " DISCONNECT " + std::to_string(disconnectedUser) + "\n";
 
-    send(clientSocket, message.c_str(), message.size(), 0);
+    sendMessage(clientSocket, message);
     return 0;
 }
 
@@ -32,18 +137,35 @@ int sendReconnectInfo(int clientSocket) {
     std::string prefix(PREFIX_GAME);
     std::string message = prefix + " RECONNECT" + "\n";
 
-    send(clientSocket, message.c_str(), message.size(), 0);
+    sendMessage(clientSocket, message);
+    return 0;
+}
+
+int sendSessionToken(int clientSocket, const std::string& token) {
+    if(clientSocket < 0) {
+        return -1;
+    }
+
+    std::string prefix(PREFIX_GAME);
+    std::string message = prefix + " SESSION " + token + "\n";
+
+    sendMessage(clientSocket, message);
     return 0;
 }
 
 int sendStartingPlayerInfo(int clientSocket, std::string player1, std::string player2, int playerNumber, Lobby& lobby) {
+    if (clientSocket < 0) {
+        return -1;
+    }
+
     std::string prefix(PREFIX_GAME);
     std::cout << "Sending state" << std::endl;
     // Send START message
     std::string message = prefix + " START " + std::to_string(playerNumber);
     message += " " + player1 + " " + player2 + " " + std::to_string(lobby.getId());
+    message += " " + std::to_string(lobby.getBoardSize());
     message += "\n";
-    send(clientSocket, message.c_str(), message.size(), 0);
+    sendMessage(clientSocket, message);
 
     sendState(clientSocket, lobby);
     return 0;
@@ -56,17 +178,31 @@ int sendState(int clientSocket, Lobby& lobby) {
         return -1;
     }
 
+    // Binary clients get the frame built from the board, no text in between
+    if (isBinaryClient(clientSocket)) {
+        return sendPreparedMessage(clientSocket, std::string(), lobby.getStateFrame());
+    }
+
     std::string boardState = prefix + " STATE " + lobby.getBoardStateString() + "\n";
-    send(clientSocket, boardState.c_str(), boardState.size(), 0);
+    sendMessage(clientSocket, boardState);
     return 0;
 }
 
 int sendLobbyList(int clientSocket) {
     if(!clientSocket || clientSocket < 0) return 1;
 
+    // The count, the directory snapshot and from then on its changes
+    return subscribeLobbyDirectory(clientSocket);
+}
+
+int sendPrediction(int clientSocket, int winner, int margin) {
+    if (clientSocket < 0) {
+        return -1;
+    }
+
     std::string prefix(PREFIX_GAME);
-    std::string lobbyList = prefix + " LOBBY " + std::to_string(LOBBY_COUNT) + "\n";
-    
-    send(clientSocket, lobbyList.c_str(), lobbyList.size(), 0);
+    std::string message = prefix + " PREDICT " + std::to_string(winner) + " " + std::to_string(margin) + "\n";
+
+    sendMessage(clientSocket, message);
     return 0;
-}
\ No newline at end of file
+}
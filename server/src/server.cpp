@@ -2,11 +2,26 @@
 #include "../include/handler.h"
 #include "../include/sender.h"
 #include "../include/global.h"
+#include "../include/simdMoves.h"
+#include "../include/bot.h"
+#include "../include/reactor.h"
+#include "../include/uringReactor.h"
+#include "../include/shard.h"
+#include "../include/lineBuffer.h"
+#include "../include/outbox.h"
+#include "../include/reconnectGrace.h"
+#include "../include/binaryProtocol.h"
+#include "../include/lobbyIndex.h"
+#include "../include/playerPool.h"
+#include "../include/matchQueue.h"
+#include "../include/lobbyDirectory.h"
 #include <iostream>
 #include <cstring>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <thread>
@@ -15,28 +30,28 @@
 #include <vector>
 
 // Define Globals Here
-std::vector<Lobby> lobbies; 
 std::vector<int> clientSockets; 
 std::mutex clients_mutex;
-std::mutex lobbies_mutex;
+ServerConfig serverConfig = {
+    500,    // botMoveTimeMs
+    4,      // botThreads
+    3,      // smpHelpers
+    20,     // endgameEmpties
+    "book.bin", // bookPath
+    "",     // gamesPath
+    65536,  // cacheEntries
+    IO_THREADS, // ioMode
+    1,      // reactorCount
+    60      // reconnectGraceSec
+};
+PositionCache *positionCache = nullptr;
 
-void startServer(std::string ip, int port) {
-    int server_fd, new_socket;
+// Bound, listening TCP socket. With reusePort several of them share the port,
+// the kernel then spreads incoming connections across them.
+static int openListenSocket(const std::string& ip, int port, bool reusePort) {
+    int server_fd;
     struct sockaddr_in address;
     int opt = 1;
-    int addrlen = sizeof(address);
-
-    int finalPort;
-
-    if (port > 0) {
-        finalPort = port;
-    } else {
-        finalPort = PORT; 
-    }
-    
-    for (int i = 0; i < LOBBY_COUNT; ++i) {
-        lobbies.emplace_back(i);
-    }
 
     if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
         perror("socket failed");
@@ -47,6 +62,10 @@ void startServer(std::string ip, int port) {
         perror("setsockopt");
         exit(EXIT_FAILURE);
     }
+    if (reusePort && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) {
+        perror("setsockopt SO_REUSEPORT");
+        exit(EXIT_FAILURE);
+    }
 
     memset(&address, 0, sizeof(address));
     address.sin_family = AF_INET;
@@ -55,32 +74,86 @@ void startServer(std::string ip, int port) {
     } else {
         address.sin_addr.s_addr = INADDR_ANY;
     }
-    address.sin_port = htons(finalPort);
+    address.sin_port = htons(port);
     if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
         perror("bind failed");
         close(server_fd);
         exit(EXIT_FAILURE);
     }
 
-    if (listen(server_fd, 3) < 0) {
+    // A large backlog, bursts of connects are accepted in batches by the reactor
+    if (listen(server_fd, SOMAXCONN) < 0) {
         perror("listen failed");
         close(server_fd);
         exit(EXIT_FAILURE);
     }
+    return server_fd;
+}
+
+void startServer(std::string ip, int port) {
+    int server_fd, new_socket;
+    struct sockaddr_in address;
+    int addrlen = sizeof(address);
+
+    int finalPort;
+
+    if (port > 0) {
+        finalPort = port;
+    } else {
+        finalPort = PORT; 
+    }
+    
+    // Pick the fastest move generator this CPU can run (verified against scalar)
+    initMoveKernels(SIMD_AVX512);
+    positionCache = new PositionCache(serverConfig.cacheEntries);
+    std::cout << "[CACHE] Position cache: " << positionCache->formatStats() << std::endl;
+    startBotService(serverConfig.botThreads);
+    startOutboxFlusher();
+
+    initLobbyPool();
+    std::cout << "[LOBBY] Pool: " << formatLobbyPoolStats() << std::endl;
+    initShards(serverConfig.reactorCount);
+    startReconnectGrace();
+    startMatchQueue();
+
+    // Every reactor shard gets its own listener on the same port
+    if (serverConfig.reactorCount > 1) {
+        if (serverConfig.ioMode != IO_EPOLL) {
+            std::cout << "[SERVER] --reactors runs epoll reactors, the --io mode is ignored." << std::endl;
+            serverConfig.ioMode = IO_EPOLL;
+        }
+        std::vector<int> listenSockets;
+        for (int i = 0; i < serverConfig.reactorCount; ++i) {
+            listenSockets.push_back(openListenSocket(ip, finalPort, true));
+        }
+        std::cout << "Server is listening on port " << finalPort << " with "
+                  << serverConfig.reactorCount << " reactors..." << std::endl;
+
+        runShardedEpollServer(listenSockets);
+        for (int listenSocket : listenSockets) close(listenSocket);
+        return;
+    }
+    server_fd = openListenSocket(ip, finalPort, false);
 
     std::cout << "Server is listening on port " << PORT << "..." << std::endl;
 
+    if (serverConfig.ioMode == IO_URING && !runUringServer(server_fd)) {
+        std::cout << "[SERVER] io_uring is not available, falling back to epoll." << std::endl;
+        serverConfig.ioMode = IO_EPOLL;
+    }
+    if (serverConfig.ioMode == IO_EPOLL) {
+        runEpollServer(server_fd);
+        close(server_fd);
+        return;
+    }
+
     while(true) {
         if ((new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen)) < 0) {
             perror("accept failed");
             continue; 
         }
 
-        {
-            std::lock_guard<std::mutex> lock(clients_mutex);
-            std::cout << "Connection accepted!" << std::endl;
-            clientSockets.push_back(new_socket);
-        }
+        registerClient(new_socket);
 
         std::thread client_thread(handleClientLogic, new_socket);
         client_thread.detach(); 
@@ -90,15 +163,14 @@ void startServer(std::string ip, int port) {
 }
 
 void handleClientLogic(int clientSocket) {
-    std::string dataBuffer = ""; 
-    char tempBuffer[1024];
+    LineBuffer lineBuffer;
 
     // Create new player
     Player *new_player = nullptr;
 
     // 8s timeout for pingpong
     struct timeval tv;
-    tv.tv_sec = 8;
+    tv.tv_sec = CLIENT_TIMEOUT_SEC;
     tv.tv_usec = 0;
 
     if (setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof tv) < 0) {
@@ -106,68 +178,111 @@ void handleClientLogic(int clientSocket) {
     }
 
     while(true) {
-        memset(tempBuffer, 0, 1024);
-        int valread = read(clientSocket, tempBuffer, 1024);
+        // Straight into the ring, lines are handled in place
+        struct iovec vectors[2];
+        int vectorCount = lineBuffer.writeVectors(vectors);
+        int valread = readv(clientSocket, vectors, vectorCount);
 
         if (valread <= 0 || new_player != nullptr && new_player->tolerance > 3) {
-            std::cout << "[SERVER] Client " << clientSocket << " disconnected" << std::endl;
-
-            bool memoryRetained = false;
-            int disconnected_user = -1;
-            int connected_oponent_socket = -1;
-            {
-                std::lock_guard<std::mutex> lock(lobbies_mutex);
-                
-                for (auto &lobby : lobbies) {
-                    if (lobby.getPlayerSocket1() == clientSocket || lobby.getPlayerSocket2() == clientSocket) {
-                        lobby.removePlayer(clientSocket);
-                        if(lobby.getStatus() == PAUSE_STATUS) {
-                            memoryRetained = true;
-                            if(lobby.getPlayerSocket1() == -1) {
-                                disconnected_user = 1;
-                                connected_oponent_socket = lobby.getPlayerSocket2();
-                            }
-                            else if (lobby.getPlayerSocket2() == -1) {
-                                disconnected_user = 2;
-                                connected_oponent_socket = lobby.getPlayerSocket1();
-                            }
-                        }
-                        break;
-                    }
-                }
-            }
-
-            if (!memoryRetained) {
-                delete new_player;
-            }
-            else {
-                sendDisconnectInfo(connected_oponent_socket, disconnected_user);
-            }
+            releaseClient(clientSocket, new_player);
             break; 
         }
 
         if (new_player == nullptr) {
-            new_player = new Player(clientSocket);
-            new_player->state = STATE_LOGIN;
+            new_player = acquirePlayer(clientSocket);
         }
 
-        dataBuffer.append(tempBuffer, valread);
-        size_t pos = 0;
-        while ((pos = dataBuffer.find('\n')) != std::string::npos) {
-            std::string message = dataBuffer.substr(0, pos);
-            dataBuffer.erase(0, pos + 1);
-            handleMessage(clientSocket, message.c_str(), *new_player);
+        lineBuffer.commit(valread);
+        std::string_view message;
+        while (lineBuffer.frontLine(message, new_player->binaryProtocol)) {
+            handleMessage(clientSocket, message, *new_player);
+            lineBuffer.dropLine();
+        }
+
+        if (lineBuffer.overflowed()) {
+            std::cout << "[SECURITY] Client " << clientSocket << " exceeded " << MAX_FRAME_SIZE << " bytes per message." << std::endl;
+            releaseClient(clientSocket, new_player);
+            break;
         }
     }
 
-    // Close socket & clean up
+    // Clean up & close socket (the outbox goes first, the number may be reused right after close)
+    unregisterClient(clientSocket);
     close(clientSocket);
+}
+
+void releaseClient(int clientSocket, Player *player) {
+    std::cout << "[SERVER] Client " << clientSocket << " disconnected" << std::endl;
 
-    {
-        std::lock_guard<std::mutex> lock(clients_mutex);
-        auto it = std::find(clientSockets.begin(), clientSockets.end(), clientSocket);
-        if (it != clientSockets.end()) {
-            clientSockets.erase(it);
+    // Out of the matchmaking queue first, it must not pair a closed connection
+    if (player != nullptr) leaveMatchQueue(*player);
+    if (player != nullptr && player->watchLobby >= 0) handleStopWatching(clientSocket, *player);
+    unsubscribeLobbyDirectory(clientSocket);
+
+    bool paused = false;
+    bool released = false;
+    int pausedLobby = -1;
+    int disconnected_user = -1;
+    int connected_oponent_socket = -1;
+    // Only the lobby the client sits in is touched
+    int lobbyId = findLobbyBySocket(clientSocket);
+    Lobby *seated = findLobby(lobbyId);
+    if (seated != nullptr && isLobbyLocal(lobbyId)) {
+        LobbyLock lock(*seated);
+        Lobby &lobby = *seated;
+
+        if (lobby.getPlayerSocket1() == clientSocket || lobby.getPlayerSocket2() == clientSocket) {
+            // The session is registered before the seat pauses, a login under
+            // its token waits for this lock and then finds the paused seat
+            if (player != nullptr && player->seatLobby == lobbyId) {
+                releaseConnection(player);
+                released = true;
+            }
+            lobby.removePlayer(clientSocket);
+            if(lobby.getStatus() == PAUSE_STATUS) {
+                paused = true;
+                pausedLobby = lobbyId;
+                if(lobby.getPlayerSocket1() == -1) {
+                    disconnected_user = 1;
+                    connected_oponent_socket = lobby.getPlayerSocket2();
+                }
+                else if (lobby.getPlayerSocket2() == -1) {
+                    disconnected_user = 2;
+                    connected_oponent_socket = lobby.getPlayerSocket1();
+                }
+            }
         }
     }
+
+    // A seat still held keeps the Player as a paused session (playerPool.h)
+    if (player != nullptr && !released) releaseConnection(player);
+
+    if (paused) {
+        armReconnectGrace(pausedLobby);
+        sendDisconnectInfo(connected_oponent_socket, disconnected_user);
+    }
+}
+
+void registerClient(int clientSocket) {
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    std::cout << "Connection accepted!" << std::endl;
+    clientSockets.push_back(clientSocket);
+    openOutbox(clientSocket);
+
+    // Writes are already coalesced per event (MessageBatch), Nagle would hold back
+    // a lobby directory update pushed right before the reply to the client's request
+    int noDelay = 1;
+    if (setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)) < 0) {
+        perror("setsockopt TCP_NODELAY");
+    }
+}
+
+void unregisterClient(int clientSocket) {
+    std::lock_guard<std::mutex> lock(clients_mutex);
+    auto it = std::find(clientSockets.begin(), clientSockets.end(), clientSocket);
+    if (it != clientSockets.end()) {
+        clientSockets.erase(it);
+    }
+    closeOutbox(clientSocket);
+    setBinaryClient(clientSocket, false);
 }
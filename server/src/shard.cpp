@@ -0,0 +1,127 @@
+#include "../include/shard.h"
+#include "../include/global.h"
+#include "../include/lobbyDirectory.h"
+#include <iostream>
+#include <future>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+struct ShardMailbox {
+    std::mutex mutex;
+    std::vector<std::function<void()>> tasks;
+    int wakeFd;
+};
+
+static int shardCount = 1;
+static std::unique_ptr<ShardMailbox[]> mailboxes;
+static thread_local int currentShard = -1;
+static thread_local int lobbyLocksHeld = 0;
+
+void initShards(int count) {
+    shardCount = count > 1 ? count : 1;
+    mailboxes.reset(new ShardMailbox[shardCount]);
+
+    for (int i = 0; i < shardCount; i++) {
+        mailboxes[i].wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (mailboxes[i].wakeFd < 0) perror("eventfd");
+    }
+}
+
+bool lobbiesSharded() {
+    return shardCount > 1;
+}
+
+int getShardCount() {
+    return shardCount;
+}
+
+int getLobbyOwner(int lobbyId) {
+    return lobbyId % shardCount;
+}
+
+int getCurrentShard() {
+    return currentShard;
+}
+
+void setCurrentShard(int shard) {
+    currentShard = shard;
+}
+
+bool isLobbyLocal(int lobbyId) {
+    return !lobbiesSharded() || getLobbyOwner(lobbyId) == currentShard;
+}
+
+void postToShard(int shard, std::function<void()> task) {
+    ShardMailbox &mailbox = mailboxes[shard];
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mailbox.mutex);
+        wake = mailbox.tasks.empty();
+        mailbox.tasks.push_back(std::move(task));
+    }
+
+    // One wakeup per batch, the reactor drains the whole mailbox
+    if (wake) {
+        uint64_t one = 1;
+        if (write(mailbox.wakeFd, &one, sizeof(one)) < 0) perror("eventfd write");
+    }
+}
+
+int getShardWakeFd(int shard) {
+    return mailboxes[shard].wakeFd;
+}
+
+void runShardMailbox(int shard) {
+    ShardMailbox &mailbox = mailboxes[shard];
+
+    uint64_t count;
+    while (read(mailbox.wakeFd, &count, sizeof(count)) > 0) {}
+
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mailbox.mutex);
+        tasks.swap(mailbox.tasks);
+    }
+    for (auto &task : tasks) task();
+}
+
+void runOnLobbyOwner(int lobbyId, std::function<void()> task) {
+    if (isLobbyLocal(lobbyId)) {
+        task();
+        return;
+    }
+    postToShard(getLobbyOwner(lobbyId), std::move(task));
+}
+
+void runOnLobbyOwnerAndWait(int lobbyId, std::function<void()> task) {
+    if (isLobbyLocal(lobbyId)) {
+        task();
+        return;
+    }
+
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    postToShard(getLobbyOwner(lobbyId), [&task, &done] {
+        task();
+        done.set_value();
+    });
+    finished.wait();
+}
+
+LobbyLock::LobbyLock(Lobby& lobby) : lock(lobby.mutex, std::defer_lock) {
+    if (!lobbiesSharded()) lock.lock();
+    lobbyLocksHeld++;
+}
+
+LobbyLock::~LobbyLock() {
+    if (lock.owns_lock()) lock.unlock();
+    if (--lobbyLocksHeld == 0) flushLobbyDirectory();
+}
+
+bool holdsLobbyLock() {
+    return lobbyLocksHeld > 0;
+}
@@ -0,0 +1,343 @@
+#include "../include/simdMoves.h"
+#include "../include/gameLogic.h"
+#include <iostream>
+#include <utility>
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define INNER_COLUMNS 0x7e7e7e7e7e7e7e7eULL
+#define FULL_MASK 0xffffffffffffffffULL
+
+MoveMaskKernel activeMoveMaskKernel = getMoveMaskScalar;
+FlipMaskKernel activeFlipMaskKernel = getFlipMaskScalar;
+
+static SimdLevel activeLevel = SIMD_SCALAR;
+
+// ---------------------------------------------------------------------------
+// SSE2: one axis per vector, lane 0 walks "left" (<<), lane 1 walks "right" (>>)
+// ---------------------------------------------------------------------------
+
+static const int SSE2_SHIFTS[4] = {1, 8, 7, 9};
+
+__attribute__((target("sse2")))
+static inline __m128i sse2ShiftPair(__m128i v, __m128i count, __m128i laneLeft, __m128i laneRight) {
+      return _mm_or_si128(_mm_and_si128(_mm_sll_epi64(v, count), laneLeft),
+                          _mm_and_si128(_mm_srl_epi64(v, count), laneRight));
+}
+
+// SSE2 has no 64-bit compare, combine the two 32-bit halves of each lane.
+__attribute__((target("sse2")))
+static inline __m128i sse2IsZero64(__m128i v) {
+      __m128i eq = _mm_cmpeq_epi32(v, _mm_setzero_si128());
+      return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+__attribute__((target("sse2")))
+static inline uint64_t sse2OrLanes(__m128i v) {
+      v = _mm_or_si128(v, _mm_unpackhi_epi64(v, v));
+      return (uint64_t)_mm_cvtsi128_si64(v);
+}
+
+__attribute__((target("sse2")))
+static uint64_t getMoveMaskSse2(uint64_t own, uint64_t opp) {
+      const __m128i laneLeft = _mm_set_epi64x(0, -1);
+      const __m128i laneRight = _mm_set_epi64x(-1, 0);
+      const __m128i PP = _mm_set1_epi64x((long long)own);
+      __m128i moves = _mm_setzero_si128();
+
+      for (int i = 0; i < 4; i++) {
+            int shift = SSE2_SHIFTS[i];
+            const __m128i count = _mm_cvtsi32_si128(shift);
+            const __m128i OO = _mm_set1_epi64x((long long)(shift == 8 ? opp : (opp & INNER_COLUMNS)));
+
+            __m128i fill = _mm_and_si128(OO, sse2ShiftPair(PP, count, laneLeft, laneRight));
+            for (int step = 0; step < 5; step++) {
+                  fill = _mm_or_si128(fill, _mm_and_si128(OO, sse2ShiftPair(fill, count, laneLeft, laneRight)));
+            }
+            moves = _mm_or_si128(moves, sse2ShiftPair(fill, count, laneLeft, laneRight));
+      }
+
+      return sse2OrLanes(moves) & ~(own | opp);
+}
+
+__attribute__((target("sse2")))
+static uint64_t getFlipMaskSse2(int square, uint64_t own, uint64_t opp) {
+      uint64_t placed = 1ULL << square;
+      if ((own | opp) & placed) return 0;
+
+      const __m128i laneLeft = _mm_set_epi64x(0, -1);
+      const __m128i laneRight = _mm_set_epi64x(-1, 0);
+      const __m128i PP = _mm_set1_epi64x((long long)own);
+      const __m128i XX = _mm_set1_epi64x((long long)placed);
+      __m128i flips = _mm_setzero_si128();
+
+      for (int i = 0; i < 4; i++) {
+            int shift = SSE2_SHIFTS[i];
+            const __m128i count = _mm_cvtsi32_si128(shift);
+            const __m128i OO = _mm_set1_epi64x((long long)(shift == 8 ? opp : (opp & INNER_COLUMNS)));
+
+            // Run of opponent stones next to the placed stone
+            __m128i run = _mm_and_si128(OO, sse2ShiftPair(XX, count, laneLeft, laneRight));
+            for (int step = 0; step < 5; step++) {
+                  run = _mm_or_si128(run, _mm_and_si128(OO, sse2ShiftPair(run, count, laneLeft, laneRight)));
+            }
+            // Keep the run only where the next square is our own stone
+            __m128i closing = _mm_and_si128(sse2ShiftPair(run, count, laneLeft, laneRight), PP);
+            flips = _mm_or_si128(flips, _mm_andnot_si128(sse2IsZero64(closing), run));
+      }
+
+      return sse2OrLanes(flips);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2: lanes = {1, 8, 7, 9}, one vector walks left, the other walks right
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2")))
+static inline uint64_t avx2OrLanes(__m256i v) {
+      __m128i half = _mm_or_si128(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+      half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+      return (uint64_t)_mm_cvtsi128_si64(half);
+}
+
+__attribute__((target("avx2")))
+static uint64_t getMoveMaskAvx2(uint64_t own, uint64_t opp) {
+      const __m256i shift = _mm256_set_epi64x(9, 7, 8, 1);
+      const __m256i axisMask = _mm256_set_epi64x(INNER_COLUMNS, INNER_COLUMNS, FULL_MASK, INNER_COLUMNS);
+      const __m256i PP = _mm256_set1_epi64x((long long)own);
+      const __m256i OO = _mm256_and_si256(_mm256_set1_epi64x((long long)opp), axisMask);
+
+      __m256i left = _mm256_and_si256(OO, _mm256_sllv_epi64(PP, shift));
+      __m256i right = _mm256_and_si256(OO, _mm256_srlv_epi64(PP, shift));
+      for (int step = 0; step < 5; step++) {
+            left = _mm256_or_si256(left, _mm256_and_si256(OO, _mm256_sllv_epi64(left, shift)));
+            right = _mm256_or_si256(right, _mm256_and_si256(OO, _mm256_srlv_epi64(right, shift)));
+      }
+
+      __m256i moves = _mm256_or_si256(_mm256_sllv_epi64(left, shift), _mm256_srlv_epi64(right, shift));
+      return avx2OrLanes(moves) & ~(own | opp);
+}
+
+__attribute__((target("avx2")))
+static uint64_t getFlipMaskAvx2(int square, uint64_t own, uint64_t opp) {
+      uint64_t placed = 1ULL << square;
+      if ((own | opp) & placed) return 0;
+
+      const __m256i shift = _mm256_set_epi64x(9, 7, 8, 1);
+      const __m256i axisMask = _mm256_set_epi64x(INNER_COLUMNS, INNER_COLUMNS, FULL_MASK, INNER_COLUMNS);
+      const __m256i zero = _mm256_setzero_si256();
+      const __m256i PP = _mm256_set1_epi64x((long long)own);
+      const __m256i OO = _mm256_and_si256(_mm256_set1_epi64x((long long)opp), axisMask);
+      const __m256i XX = _mm256_set1_epi64x((long long)placed);
+
+      __m256i left = _mm256_and_si256(OO, _mm256_sllv_epi64(XX, shift));
+      __m256i right = _mm256_and_si256(OO, _mm256_srlv_epi64(XX, shift));
+      for (int step = 0; step < 5; step++) {
+            left = _mm256_or_si256(left, _mm256_and_si256(OO, _mm256_sllv_epi64(left, shift)));
+            right = _mm256_or_si256(right, _mm256_and_si256(OO, _mm256_srlv_epi64(right, shift)));
+      }
+
+      __m256i openLeft = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_sllv_epi64(left, shift), PP), zero);
+      __m256i openRight = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_srlv_epi64(right, shift), PP), zero);
+
+      __m256i flips = _mm256_or_si256(_mm256_andnot_si256(openLeft, left), _mm256_andnot_si256(openRight, right));
+      return avx2OrLanes(flips);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512: all 8 directions in one register. A shift count of 64 yields 0,
+// so lanes 0-3 only shift left and lanes 4-7 only shift right.
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f")))
+static inline __m512i avx512Shift(__m512i v, __m512i leftCount, __m512i rightCount) {
+      return _mm512_or_si512(_mm512_sllv_epi64(v, leftCount), _mm512_srlv_epi64(v, rightCount));
+}
+
+__attribute__((target("avx512f")))
+static uint64_t getMoveMaskAvx512(uint64_t own, uint64_t opp) {
+      const __m512i leftCount = _mm512_set_epi64(64, 64, 64, 64, 9, 7, 8, 1);
+      const __m512i rightCount = _mm512_set_epi64(9, 7, 8, 1, 64, 64, 64, 64);
+      const __m512i axisMask = _mm512_set_epi64(INNER_COLUMNS, INNER_COLUMNS, FULL_MASK, INNER_COLUMNS,
+                                                INNER_COLUMNS, INNER_COLUMNS, FULL_MASK, INNER_COLUMNS);
+      const __m512i PP = _mm512_set1_epi64((long long)own);
+      const __m512i OO = _mm512_and_si512(_mm512_set1_epi64((long long)opp), axisMask);
+
+      __m512i fill = _mm512_and_si512(OO, avx512Shift(PP, leftCount, rightCount));
+      for (int step = 0; step < 5; step++) {
+            fill = _mm512_or_si512(fill, _mm512_and_si512(OO, avx512Shift(fill, leftCount, rightCount)));
+      }
+
+      uint64_t moves = (uint64_t)_mm512_reduce_or_epi64(avx512Shift(fill, leftCount, rightCount));
+      return moves & ~(own | opp);
+}
+
+__attribute__((target("avx512f")))
+static uint64_t getFlipMaskAvx512(int square, uint64_t own, uint64_t opp) {
+      uint64_t placed = 1ULL << square;
+      if ((own | opp) & placed) return 0;
+
+      const __m512i leftCount = _mm512_set_epi64(64, 64, 64, 64, 9, 7, 8, 1);
+      const __m512i rightCount = _mm512_set_epi64(9, 7, 8, 1, 64, 64, 64, 64);
+      const __m512i axisMask = _mm512_set_epi64(INNER_COLUMNS, INNER_COLUMNS, FULL_MASK, INNER_COLUMNS,
+                                                INNER_COLUMNS, INNER_COLUMNS, FULL_MASK, INNER_COLUMNS);
+      const __m512i PP = _mm512_set1_epi64((long long)own);
+      const __m512i OO = _mm512_and_si512(_mm512_set1_epi64((long long)opp), axisMask);
+      const __m512i XX = _mm512_set1_epi64((long long)placed);
+
+      __m512i run = _mm512_and_si512(OO, avx512Shift(XX, leftCount, rightCount));
+      for (int step = 0; step < 5; step++) {
+            run = _mm512_or_si512(run, _mm512_and_si512(OO, avx512Shift(run, leftCount, rightCount)));
+      }
+
+      __mmask8 closed = _mm512_test_epi64_mask(avx512Shift(run, leftCount, rightCount), PP);
+      return (uint64_t)_mm512_reduce_or_epi64(_mm512_maskz_mov_epi64(closed, run));
+}
+
+// ---------------------------------------------------------------------------
+// Detection, self-check and selection
+// ---------------------------------------------------------------------------
+
+static uint64_t readXcr0() {
+      uint32_t eax, edx;
+      __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+      return ((uint64_t)edx << 32) | eax;
+}
+
+SimdLevel detectSimdLevel() {
+      unsigned int eax, ebx, ecx, edx;
+      if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return SIMD_SCALAR;
+
+      SimdLevel level = SIMD_SCALAR;
+      if (edx & bit_SSE2) level = SIMD_SSE2;
+
+      // AVX state must be enabled by the OS (OSXSAVE + XCR0 bits)
+      bool osxsave = (ecx & bit_OSXSAVE) != 0;
+      if (!osxsave) return level;
+      uint64_t xcr0 = readXcr0();
+      bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+      bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+
+      if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return level;
+      if (ymmEnabled && (ebx & bit_AVX2)) level = SIMD_AVX2;
+      if (zmmEnabled && (ebx & bit_AVX512F)) level = SIMD_AVX512;
+
+      return level;
+}
+
+static bool getKernels(SimdLevel level, MoveMaskKernel &moveKernel, FlipMaskKernel &flipKernel) {
+      switch (level) {
+            case SIMD_SCALAR:
+                  moveKernel = getMoveMaskScalar;
+                  flipKernel = getFlipMaskScalar;
+                  return true;
+            case SIMD_SSE2:
+                  moveKernel = getMoveMaskSse2;
+                  flipKernel = getFlipMaskSse2;
+                  return true;
+            case SIMD_AVX2:
+                  moveKernel = getMoveMaskAvx2;
+                  flipKernel = getFlipMaskAvx2;
+                  return true;
+            case SIMD_AVX512:
+                  moveKernel = getMoveMaskAvx512;
+                  flipKernel = getFlipMaskAvx512;
+                  return true;
+      }
+      return false;
+}
+
+static uint64_t nextRandom(uint64_t &state) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      return state;
+}
+
+bool selfCheckMoveKernels(SimdLevel level) {
+      MoveMaskKernel moveKernel;
+      FlipMaskKernel flipKernel;
+      if (!getKernels(level, moveKernel, flipKernel)) return false;
+
+      uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+      // Random playouts from the standard opening, every position checked
+      for (int game = 0; game < 64; game++) {
+            uint64_t own = (1ULL << 27) | (1ULL << 36);
+            uint64_t opp = (1ULL << 28) | (1ULL << 35);
+            int passes = 0;
+
+            while (passes < 2) {
+                  uint64_t moves = getMoveMaskScalar(own, opp);
+                  if (moveKernel(own, opp) != moves) return false;
+
+                  // Illegal squares must report no flips as well
+                  int probe = (int)(nextRandom(seed) & 63);
+                  if (flipKernel(probe, own, opp) != getFlipMaskScalar(probe, own, opp)) return false;
+
+                  if (moves == 0) {
+                        passes++;
+                        std::swap(own, opp);
+                        continue;
+                  }
+                  passes = 0;
+
+                  int chosen = (int)(nextRandom(seed) % (uint64_t)__builtin_popcountll(moves));
+                  int square = -1;
+                  for (uint64_t m = moves; m; m &= m - 1) {
+                        int sq = __builtin_ctzll(m);
+                        uint64_t flips = getFlipMaskScalar(sq, own, opp);
+                        if (flipKernel(sq, own, opp) != flips) return false;
+                        if (chosen-- == 0) square = sq;
+                  }
+
+                  uint64_t flips = getFlipMaskScalar(square, own, opp);
+                  own |= flips | (1ULL << square);
+                  opp &= ~flips;
+                  std::swap(own, opp);
+            }
+      }
+
+      // Arbitrary (also unreachable) disc patterns to hit the board edges
+      for (int i = 0; i < 4096; i++) {
+            uint64_t a = nextRandom(seed);
+            uint64_t b = nextRandom(seed) & ~a;
+            if (moveKernel(a, b) != getMoveMaskScalar(a, b)) return false;
+            int probe = (int)(nextRandom(seed) & 63);
+            if (flipKernel(probe, a, b) != getFlipMaskScalar(probe, a, b)) return false;
+      }
+
+      return true;
+}
+
+SimdLevel initMoveKernels(SimdLevel maxLevel) {
+      SimdLevel detected = detectSimdLevel();
+      int level = (detected < maxLevel) ? detected : maxLevel;
+
+      for (; level > SIMD_SCALAR; level--) {
+            if (selfCheckMoveKernels((SimdLevel)level)) break;
+            std::cerr << "[ENGINE] " << getSimdLevelName((SimdLevel)level)
+                      << " move generator failed the self-check, falling back." << std::endl;
+      }
+
+      getKernels((SimdLevel)level, activeMoveMaskKernel, activeFlipMaskKernel);
+      activeLevel = (SimdLevel)level;
+
+      std::cout << "[ENGINE] Move generator: " << getSimdLevelName(activeLevel)
+                << " (CPU supports " << getSimdLevelName(detected) << ")" << std::endl;
+      return activeLevel;
+}
+
+SimdLevel getMoveKernelLevel() {
+      return activeLevel;
+}
+
+const char* getSimdLevelName(SimdLevel level) {
+      switch (level) {
+            case SIMD_SCALAR: return "scalar";
+            case SIMD_SSE2: return "SSE2";
+            case SIMD_AVX2: return "AVX2";
+            case SIMD_AVX512: return "AVX-512";
+      }
+      return "unknown";
+}
@@ -0,0 +1,132 @@
+#include "../include/timerWheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define MAX_DELAY_TICKS ((1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1)
+
+Timer::Timer() : prev(nullptr), next(nullptr), expires(0), callback(nullptr), context(nullptr) {}
+
+Timer::~Timer() {
+    cancel();
+}
+
+void Timer::setCallback(TimerCallback function, void *argument) {
+    callback = function;
+    context = argument;
+}
+
+void Timer::cancel() {
+    if (next == nullptr) return;
+    prev->next = next;
+    next->prev = prev;
+    prev = nullptr;
+    next = nullptr;
+}
+
+// Moves every timer of `from` behind `to` (both circular lists with a head)
+void TimerWheel::splice(Timer& from, Timer& to) {
+    if (from.next == &from) return;
+
+    Timer *first = from.next;
+    Timer *last = from.prev;
+    first->prev = to.prev;
+    to.prev->next = first;
+    last->next = &to;
+    to.prev = last;
+
+    from.next = &from;
+    from.prev = &from;
+}
+
+TimerWheel::TimerWheel() : currentTick(0), start(std::chrono::steady_clock::now()) {
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            Timer &head = slots[level][slot];
+            head.prev = &head;
+            head.next = &head;
+        }
+    }
+}
+
+void TimerWheel::schedule(Timer& timer, long delayMs) {
+    timer.cancel();
+
+    // Rounded up, a timer never fires before its deadline
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs < 0 ? 0 : delayMs);
+    long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - start).count();
+    uint64_t tick = (uint64_t)((elapsedMs + TIMER_TICK_MS - 1) / TIMER_TICK_MS);
+
+    if (tick < currentTick) tick = currentTick;
+    if (tick - currentTick > MAX_DELAY_TICKS) tick = currentTick + MAX_DELAY_TICKS;
+    timer.expires = tick;
+    insert(timer);
+}
+
+// A timer goes to the finest level whose span still covers its distance
+void TimerWheel::insert(Timer& timer) {
+    uint64_t delta = timer.expires - currentTick;
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ULL << (TIMER_WHEEL_BITS * (level + 1)))) level++;
+
+    int slot = (int)((timer.expires >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK);
+    Timer &head = slots[level][slot];
+    timer.prev = head.prev;
+    timer.next = &head;
+    head.prev->next = &timer;
+    head.prev = &timer;
+}
+
+// The timers of a coarser slot are now close enough for a finer level
+void TimerWheel::cascade(int level, int slot) {
+    Timer pending;
+    pending.prev = &pending;
+    pending.next = &pending;
+    splice(slots[level][slot], pending);
+
+    while (pending.next != &pending) {
+        Timer *timer = pending.next;
+        timer->cancel();
+        insert(*timer);
+    }
+    pending.prev = nullptr;
+    pending.next = nullptr;
+}
+
+void TimerWheel::runSlot(int slot) {
+    Timer due;
+    due.prev = &due;
+    due.next = &due;
+    splice(slots[0][slot], due);
+
+    // Callbacks may cancel, reschedule or destroy any timer, including the due ones
+    while (due.next != &due) {
+        Timer *timer = due.next;
+        timer->cancel();
+
+        TimerCallback callback = timer->callback;
+        void *context = timer->context;
+        if (callback != nullptr) callback(context);
+    }
+    due.prev = nullptr;
+    due.next = nullptr;
+}
+
+void TimerWheel::advance(std::chrono::steady_clock::time_point now) {
+    long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count();
+    if (elapsedMs < 0) return;
+    uint64_t targetTick = (uint64_t)elapsedMs / TIMER_TICK_MS;
+
+    while (currentTick <= targetTick) {
+        uint64_t tick = currentTick;
+
+        // At the start of each lap the next coarser slot is spread over the finer level
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if ((tick >> (TIMER_WHEEL_BITS * (level - 1))) & SLOT_MASK) break;
+            cascade(level, (int)((tick >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK));
+        }
+
+        // Timers scheduled by the callbacks land at the next tick at the earliest
+        currentTick++;
+        runSlot((int)(tick & SLOT_MASK));
+    }
+}
@@ -0,0 +1,627 @@
+#include "../include/uringReactor.h"
+#include "../include/server.h"
+#include "../include/handler.h"
+#include "../include/sender.h"
+#include "../include/global.h"
+#include "../include/lineBuffer.h"
+#include "../include/outbox.h"
+#include "../include/timerWheel.h"
+#include "../include/playerPool.h"
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// user_data of the requests that do not belong to a connection
+#define URING_TAG_ACCEPT 1
+#define URING_TAG_TIMEOUT 2
+#define URING_TAG_WAKEUP 3
+
+// Connection requests carry the Connection pointer, the low bits tell the operation
+#define URING_OP_RECV 0
+#define URING_OP_SEND 1
+#define URING_OP_MASK 7ULL
+
+struct UringConnection {
+    int socket;
+    Player *player;
+    LineBuffer lines;        // Received bytes, split into lines in place
+    std::string outgoing;    // Queued messages, not submitted yet
+    std::string inFlight;    // Bytes of the submitted send, untouched until it completes
+    size_t inFlightOffset;
+    bool recvArmed;          // The multishot recv is still producing completions
+    bool sending;
+    bool queued;             // Already listed for the next send batch
+    bool closing;            // Shut down, freed once no request references it
+    bool stalled;            // Fell OUTBOX_HIGH_WATER behind, closed by the EOF of its recv
+    std::chrono::steady_clock::time_point lastActivity;
+    Timer idleTimer;         // Due CLIENT_TIMEOUT_SEC after the last activity, checked lazily
+};
+
+/**
+ * @brief Submission/completion queues of one io_uring, mapped from the kernel.
+ */
+class UringQueue {
+public:
+    bool setup(unsigned entries);
+    void destroy();
+
+    // Free submission entry (zeroed), submits pending entries when the queue is full
+    io_uring_sqe* getSqe();
+
+    // Submits everything prepared so far and waits for `waitFor` completions
+    int submitAndWait(unsigned waitFor);
+
+    // Copies the available completions into `out` and frees their slots
+    void reapCompletions(std::vector<io_uring_cqe>& out);
+
+    bool registerBufferRing(unsigned count, unsigned size, int group);
+    char* bufferData(int bufferId) { return bufferMemory + (size_t)bufferId * bufferSize; }
+    void recycleBuffer(int bufferId);
+    void publishBuffers();
+
+    int fd = -1;
+
+private:
+    unsigned sqEntries = 0;
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqeTail = 0;        // Local tail, published by submitAndWait
+    unsigned sqeSubmitted = 0;
+    io_uring_sqe *sqes = nullptr;
+
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+
+    void *ringMemory = nullptr;
+    size_t ringSize = 0;
+    size_t sqesSize = 0;
+
+    // Provided buffer ring: entries shared with the kernel, the tail overlays
+    // the reserved field of entry 0 (layout of io_uring_buf_ring)
+    io_uring_buf *bufferRing = nullptr;
+    unsigned short *bufferRingTail = nullptr;
+    size_t bufferRingSize = 0;
+    char *bufferMemory = nullptr;
+    unsigned bufferSize = 0;
+    unsigned bufferMask = 0;
+    unsigned short bufferTail = 0;
+};
+
+bool UringQueue::setup(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;   // Multishot requests post many completions each
+
+    fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0 && errno == EINVAL) {
+        // Older kernels do not know the scheduling hints
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+        fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    }
+    if (fd < 0) return false;
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ringSize = sqSize > cqSize ? sqSize : cqSize;
+    ringMemory = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ringMemory == MAP_FAILED) {
+        ringMemory = nullptr;
+        destroy();
+        return false;
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = (io_uring_sqe*)mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        sqes = nullptr;
+        destroy();
+        return false;
+    }
+
+    char *base = (char*)ringMemory;
+    sqEntries = params.sq_entries;
+    sqHead = (unsigned*)(base + params.sq_off.head);
+    sqTail = (unsigned*)(base + params.sq_off.tail);
+    sqMask = *(unsigned*)(base + params.sq_off.ring_mask);
+    sqeTail = *sqTail;
+    sqeSubmitted = sqeTail;
+
+    // Slot i of the submission array always points at entry i
+    unsigned *sqArray = (unsigned*)(base + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries; i++) sqArray[i] = i;
+
+    cqHead = (unsigned*)(base + params.cq_off.head);
+    cqTail = (unsigned*)(base + params.cq_off.tail);
+    cqMask = *(unsigned*)(base + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(base + params.cq_off.cqes);
+    return true;
+}
+
+void UringQueue::destroy() {
+    if (bufferRing != nullptr) munmap(bufferRing, bufferRingSize);
+    delete[] bufferMemory;
+    if (sqes != nullptr) munmap(sqes, sqesSize);
+    if (ringMemory != nullptr) munmap(ringMemory, ringSize);
+    if (fd >= 0) close(fd);
+
+    bufferRing = nullptr;
+    bufferMemory = nullptr;
+    sqes = nullptr;
+    ringMemory = nullptr;
+    fd = -1;
+}
+
+io_uring_sqe* UringQueue::getSqe() {
+    while (sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        if (submitAndWait(0) < 0) return nullptr;
+    }
+
+    io_uring_sqe *sqe = &sqes[sqeTail & sqMask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqeTail++;
+    return sqe;
+}
+
+int UringQueue::submitAndWait(unsigned waitFor) {
+    unsigned toSubmit = sqeTail - sqeSubmitted;
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+
+    while (true) {
+        int result = (int)syscall(__NR_io_uring_enter, fd, toSubmit, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (result >= 0) {
+            sqeSubmitted += (unsigned)result;
+            return result;
+        }
+        if (errno == EINTR) continue;
+        // Completion queue backed up, the caller reaps and submits again later
+        if (errno == EBUSY || errno == EAGAIN) return 0;
+        return -1;
+    }
+}
+
+void UringQueue::reapCompletions(std::vector<io_uring_cqe>& out) {
+    unsigned head = *cqHead;
+    unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        out.push_back(cqes[head & cqMask]);
+        head++;
+    }
+    __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+}
+
+bool UringQueue::registerBufferRing(unsigned count, unsigned size, int group) {
+    bufferRingSize = count * sizeof(io_uring_buf);
+    void *memory = mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return false;
+    bufferRing = (io_uring_buf*)memory;
+    bufferRingTail = &bufferRing[0].resv;
+
+    struct io_uring_buf_reg registration;
+    memset(&registration, 0, sizeof(registration));
+    registration.ring_addr = (unsigned long)bufferRing;
+    registration.ring_entries = count;
+    registration.bgid = (unsigned short)group;
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        munmap(bufferRing, bufferRingSize);
+        bufferRing = nullptr;
+        return false;
+    }
+
+    bufferSize = size;
+    bufferMask = count - 1;
+    bufferMemory = new char[(size_t)count * size];
+    bufferTail = 0;
+    for (unsigned id = 0; id < count; id++) recycleBuffer((int)id);
+    publishBuffers();
+    return true;
+}
+
+void UringQueue::recycleBuffer(int bufferId) {
+    io_uring_buf *buffer = &bufferRing[bufferTail & bufferMask];
+    buffer->addr = (unsigned long)bufferData(bufferId);
+    buffer->len = bufferSize;
+    buffer->bid = (unsigned short)bufferId;
+    bufferTail++;
+}
+
+void UringQueue::publishBuffers() {
+    __atomic_store_n(bufferRingTail, bufferTail, __ATOMIC_RELEASE);
+}
+
+// Reactor state, only touched by the reactor thread (except the foreign queue)
+static UringQueue ring;
+static std::unordered_map<int, std::unique_ptr<UringConnection>> connections;
+static std::vector<int> pendingSends;    // Sockets with queued messages
+static std::thread::id reactorThread;
+static int listenSocket = -1;
+static bool acceptArmed = false;
+static TimerWheel wheel;                 // Idle deadlines of the connections
+
+// The timeout request ticks the wheel
+static struct __kernel_timespec tickInterval = {0, TIMER_TICK_MS * 1000000L};
+
+// Messages from other threads (bot pool), handed over through an eventfd
+static std::mutex foreignMutex;
+static std::vector<std::pair<int, std::string>> foreignMessages;
+static int wakeupFd = -1;
+static uint64_t wakeupValue;
+
+static bool kernelAtLeast(int major, int minor) {
+    struct utsname name;
+    if (uname(&name) != 0) return false;
+
+    int kernelMajor = 0, kernelMinor = 0;
+    if (sscanf(name.release, "%d.%d", &kernelMajor, &kernelMinor) != 2) return false;
+    return kernelMajor > major || (kernelMajor == major && kernelMinor >= minor);
+}
+
+static void armAccept() {
+    io_uring_sqe *sqe = ring.getSqe();
+    if (sqe == nullptr) return;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenSocket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = URING_TAG_ACCEPT;
+    acceptArmed = true;
+}
+
+static void armTimeout() {
+    io_uring_sqe *sqe = ring.getSqe();
+    if (sqe == nullptr) return;
+
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->addr = (unsigned long)&tickInterval;
+    sqe->len = 1;
+    sqe->user_data = URING_TAG_TIMEOUT;
+}
+
+static void armWakeup() {
+    io_uring_sqe *sqe = ring.getSqe();
+    if (sqe == nullptr) return;
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeupFd;
+    sqe->addr = (unsigned long)&wakeupValue;
+    sqe->len = sizeof(wakeupValue);
+    sqe->user_data = URING_TAG_WAKEUP;
+}
+
+static void armRecv(UringConnection *connection) {
+    io_uring_sqe *sqe = ring.getSqe();
+    if (sqe == nullptr) return;
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = connection->socket;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUFFER_GROUP;
+    sqe->user_data = (unsigned long)connection | URING_OP_RECV;
+    connection->recvArmed = true;
+}
+
+static void submitSend(UringConnection *connection) {
+    io_uring_sqe *sqe = ring.getSqe();
+    if (sqe == nullptr) return;
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = connection->socket;
+    sqe->addr = (unsigned long)(connection->inFlight.data() + connection->inFlightOffset);
+    sqe->len = (unsigned)(connection->inFlight.size() - connection->inFlightOffset);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = (unsigned long)connection | URING_OP_SEND;
+    connection->sending = true;
+}
+
+// Frees a closed connection once the kernel holds no request for it
+static void freeIfUnused(UringConnection *connection) {
+    if (!connection->closing || connection->recvArmed || connection->sending) return;
+
+    int clientSocket = connection->socket;
+    close(clientSocket);
+    connections.erase(clientSocket);
+}
+
+static void closeConnection(UringConnection *connection) {
+    if (connection->closing) return;
+    connection->closing = true;
+
+    releaseClient(connection->socket, connection->player);
+    connection->player = nullptr;
+    unregisterClient(connection->socket);
+
+    // Ends the multishot recv (EOF) and any pending send, the caller frees the
+    // connection with freeIfUnused once those completions are in
+    shutdown(connection->socket, SHUT_RDWR);
+}
+
+static void queueMessage(int clientSocket, const std::string& message) {
+    auto it = connections.find(clientSocket);
+    if (it == connections.end() || it->second->closing || it->second->stalled) return;
+
+    UringConnection *connection = it->second.get();
+    connection->outgoing += message;
+
+    // Same limit as the outboxes of the other modes. Not closed right here, the
+    // sender may be a handler still using the Player: the recv sees the EOF.
+    if (connection->outgoing.size() + connection->inFlight.size() - connection->inFlightOffset > OUTBOX_HIGH_WATER) {
+        std::cout << "[URING] Client " << clientSocket << " fell too far behind, disconnecting." << std::endl;
+        connection->stalled = true;
+        connection->outgoing.clear();
+        shutdown(clientSocket, SHUT_RDWR);
+        return;
+    }
+    if (!connection->queued) {
+        connection->queued = true;
+        pendingSends.push_back(clientSocket);
+    }
+}
+
+// Transmit function installed while the reactor runs
+static void transmitMessage(int clientSocket, const std::string& message) {
+    if (std::this_thread::get_id() == reactorThread) {
+        queueMessage(clientSocket, message);
+        return;
+    }
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(foreignMutex);
+        wake = foreignMessages.empty();
+        foreignMessages.emplace_back(clientSocket, message);
+    }
+    if (wake) {
+        uint64_t one = 1;
+        if (write(wakeupFd, &one, sizeof(one)) < 0) perror("eventfd write");
+    }
+}
+
+static void takeForeignMessages() {
+    std::vector<std::pair<int, std::string>> messages;
+    {
+        std::lock_guard<std::mutex> lock(foreignMutex);
+        messages.swap(foreignMessages);
+    }
+    for (auto &message : messages) queueMessage(message.first, message.second);
+}
+
+// One send per client and batch, later messages wait for the previous send
+static void flushSends() {
+    for (int clientSocket : pendingSends) {
+        auto it = connections.find(clientSocket);
+        if (it == connections.end()) continue;
+
+        UringConnection *connection = it->second.get();
+        connection->queued = false;
+        if (connection->closing || connection->sending || connection->outgoing.empty()) continue;
+
+        connection->inFlight.swap(connection->outgoing);
+        connection->outgoing.clear();
+        connection->inFlightOffset = 0;
+        submitSend(connection);
+    }
+    pendingSends.clear();
+}
+
+// Activity only moves lastActivity, the timer re-arms itself for the rest when it fires early
+static void onIdleTimer(void *context) {
+    UringConnection *connection = (UringConnection*)context;
+    if (connection->closing) return;
+
+    auto idleFor = std::chrono::steady_clock::now() - connection->lastActivity;
+    auto remaining = std::chrono::seconds(CLIENT_TIMEOUT_SEC) - idleFor;
+    if (remaining > std::chrono::milliseconds(0)) {
+        wheel.schedule(connection->idleTimer, (long)std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count());
+        return;
+    }
+
+    std::cout << "[URING] Client " << connection->socket << " timed out" << std::endl;
+    closeConnection(connection);
+    freeIfUnused(connection);
+}
+
+static void onAccept(const io_uring_cqe& cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) acceptArmed = false;
+
+    if (cqe.res < 0) {
+        if (cqe.res == -EMFILE || cqe.res == -ENFILE) {
+            std::cout << "[URING] Out of file descriptors, " << connections.size() << " clients connected." << std::endl;
+        } else if (cqe.res != -EINTR && cqe.res != -ECONNABORTED) {
+            std::cout << "[URING] accept failed: " << strerror(-cqe.res) << std::endl;
+        }
+        // Not re-armed here, the loop retries every second (no busy loop without descriptors)
+        return;
+    }
+
+    std::unique_ptr<UringConnection> connection(new UringConnection());
+    connection->socket = cqe.res;
+    connection->player = nullptr;
+    connection->inFlightOffset = 0;
+    connection->recvArmed = false;
+    connection->sending = false;
+    connection->queued = false;
+    connection->closing = false;
+    connection->stalled = false;
+    connection->lastActivity = std::chrono::steady_clock::now();
+
+    registerClient(cqe.res);
+    armRecv(connection.get());
+    connection->idleTimer.setCallback(onIdleTimer, connection.get());
+    wheel.schedule(connection->idleTimer, CLIENT_TIMEOUT_SEC * 1000L);
+    connections[cqe.res] = std::move(connection);
+
+    if (!acceptArmed) armAccept();
+}
+
+static void onRecv(UringConnection *connection, const io_uring_cqe& cqe) {
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+    if (!more) connection->recvArmed = false;
+
+    if (cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+        int bufferId = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+
+        if (!connection->closing) {
+            if (connection->player == nullptr) {
+                connection->player = acquirePlayer(connection->socket);
+            }
+            connection->lastActivity = std::chrono::steady_clock::now();
+
+            // The provided buffer may hold more than the ring takes, handle lines in between
+            const char *data = ring.bufferData(bufferId);
+            size_t length = cqe.res;
+            while (length > 0 && !connection->closing) {
+                size_t taken = connection->lines.append(data, length);
+                data += taken;
+                length -= taken;
+
+                std::string_view message;
+                while (!connection->closing && connection->lines.frontLine(message, connection->player->binaryProtocol)) {
+                    handleMessage(connection->socket, message, *connection->player);
+                    connection->lines.dropLine();
+                }
+
+                if (connection->lines.overflowed()) {
+                    std::cout << "[SECURITY] Client " << connection->socket << " exceeded " << MAX_FRAME_SIZE << " bytes per message." << std::endl;
+                    closeConnection(connection);
+                } else if (connection->player->tolerance > 3) {
+                    // Too many malformed messages
+                    closeConnection(connection);
+                }
+            }
+        }
+        ring.recycleBuffer(bufferId);
+        ring.publishBuffers();
+    }
+
+    if (!more) {
+        // Out of provided buffers: the recv stopped, start it again
+        if (cqe.res == -ENOBUFS && !connection->closing) armRecv(connection);
+        else closeConnection(connection);
+    }
+    freeIfUnused(connection);
+}
+
+static void onSend(UringConnection *connection, const io_uring_cqe& cqe) {
+    connection->sending = false;
+
+    if (cqe.res < 0) {
+        closeConnection(connection);
+    } else if (!connection->closing) {
+        connection->inFlightOffset += (size_t)cqe.res;
+        if (connection->inFlightOffset < connection->inFlight.size()) {
+            submitSend(connection);
+        } else {
+            connection->inFlight.clear();
+            connection->inFlightOffset = 0;
+            if (!connection->outgoing.empty() && !connection->queued) {
+                connection->queued = true;
+                pendingSends.push_back(connection->socket);
+            }
+        }
+    }
+    freeIfUnused(connection);
+}
+
+bool runUringServer(int serverSocket) {
+    // Multishot recv needs 6.0, multishot accept and buffer rings 5.19
+    if (!kernelAtLeast(6, 0)) {
+        std::cout << "[URING] Kernel too old for multishot recv." << std::endl;
+        return false;
+    }
+    if (!ring.setup(URING_QUEUE_DEPTH)) {
+        std::cout << "[URING] io_uring_setup failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (!ring.registerBufferRing(URING_BUFFER_COUNT, URING_BUFFER_SIZE, URING_BUFFER_GROUP)) {
+        std::cout << "[URING] Provided buffer rings not supported: " << strerror(errno) << std::endl;
+        ring.destroy();
+        return false;
+    }
+    wakeupFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeupFd < 0) {
+        ring.destroy();
+        return false;
+    }
+
+    listenSocket = serverSocket;
+    reactorThread = std::this_thread::get_id();
+    setTransmitFunction(transmitMessage);
+
+    armAccept();
+    armTimeout();
+    armWakeup();
+
+    std::cout << "[URING] Serving clients with io_uring." << std::endl;
+
+    std::vector<io_uring_cqe> completions;
+    completions.reserve(URING_QUEUE_DEPTH);
+    auto lastAcceptRetry = std::chrono::steady_clock::now();
+
+    while (true) {
+        if (ring.submitAndWait(1) < 0) {
+            perror("io_uring_enter");
+            break;
+        }
+
+        completions.clear();
+        ring.reapCompletions(completions);
+
+        for (const io_uring_cqe &cqe : completions) {
+            if (cqe.user_data == URING_TAG_ACCEPT) {
+                onAccept(cqe);
+            } else if (cqe.user_data == URING_TAG_TIMEOUT) {
+                armTimeout();
+            } else if (cqe.user_data == URING_TAG_WAKEUP) {
+                armWakeup();
+            } else {
+                UringConnection *connection = (UringConnection*)(cqe.user_data & ~URING_OP_MASK);
+                if ((cqe.user_data & URING_OP_MASK) == URING_OP_SEND) onSend(connection, cqe);
+                else onRecv(connection, cqe);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        wheel.advance(now);
+        if (now - lastAcceptRetry >= std::chrono::seconds(1)) {
+            if (!acceptArmed) armAccept();
+            lastAcceptRetry = now;
+        }
+
+        takeForeignMessages();
+        flushSends();
+    }
+
+    setTransmitFunction(nullptr);
+    ring.destroy();
+    close(wakeupFd);
+    return true;
+}
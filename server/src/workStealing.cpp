@@ -0,0 +1,110 @@
+#include "../include/workStealing.h"
+
+// Which pool (and which deque in it) the current thread belongs to
+static thread_local const WorkStealingPool *currentPool = nullptr;
+static thread_local int currentIndex = -1;
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+    : pending(0), idle(0), nextWorker(0), stopping(false) {
+    if (threadCount < 1) threadCount = 1;
+
+    for (int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(new Worker());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    sleep_cv.notify_all();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    int index;
+    if (currentPool == this) {
+        index = currentIndex;
+    } else {
+        index = (int)(nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size());
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        pending++;
+    }
+    sleep_cv.notify_one();
+}
+
+int WorkStealingPool::getThreadCount() const {
+    return (int)workers.size();
+}
+
+int WorkStealingPool::getIdleCount() const {
+    return idle.load(std::memory_order_relaxed);
+}
+
+int WorkStealingPool::currentWorkerIndex() {
+    return currentIndex;
+}
+
+bool WorkStealingPool::takeTask(int index, std::function<void()>& task) {
+    // Own deque first, newest task
+    {
+        Worker &own = *workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another worker
+    size_t count = workers.size();
+    for (size_t offset = 1; offset < count; ++offset) {
+        Worker &victim = *workers[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            idle++;
+            sleep_cv.wait(lock, [this] { return pending > 0 || stopping; });
+            idle--;
+            if (stopping && pending == 0) return;
+            pending--;
+        }
+
+        // A task is reserved for us (pending), it may sit in any deque
+        std::function<void()> task;
+        while (!takeTask(index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+    }
+}
@@ -0,0 +1,192 @@
+#include "../include/openingBook.h"
+#include "../include/simdMoves.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Builds or extends the opening book from recorded games.
+ *
+ * Reads game records (server --record-games, one game per line: start
+ * state and moves), replays them with the server rules and adds the first
+ * plies of every finished game to the book. An existing book is merged,
+ * the new file is written next to it and renamed over it, so a running
+ * server keeps its mapping of the old file until it restarts.
+ *
+ * Usage: bookBuilder --book PATH [--max-plies N] GAMES...
+ */
+
+#define DEFAULT_MAX_PLIES 20
+
+static bool recordLess(const BookRecord &a, const BookRecord &b) {
+      if (a.own != b.own) return a.own < b.own;
+      if (a.opp != b.opp) return a.opp < b.opp;
+      return a.square < b.square;
+}
+
+static bool sameMove(const BookRecord &a, const BookRecord &b) {
+      return a.own == b.own && a.opp == b.opp && a.square == b.square;
+}
+
+struct PlayedMove {
+      uint64_t own;        // Canonical position, mover first
+      uint64_t opp;
+      int square;          // Canonical square
+      int player;
+};
+
+/**
+ * Replays one game record line. Returns false for malformed lines, illegal
+ * moves and games that did not reach the end (abandoned games say nothing
+ * about the moves played).
+ */
+static bool replayGame(const std::string &line, int maxPlies, std::vector<BookRecord> &out) {
+      std::istringstream in(line);
+      std::string state;
+      if (!(in >> state) || state.size() != 64) return false;
+
+      Board board;
+      loadBoard(board, state);
+      getAvaiableMoves(board, 1);
+      int player = 1;
+
+      std::vector<PlayedMove> played;
+      std::string token;
+      while (in >> token) {
+            if (player == 0 || token.size() != 2) return false;
+            int x = token[0] - 'a';
+            int y = token[1] - '1';
+            if (x < 0 || x >= 8 || y < 0 || y >= 8) return false;
+            int square = y * 8 + x;
+
+            if ((int)played.size() < maxPlies) {
+                  PlayedMove move;
+                  move.own = board.discs[player - 1];
+                  move.opp = board.discs[2 - player];
+                  int symmetry = canonicalizePosition(move.own, move.opp);
+                  move.square = __builtin_ctzll(transformBitboard(1ULL << square, symmetry));
+                  move.player = player;
+                  played.push_back(move);
+            } else {
+                  played.push_back(PlayedMove{0, 0, -1, player});
+            }
+
+            if (!processMove(x, y, board, player, true)) return false;
+            player = resolveNextPlayer(board, player);
+      }
+      if (player != 0) return false;
+
+      int margin1 = board.scores[0] - board.scores[1];
+      for (const PlayedMove &move : played) {
+            if (move.square < 0) break;
+            int margin = move.player == 1 ? margin1 : -margin1;
+
+            BookRecord record;
+            record.own = move.own;
+            record.opp = move.opp;
+            record.square = (uint32_t)move.square;
+            record.games = 1;
+            record.points = margin > 0 ? 2 : (margin == 0 ? 1 : 0);
+            record.margin = margin;
+            out.push_back(record);
+      }
+      return true;
+}
+
+static bool writeBook(const std::string &path, const std::vector<BookRecord> &records) {
+      std::string temporary = path + ".tmp";
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+      if (!out) return false;
+
+      BookHeader header;
+      memcpy(header.magic, BOOK_MAGIC, sizeof(header.magic));
+      header.count = records.size();
+      out.write((const char *)&header, sizeof(header));
+      if (!records.empty()) out.write((const char *)records.data(), records.size() * sizeof(BookRecord));
+      out.close();
+      if (!out) return false;
+
+      return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+int main(int argc, char *argv[]) {
+      std::string bookPath;
+      int maxPlies = DEFAULT_MAX_PLIES;
+      std::vector<std::string> gameFiles;
+
+      for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--book" && i + 1 < argc) {
+                  bookPath = argv[++i];
+            } else if (arg == "--max-plies" && i + 1 < argc) {
+                  maxPlies = std::atoi(argv[++i]);
+            } else if (arg.rfind("--", 0) != 0) {
+                  gameFiles.push_back(arg);
+            } else {
+                  bookPath.clear();
+                  break;
+            }
+      }
+      if (bookPath.empty() || gameFiles.empty() || maxPlies < 1) {
+            std::cout << "[WARNING] Usage: " << argv[0] << " --book PATH [--max-plies N] GAMES..." << std::endl;
+            return 1;
+      }
+
+      initMoveKernels(SIMD_AVX512);
+
+      std::vector<BookRecord> records;
+      {
+            OpeningBook book;
+            if (book.open(bookPath)) {
+                  records.assign(book.records(), book.records() + book.size());
+                  std::cout << "[BOOK] Extending " << bookPath << " (" << book.size() << " moves)" << std::endl;
+            } else {
+                  std::cout << "[BOOK] Creating " << bookPath << std::endl;
+            }
+      }
+      size_t oldCount = records.size();
+
+      int games = 0, skipped = 0;
+      for (const std::string &file : gameFiles) {
+            std::ifstream in(file);
+            if (!in) {
+                  std::cerr << "[ERROR] Cannot read " << file << std::endl;
+                  return 1;
+            }
+            std::string line;
+            while (std::getline(in, line)) {
+                  if (line.empty()) continue;
+                  if (replayGame(line, maxPlies, records)) games++;
+                  else skipped++;
+            }
+      }
+
+      // Sort, then fold equal (position, move) pairs into one record
+      std::sort(records.begin(), records.end(), recordLess);
+      std::vector<BookRecord> merged;
+      merged.reserve(records.size());
+      for (const BookRecord &record : records) {
+            if (!merged.empty() && sameMove(merged.back(), record)) {
+                  merged.back().games += record.games;
+                  merged.back().points += record.points;
+                  merged.back().margin += record.margin;
+            } else {
+                  merged.push_back(record);
+            }
+      }
+
+      if (!writeBook(bookPath, merged)) {
+            std::cerr << "[ERROR] Cannot write " << bookPath << std::endl;
+            return 1;
+      }
+
+      std::cout << "[BOOK] " << games << " game(s) added, " << skipped << " skipped (unfinished or invalid), "
+                << merged.size() << " moves (" << (long)merged.size() - (long)oldCount << " new)" << std::endl;
+      return 0;
+}
@@ -0,0 +1,117 @@
+#include "../include/endgame.h"
+#include "../include/simdMoves.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+
+/**
+ * Endgame benchmark: solves a fixed set of positions exactly and reports
+ * the time, nodes and nodes/second per position.
+ *
+ * The set was produced by seeded random playouts from the standard opening
+ * to 14-20 empties; every expected score was confirmed by a full-depth
+ * plain alpha-beta search (searchBestMove to the end of the game).
+ *
+ * Usage: endgameBench [--max-empties N] [--kernel scalar|sse2|avx2|avx512]
+ * Exit code 1 when a solved score differs from the expected one.
+ */
+
+struct EndgamePosition {
+      const char *state;   // Same format as CUSTOM_START_STATE
+      int player;          // Side to move
+      int score;           // Exact final disc difference for the side to move
+};
+
+static const EndgamePosition POSITIONS[] = {
+      {"2011112122122222122222220022122112212201101020001122221010202020", 1, 4},
+      {"1112202020222111122111210222222211111221002202102222220102020200", 1, 18},
+      {"1022222001221200021121200211222011221110121211112222222200101110", 1, 40},
+      {"0222000000010222202221201222121100222121022221212221111122222221", 1, 28},
+      {"0001201100012212000112102201212222222222222211122211111200110102", 1, -4},
+      {"2220211102112110222221222201120022212200022222002122210010210210", 1, 32},
+      {"0002220000222200000212012222221012122222112221201222111011111111", 1, 43},
+      {"0000100022201121112222200122222222121121121112200122222012021020", 1, 52},
+      {"0000221020022210202121112211122000212212211121211211120020211200", 2, 10},
+      {"0011100022222222221122202211122002121120122210121112100002101200", 2, -8},
+      {"1000120101012211121202021122222012222200222122220111120001111000", 1, 30},
+      {"1112222001112200101222000122220022222122211110200211122120100020", 1, 16},
+      {"0100100011122100112210101222222011211220111122211102022000201222", 1, -24},
+      {"0100010100112111002221011222111121112101021122110121111112000020", 1, -14},
+      {"2220000001111020011222201112222011121222101202201112201210020001", 1, 6},
+      {"0012022001111200011121102222112221121112011111120020110201200000", 1, -12},
+      {"0012101000122121011212220101222001121222102112220211010220100010", 1, -18},
+      {"0000000100000010211021012212202022222222212221112222221022222021", 1, -26},
+};
+
+// No time limit for the benchmark, one hour is "forever"
+#define BENCH_TIME_LIMIT_MS 3600000
+#define BENCH_TT_SIZE_LOG2 20
+
+static SimdLevel parseKernel(const std::string &name) {
+      if (name == "scalar") return SIMD_SCALAR;
+      if (name == "sse2") return SIMD_SSE2;
+      if (name == "avx2") return SIMD_AVX2;
+      return SIMD_AVX512;
+}
+
+int main(int argc, char *argv[]) {
+      int maxEmpties = 64;
+      SimdLevel maxLevel = SIMD_AVX512;
+
+      for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--max-empties" && i + 1 < argc) {
+                  maxEmpties = std::atoi(argv[++i]);
+            } else if (arg == "--kernel" && i + 1 < argc) {
+                  maxLevel = parseKernel(argv[++i]);
+            } else {
+                  std::cout << "[WARNING] Usage: " << argv[0]
+                            << " [--max-empties N] [--kernel scalar|sse2|avx2|avx512]" << std::endl;
+                  return 1;
+            }
+      }
+
+      initMoveKernels(maxLevel);
+
+      // Every position starts from an empty table, times do not depend on the order
+      TranspositionTable tt(BENCH_TT_SIZE_LOG2);
+      bool ok = true;
+      double totalSeconds = 0;
+      unsigned long long totalNodes = 0;
+      int index = 0;
+
+      for (const EndgamePosition &position : POSITIONS) {
+            index++;
+            Board board;
+            loadBoard(board, position.state);
+            if (board.empties > maxEmpties) continue;
+
+            tt.clear();
+            EndgameResult result = solveEndgame(board, position.player, BENCH_TIME_LIMIT_MS, nullptr, tt);
+            double nps = result.seconds > 0 ? result.nodes / result.seconds : 0;
+            totalSeconds += result.seconds;
+            totalNodes += result.nodes;
+
+            std::cout << "#" << std::left << std::setw(3) << index
+                      << " empties " << std::setw(3) << board.empties
+                      << " score " << std::right << std::setw(4) << result.score
+                      << std::setw(12) << result.nodes << " nodes "
+                      << std::fixed << std::setprecision(3) << std::setw(9) << result.seconds << " s "
+                      << std::setprecision(0) << std::setw(12) << nps << " nodes/s";
+
+            bool match = result.solved && result.score == position.score;
+            std::cout << (match ? "  OK" : "  MISMATCH (expected " + std::to_string(position.score) + ")") << std::endl;
+            if (!match) ok = false;
+      }
+
+      double totalNps = totalSeconds > 0 ? totalNodes / totalSeconds : 0;
+      std::cout << "total " << totalNodes << " nodes " << std::fixed << std::setprecision(3) << totalSeconds << " s "
+                << std::setprecision(0) << totalNps << " nodes/s" << std::endl;
+
+      if (!ok) {
+            std::cerr << "[ERROR] Endgame scores do not match the reference." << std::endl;
+            return 1;
+      }
+      return 0;
+}
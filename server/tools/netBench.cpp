@@ -0,0 +1,206 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <deque>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/**
+ * Network benchmark: keeps many clients busy with HEARTBEAT round trips
+ * against a running server and reports round trips/second and latency.
+ * Run it once per --io mode of the server to compare the backends
+ * (make net-bench does that for threads, epoll and uring).
+ *
+ * Every client keeps --pipeline heartbeats outstanding and sends the next
+ * one as soon as a HEARTPOP comes back. The load generator itself is a
+ * single epoll thread, so it stays cheap next to the server.
+ *
+ * Usage: netBench [--host IP] [--port N] [--clients N] [--seconds N] [--pipeline N]
+ * Exit code 1 when no client could connect.
+ */
+
+#define HEARTBEAT_MESSAGE "REV HEARTBEAT\n"
+#define HEARTPOP_MESSAGE "REV HEARTPOP"
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchClient {
+      int socket;
+      std::string buffer;
+      std::deque<Clock::time_point> sent;   // Send times of the outstanding heartbeats
+};
+
+static bool sendHeartbeats(BenchClient& client, int count) {
+      std::string batch;
+      for (int i = 0; i < count; i++) batch += HEARTBEAT_MESSAGE;
+
+      // Small writes to an idle socket, a short write would be a broken connection
+      ssize_t written = send(client.socket, batch.data(), batch.size(), MSG_NOSIGNAL);
+      if (written != (ssize_t)batch.size()) return false;
+
+      Clock::time_point now = Clock::now();
+      for (int i = 0; i < count; i++) client.sent.push_back(now);
+      return true;
+}
+
+static int connectClient(const std::string& host, int port) {
+      int clientSocket = socket(AF_INET, SOCK_STREAM, 0);
+      if (clientSocket < 0) return -1;
+
+      struct sockaddr_in address;
+      memset(&address, 0, sizeof(address));
+      address.sin_family = AF_INET;
+      address.sin_port = htons(port);
+      address.sin_addr.s_addr = inet_addr(host.c_str());
+
+      if (connect(clientSocket, (struct sockaddr*)&address, sizeof(address)) < 0) {
+            close(clientSocket);
+            return -1;
+      }
+
+      int one = 1;
+      setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK);
+      return clientSocket;
+}
+
+int main(int argc, char *argv[]) {
+      std::string host = "127.0.0.1";
+      int port = 10001;
+      int clientCount = 100;
+      int seconds = 5;
+      int pipeline = 1;
+
+      for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--host" && i + 1 < argc) {
+                  host = argv[++i];
+            } else if (arg == "--port" && i + 1 < argc) {
+                  port = std::atoi(argv[++i]);
+            } else if (arg == "--clients" && i + 1 < argc) {
+                  clientCount = std::atoi(argv[++i]);
+            } else if (arg == "--seconds" && i + 1 < argc) {
+                  seconds = std::atoi(argv[++i]);
+            } else if (arg == "--pipeline" && i + 1 < argc) {
+                  pipeline = std::atoi(argv[++i]);
+            } else {
+                  std::cout << "[WARNING] Usage: " << argv[0]
+                            << " [--host IP] [--port N] [--clients N] [--seconds N] [--pipeline N]" << std::endl;
+                  return 1;
+            }
+      }
+      if (clientCount < 1 || seconds < 1 || pipeline < 1) {
+            std::cout << "[WARNING] --clients, --seconds and --pipeline must be positive." << std::endl;
+            return 1;
+      }
+
+      struct rlimit limit;
+      if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+      }
+
+      int epollFd = epoll_create1(0);
+      std::vector<BenchClient> clients(clientCount);
+      int connected = 0;
+
+      for (int i = 0; i < clientCount; i++) {
+            clients[i].socket = connectClient(host, port);
+            if (clients[i].socket < 0) continue;
+            connected++;
+
+            struct epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.u32 = (uint32_t)i;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, clients[i].socket, &event);
+      }
+      if (connected == 0) {
+            std::cerr << "[ERROR] Could not connect to " << host << ":" << port << std::endl;
+            return 1;
+      }
+
+      for (BenchClient &client : clients) {
+            if (client.socket >= 0) sendHeartbeats(client, pipeline);
+      }
+
+      std::vector<double> latencies;   // Microseconds
+      latencies.reserve(1 << 20);
+      unsigned long long roundTrips = 0;
+      int failed = 0;
+
+      Clock::time_point start = Clock::now();
+      Clock::time_point end = start + std::chrono::seconds(seconds);
+      struct epoll_event events[256];
+      char chunk[4096];
+
+      while (Clock::now() < end) {
+            int count = epoll_wait(epollFd, events, 256, 100);
+            for (int e = 0; e < count; e++) {
+                  BenchClient &client = clients[events[e].data.u32];
+                  if (client.socket < 0) continue;
+
+                  ssize_t received = recv(client.socket, chunk, sizeof(chunk), 0);
+                  if (received <= 0) {
+                        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) continue;
+                        epoll_ctl(epollFd, EPOLL_CTL_DEL, client.socket, nullptr);
+                        close(client.socket);
+                        client.socket = -1;
+                        failed++;
+                        continue;
+                  }
+
+                  client.buffer.append(chunk, received);
+                  Clock::time_point now = Clock::now();
+                  int answered = 0;
+                  size_t pos = 0;
+                  while ((pos = client.buffer.find('\n')) != std::string::npos) {
+                        bool pop = client.buffer.compare(0, strlen(HEARTPOP_MESSAGE), HEARTPOP_MESSAGE) == 0;
+                        client.buffer.erase(0, pos + 1);
+                        if (!pop || client.sent.empty()) continue;
+
+                        latencies.push_back(std::chrono::duration<double, std::micro>(now - client.sent.front()).count());
+                        client.sent.pop_front();
+                        answered++;
+                  }
+
+                  roundTrips += answered;
+                  if (answered > 0 && !sendHeartbeats(client, answered)) {
+                        epoll_ctl(epollFd, EPOLL_CTL_DEL, client.socket, nullptr);
+                        close(client.socket);
+                        client.socket = -1;
+                        failed++;
+                  }
+            }
+      }
+
+      double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+      std::sort(latencies.begin(), latencies.end());
+      auto percentile = [&latencies](double p) {
+            return latencies.empty() ? 0.0 : latencies[(size_t)(p * (latencies.size() - 1))];
+      };
+
+      std::cout << std::fixed << std::setprecision(0)
+                << connected << " clients, pipeline " << pipeline << ": "
+                << roundTrips / elapsed << " round trips/s, latency p50 " << percentile(0.50)
+                << " us, p99 " << percentile(0.99) << " us, max " << percentile(1.0) << " us";
+      if (failed > 0) std::cout << ", " << failed << " connections lost";
+      std::cout << std::endl;
+
+      for (BenchClient &client : clients) {
+            if (client.socket >= 0) close(client.socket);
+      }
+      close(epollFd);
+      return 0;
+}
@@ -0,0 +1,159 @@
+#include "../include/messageParser.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Parser benchmark: tokenizes a mix of client messages with the in-place
+ * parser (parseMessage + parseInt) and with the former tokenizer
+ * (splitMessage + std::stoi + a chain of string compares), and reports
+ * messages/second and heap allocations per message for both.
+ *
+ * Both parsers have to agree on every word and number of the sample
+ * messages before anything is measured.
+ *
+ * Usage: parserBench [--iterations N]
+ * Exit code 1 when the parsers disagree.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+// Typical traffic: mostly heartbeats and moves, some lobby commands and garbage
+static const char *MESSAGES[] = {
+      "REV HEARTBEAT",
+      "REV MOVE 3 4 0",
+      "REV HEARTBEAT",
+      "REV MOVE 7 2 3",
+      "REV JOIN 2 8",
+      "REV CREATE player123",
+      "REV HEARTBEAT",
+      "REV MOVE 0 5 1",
+      "REV EXIT 4",
+      "REV REMATCH 1",
+      "REV BOT",
+      "REV MOVE x 4 0",
+      "HELLO WORLD",
+      "REV  MOVE   1\t2 3 ",
+};
+
+static unsigned long long allocations = 0;
+
+void* operator new(size_t size) {
+      allocations++;
+      void *pointer = std::malloc(size == 0 ? 1 : size);
+      if (pointer == nullptr) throw std::bad_alloc();
+      return pointer;
+}
+
+void operator delete(void *pointer) noexcept {
+      std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+      std::free(pointer);
+}
+
+// Former handler path: copy, istream split, string compares, stoi
+static int legacyParse(std::string_view line) {
+      std::vector<std::string> args = splitMessage(std::string(line));
+      if (args.size() < 2 || args[0] != "REV") return -1;
+
+      const std::string &command = args[1];
+      int sum = 0;
+      try {
+            if (command == "HEARTBEAT") sum = CMD_HEARTBEAT;
+            else if (command == "CREATE") sum = CMD_CREATE;
+            else if (command == "JOIN") sum = CMD_JOIN;
+            else if (command == "BOT") sum = CMD_BOT;
+            else if (command == "EXIT") sum = CMD_EXIT;
+            else if (command == "MOVE") sum = CMD_MOVE;
+            else if (command == "REMATCH") sum = CMD_REMATCH;
+            if (command != "CREATE") {
+                  for (size_t i = 2; i < args.size(); i++) sum += std::stoi(args[i]);
+            }
+      } catch (const std::exception&) {
+            return -2;
+      }
+      return sum;
+}
+
+static int inPlaceParse(std::string_view line) {
+      ParsedMessage parsed;
+      parseMessage(line, parsed);
+      if (parsed.tokenCount < 2 || parsed.arg(0) != "REV") return -1;
+
+      int sum = parsed.command;
+      if (parsed.command != CMD_CREATE) {
+            for (int i = 2; i < parsed.tokenCount; i++) {
+                  int value;
+                  if (!parseInt(parsed.arg(i), value)) return -2;
+                  sum += value;
+            }
+      }
+      return sum;
+}
+
+static bool parsersAgree() {
+      bool ok = true;
+      for (const char *message : MESSAGES) {
+            std::vector<std::string> words = splitMessage(message);
+            ParsedMessage parsed;
+            parseMessage(message, parsed);
+
+            bool same = (int)words.size() == parsed.tokenCount
+                        && legacyParse(message) == inPlaceParse(message);
+            for (size_t i = 0; same && i < words.size(); i++) same = words[i] == parsed.arg((int)i);
+            if (!same) {
+                  std::cout << "MISMATCH on \"" << message << "\"" << std::endl;
+                  ok = false;
+            }
+      }
+      return ok;
+}
+
+template <typename Parse>
+static void measure(const char *name, Parse parse, long iterations) {
+      const int count = sizeof(MESSAGES) / sizeof(MESSAGES[0]);
+      std::string_view lines[count];
+      for (int i = 0; i < count; i++) lines[i] = MESSAGES[i];
+
+      unsigned long long allocationsBefore = allocations;
+      long checksum = 0;
+      auto start = Clock::now();
+      for (long i = 0; i < iterations; i++) {
+            for (int j = 0; j < count; j++) checksum += parse(lines[j]);
+      }
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+      double messages = (double)iterations * count;
+      std::cout << std::left << std::setw(14) << name << std::right
+                << std::fixed << std::setprecision(1) << std::setw(8) << seconds * 1e9 / messages << " ns/msg "
+                << std::setprecision(0) << std::setw(12) << messages / seconds << " msg/s "
+                << std::setprecision(2) << std::setw(7) << (allocations - allocationsBefore) / messages << " allocs/msg"
+                << "  (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+      long iterations = 200000;
+
+      for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--iterations" && i + 1 < argc) {
+                  iterations = std::atol(argv[++i]);
+            } else {
+                  std::cout << "[WARNING] Usage: " << argv[0] << " [--iterations N]" << std::endl;
+                  return 1;
+            }
+      }
+
+      if (!parsersAgree()) return 1;
+
+      measure("splitMessage", legacyParse, iterations);
+      measure("parseMessage", inPlaceParse, iterations);
+      return 0;
+}
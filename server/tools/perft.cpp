@@ -0,0 +1,166 @@
+#include "../include/gameLogic.h"
+#include "../include/simdMoves.h"
+#include "../include/engine.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+/**
+ * Perft: counts the leaf nodes of the game tree to a fixed depth.
+ *
+ * Passes follow Lobby::validateAndApplyMove (resolveNextPlayer): a pass is
+ * not a ply, the same player simply moves again. A finished game before
+ * the requested depth counts as one leaf.
+ *
+ * Usage: perft [--depth N] [--position standard|custom|wide|all] [--kernel scalar|sse2|avx2|avx512]
+ * Without --depth every known count is verified (exit code 1 on mismatch),
+ * and a short search of each position has to return a legal move.
+ */
+
+struct PerftPosition {
+      const char *name;
+      const char *state;
+      const unsigned long long *expected; // expected[d - 1] = nodes at depth d
+      int knownDepth;
+};
+
+// Reference counts recorded with the original int board implementation
+static const unsigned long long STANDARD_NODES[] = {
+      4ULL, 12ULL, 56ULL, 244ULL, 1396ULL, 8200ULL, 55092ULL, 390216ULL, 3005320ULL
+};
+
+static const unsigned long long CUSTOM_NODES[] = {
+      9ULL, 66ULL, 497ULL, 3046ULL, 19037ULL, 99626ULL, 510583ULL, 2143672ULL,
+      8370155ULL, 25199358ULL, 63102702ULL, 106689647ULL
+};
+
+// 34 legal moves for player 1, more than most positions of a game
+#define WIDE_STATE "1000000020122202002110010002020002001220211021101220022100000000"
+
+static const unsigned long long WIDE_NODES[] = {
+      34ULL, 502ULL, 13732ULL, 183325ULL
+};
+
+static const PerftPosition POSITIONS[] = {
+      {"standard", STANDARD_START_STATE, STANDARD_NODES, 9},
+      {"custom", CUSTOM_START_STATE, CUSTOM_NODES, 12},
+      {"wide", WIDE_STATE, WIDE_NODES, 4},
+};
+
+#define SEARCH_CHECK_DEPTH 4
+#define SEARCH_CHECK_TT_SIZE_LOG2 16
+
+static unsigned long long perft(const Board &board, int player, int depth) {
+      if (depth == 0) return 1;
+
+      uint64_t moves = board.hints;
+      if (moves == 0) return 1;
+
+      unsigned long long nodes = 0;
+      while (moves) {
+            int square = __builtin_ctzll(moves);
+            moves &= moves - 1;
+
+            Board child = board;
+            processMove(square % 8, square / 8, child, player, true);
+
+            int nextPlayer = resolveNextPlayer(child, player);
+            if (nextPlayer == 0) {
+                  nodes += 1; // Game over, nobody can move
+            } else {
+                  nodes += perft(child, nextPlayer, depth - 1);
+            }
+      }
+      return nodes;
+}
+
+static bool runPosition(const PerftPosition &position, int depth, bool verify) {
+      Board board;
+      loadBoard(board, position.state);
+      getAvaiableMoves(board, 1);
+
+      bool ok = true;
+      for (int d = 1; d <= depth; d++) {
+            auto start = std::chrono::steady_clock::now();
+            unsigned long long nodes = perft(board, 1, d);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double nps = seconds > 0 ? nodes / seconds : 0;
+
+            std::cout << std::left << std::setw(9) << position.name
+                      << " depth " << std::setw(3) << d
+                      << std::right << std::setw(12) << nodes << " nodes "
+                      << std::fixed << std::setprecision(3) << std::setw(9) << seconds << " s "
+                      << std::setprecision(0) << std::setw(12) << nps << " nodes/s";
+
+            if (d <= position.knownDepth) {
+                  bool match = position.expected[d - 1] == nodes;
+                  std::cout << (match ? "  OK" : "  MISMATCH (expected " + std::to_string(position.expected[d - 1]) + ")");
+                  if (!match) ok = false;
+            }
+            std::cout << std::endl;
+
+            if (!ok && verify) break;
+      }
+      return ok;
+}
+
+static bool searchPosition(const PerftPosition &position) {
+      Board board;
+      loadBoard(board, position.state);
+      getAvaiableMoves(board, 1);
+
+      TranspositionTable tt(SEARCH_CHECK_TT_SIZE_LOG2);
+      SearchLimits limits = {60000, SEARCH_CHECK_DEPTH, 1, nullptr, -1};
+      SearchResult result = searchBestMove(board, 1, limits, tt);
+
+      bool legal = result.square >= 0 && ((board.hints >> result.square) & 1);
+      std::cout << std::left << std::setw(9) << position.name << " search depth " << result.depth
+                << " move " << result.square << (legal ? "  OK" : "  ILLEGAL") << std::endl;
+      return legal && result.depth == SEARCH_CHECK_DEPTH;
+}
+
+static SimdLevel parseKernel(const std::string &name) {
+      if (name == "scalar") return SIMD_SCALAR;
+      if (name == "sse2") return SIMD_SSE2;
+      if (name == "avx2") return SIMD_AVX2;
+      return SIMD_AVX512;
+}
+
+int main(int argc, char *argv[]) {
+      int depth = 0;
+      std::string positionName = "all";
+      SimdLevel maxLevel = SIMD_AVX512;
+
+      for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--depth" && i + 1 < argc) {
+                  depth = std::atoi(argv[++i]);
+            } else if (arg == "--position" && i + 1 < argc) {
+                  positionName = argv[++i];
+            } else if (arg == "--kernel" && i + 1 < argc) {
+                  maxLevel = parseKernel(argv[++i]);
+            } else {
+                  std::cout << "[WARNING] Usage: " << argv[0]
+                            << " [--depth N] [--position standard|custom|wide|all] [--kernel scalar|sse2|avx2|avx512]" << std::endl;
+                  return 1;
+            }
+      }
+
+      initMoveKernels(maxLevel);
+
+      bool ok = true;
+      for (const PerftPosition &position : POSITIONS) {
+            if (positionName != "all" && positionName != position.name) continue;
+            bool verify = (depth == 0);
+            ok = runPosition(position, verify ? position.knownDepth : depth, verify) && ok;
+            if (verify) ok = searchPosition(position) && ok;
+      }
+
+      if (!ok) {
+            std::cerr << "[ERROR] Perft node counts do not match the reference." << std::endl;
+            return 1;
+      }
+      return 0;
+}